@@ -131,6 +131,73 @@ Fonts end
 ******************************************************************************************/
 
 
+/*****************************************************************************************
+Glyph cache
+******************************************************************************************/
+
+// LRU cache of expanded RGB565 glyphs for opaque text, RAM budget in bytes
+// (SmallFont 192, BigFont 512, SevenSegNumFont 3200 bytes per glyph)
+//#define TFT_GLYPH_CACHE_BYTES	(2048)
+
+#ifdef TFT_GLYPH_CACHE_BYTES
+
+#ifndef TFT_GLYPH_CACHE_ENTRIES
+#define TFT_GLYPH_CACHE_ENTRIES	(16)	// max. number of cached glyphs
+#endif
+
+typedef struct
+{
+	uint32_t	hits;
+	uint32_t	misses;
+	uint32_t	evictions;
+	uint16_t	bytesUsed;
+} TFT_GLYPH_CACHE_STATS_t;
+
+extern void tftGlyphCacheClear(void);
+extern void tftGlyphCacheGetStats(TFT_GLYPH_CACHE_STATS_t *stats);
+
+#endif /* TFT_GLYPH_CACHE_BYTES */
+
+/*****************************************************************************************
+Glyph cache end
+******************************************************************************************/
+
+
+/*****************************************************************************************
+Framebuffer
+******************************************************************************************/
+
+// RAM framebuffer 160x128 RGB565 (40 KB): with tftFbEnable(1) all drawing functions render
+// into RAM and tftFbFlush() sends only the changed (dirty) regions to the panel
+//#define TFT_FRAMEBUFFER
+// palettized framebuffer 4 bpp (10 KB): colors are mapped to the nearest of 16 palette entries
+//#define TFT_FRAMEBUFFER_4BPP
+
+#if defined(TFT_FRAMEBUFFER_4BPP) && !defined(TFT_FRAMEBUFFER)
+#define TFT_FRAMEBUFFER
+#endif
+
+#ifdef TFT_FRAMEBUFFER
+
+#define TFT_FB_DIRTY_MAX	(8)		// dirty rectangles, more are merged
+#define TFT_FB_MERGE_SLACK	(32)	// pixels sent twice or unchanged are cheaper than a window setup
+
+extern void tftFbEnable(uint8_t on);
+extern void tftFbInvalidate(void);
+extern uint32_t tftFbFlush(void);
+#ifdef TFT_FRAMEBUFFER_4BPP
+extern void tftFbSetPalette(uint8_t index, uint16_t color);
+extern uint16_t tftFbGetPalette(uint8_t index);
+extern void tftFbLoadPalette(const uint16_t *colors);
+#endif
+
+#endif /* TFT_FRAMEBUFFER */
+
+/*****************************************************************************************
+Framebuffer end
+******************************************************************************************/
+
+
 // some flags for initR() :(
 #define INITR_GREENTAB 0x0
 #define INITR_REDTAB   0x1
@@ -159,6 +226,8 @@ Fonts end
 #define ST7735_RAMRD   0x2E
 
 #define ST7735_PTLAR   0x30
+#define ST7735_VSCRDEF 0x33
+#define ST7735_VSCRSADD 0x37
 #define ST7735_COLMOD  0x3A
 #define ST7735_MADCTL  0x36
 
@@ -225,6 +294,11 @@ extern uint8_t tftGetWidth(void);
 extern uint8_t tftGetHeight(void);
 
 extern void tftInvertDisplay(const uint8_t mode);
+// hardware scroll along the memory lines (vertical in PORTRAIT, horizontal in LANDSCAPE)
+extern uint16_t tftScrollLines(void);
+extern void tftScrollDefine(uint16_t tfa, uint16_t vsa, uint16_t bfa);
+extern void tftScrollTo(uint16_t vsp);
+extern void tftScrollLineWindow(uint16_t line, uint8_t from, uint8_t to);
 extern void tftSetRotation(uint8_t m);
 extern void tftFillScreen(uint16_t color);
 // Pass 8-bit (each) R,G,B, get back 16-bit packed color
@@ -236,6 +310,11 @@ extern void tftDrawPixel(int16_t x, int16_t y, uint16_t color);
 extern void tftDrawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
 extern void tftSetAddrWindow(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1);
 extern void tftPushColor(uint16_t color); // CAUTION!! can't be used separately
+// pixel stream into the address window by DMA: the buffer of tftStreamPush() must stay
+// unchanged until the next tftStreamPush() or tftStreamEnd()
+extern void tftStreamBegin(void);
+extern void tftStreamPush(const uint16_t *pix, uint16_t num);
+extern void tftStreamEnd(void);
 extern void tftDrawFastLine(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint16_t color);
 extern void tftDrawRect(uint8_t x1,uint8_t y1,uint8_t x2,uint8_t y2, uint16_t color);
 extern void tftDrawCircle(int16_t x, int16_t y, int radius, uint16_t color);
@@ -244,6 +323,8 @@ extern void tftDrawBitmap(int x, int y, int sx, int sy, bitmapdatatype data, int
 extern void tftDrawBitmapRotate(int x, int y, int sx, int sy, bitmapdatatype data, int deg, int rox, int roy);
 extern void tftSetFont(uint8_t* font);
 extern void tftSetColor(uint16_t FontColor, uint16_t BackColor);
+extern void tftSetTransparent(uint8_t on);
+extern void tftPrintChar(uint8_t charval, int x, int y);
 
 extern void tftPrintInt(int value,int x, int y, int deg);
 extern void tftPrintLong(long value,int x, int y, int deg);
@@ -251,4 +332,95 @@ extern void tftPrintFloat(float value,int x, int y, int deg);
 extern void tftPrintDouble(double value,int x, int y, int deg);
 extern void tftPrint(char *st, int x, int y, int deg);
 extern void tftPrintColor(char *st, int x, int y, uint16_t FontColor);
+
+
+/*****************************************************************************************
+Display context
+******************************************************************************************/
+
+/**
+* @brief state of one ST7735 panel, a further panel on its own SPI and pins, e.g. SPI1 and
+* SPI2, gets its own context and is driven with the st7735... functions; the tft... functions
+* above use the context of the default display (IOspiInit(), tftInitR()).
+* Framebuffer, band, scope, queue and widgets work on the default display only.
+*
+* winCol, winRow hold the address window last sent to the panel, a window with the same
+* columns or rows skips CASET or RASET (5 bytes each).
+*/
+typedef struct
+{
+	uint8_t 	*font;
+	uint8_t 	x_size;
+	uint8_t 	y_size;
+	uint8_t		offset;
+	uint16_t	numchars;
+} TFT_FONT_t;
+
+typedef struct
+{
+	ST7735io_t		*io;			//! pins and SPI of the panel
+	SPI_TypeDef		*spi;
+	uint16_t		width;			//! depends on the rotation
+	uint16_t		height;
+	uint8_t			colstart;		//! RAM offsets of the panel type
+	uint8_t			rowstart;
+	uint8_t			orientation;
+	uint8_t			transparent;
+	TFT_FONT_t		font;
+	uint16_t		fg;
+	uint16_t		bg;
+	uint16_t		winCol[2];		//! cached address window (RAM addresses)
+	uint16_t		winRow[2];
+	uint8_t			winValid;		//! winCol, winRow match the panel
+} ST7735_t;
+
+extern ST7735_t *tftGetDisplay(void);
+extern void st7735Init(ST7735_t *tft, ST7735io_t *io, uint8_t options);
+extern void st7735IoInit(ST7735_t *tft, ST7735io_t *TFTset);
+extern void st7735InitR(ST7735_t *tft, uint8_t options);
+extern void st7735SPISenddata(ST7735_t *tft, const uint8_t data);
+extern void st7735SPISenddata16(ST7735_t *tft, const uint16_t data);
+extern void st7735SendCmd(ST7735_t *tft, const uint8_t cmd);
+extern void st7735SendData(ST7735_t *tft, const uint8_t data);
+extern uint8_t st7735GetWidth(ST7735_t *tft);
+extern uint8_t st7735GetHeight(ST7735_t *tft);
+extern void st7735On(ST7735_t *tft);
+extern void st7735Off(ST7735_t *tft);
+extern void st7735InvertDisplay(ST7735_t *tft, const uint8_t mode);
+extern void st7735SetRotation(ST7735_t *tft, uint8_t m);
+extern uint16_t st7735ScrollLines(ST7735_t *tft);
+extern void st7735ScrollDefine(ST7735_t *tft, uint16_t tfa, uint16_t vsa, uint16_t bfa);
+extern void st7735ScrollTo(ST7735_t *tft, uint16_t vsp);
+extern void st7735ScrollLineWindow(ST7735_t *tft, uint16_t line, uint8_t from, uint8_t to);
+extern void st7735FillScreen(ST7735_t *tft, uint16_t color);
+extern void st7735FillRect(ST7735_t *tft, int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+extern void st7735DrawFastHLine(ST7735_t *tft, int16_t x, int16_t y, int16_t w, uint16_t color);
+extern void st7735DrawPixel(ST7735_t *tft, int16_t x, int16_t y, uint16_t color);
+extern void st7735DrawFastVLine(ST7735_t *tft, int16_t x, int16_t y, int16_t h, uint16_t color);
+extern void st7735SetAddrWindow(ST7735_t *tft, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1);
+extern void st7735PushColor(ST7735_t *tft, uint16_t color);
+extern void st7735StreamBegin(ST7735_t *tft);
+extern void st7735StreamPush(ST7735_t *tft, const uint16_t *pix, uint16_t num);
+extern void st7735StreamEnd(ST7735_t *tft);
+extern void st7735DrawFastLine(ST7735_t *tft, uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint16_t color);
+extern void st7735DrawRect(ST7735_t *tft, uint8_t x1,uint8_t y1,uint8_t x2,uint8_t y2, uint16_t color);
+extern void st7735DrawCircle(ST7735_t *tft, int16_t x, int16_t y, int radius, uint16_t color);
+extern void st7735FillCircle(ST7735_t *tft, int16_t x, int16_t y, int radius, uint16_t color);
+extern void st7735DrawBitmap(ST7735_t *tft, int x, int y, int sx, int sy, bitmapdatatype data, int scale);
+extern void st7735DrawBitmapRotate(ST7735_t *tft, int x, int y, int sx, int sy, bitmapdatatype data, int deg, int rox, int roy);
+extern void st7735SetFont(ST7735_t *tft, uint8_t* font);
+extern void st7735SetColor(ST7735_t *tft, uint16_t FontColor, uint16_t BackColor);
+extern void st7735SetTransparent(ST7735_t *tft, uint8_t on);
+extern void st7735PrintChar(ST7735_t *tft, uint8_t charval, int x, int y);
+extern void st7735RotateChar(ST7735_t *tft, uint8_t charval, int x, int y, int pos, int deg);
+extern void st7735PrintInt(ST7735_t *tft, int value,int x, int y, int deg);
+extern void st7735PrintLong(ST7735_t *tft, long value,int x, int y, int deg);
+extern void st7735PrintFloat(ST7735_t *tft, float value,int x, int y, int deg);
+extern void st7735PrintDouble(ST7735_t *tft, double value,int x, int y, int deg);
+extern void st7735Print(ST7735_t *tft, char *st, int x, int y, int deg);
+extern void st7735PrintColor(ST7735_t *tft, char *st, int x, int y, uint16_t FontColor);
+
+/*****************************************************************************************
+Display context end
+******************************************************************************************/
 #endif
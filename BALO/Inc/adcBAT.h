@@ -39,6 +39,7 @@ extern BatStat_t getBatVolt(analogCh_t* pADChn);
 extern uint16_t AlBeOszi(float *AlphaBeta);
 
 extern uint8_t I2C_SCAN(I2C_TypeDef *i2c, uint8_t scanAddr);
+extern void I2C_SCAN_SHOW(I2C_TypeDef *i2c, uint8_t scanAddr, uint8_t foundAddr);
 extern uint8_t *convDecByteToHex(uint8_t byte);
 
 // Tiefpassfilterung der drei Richtungsvektoren xyz
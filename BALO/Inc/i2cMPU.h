@@ -11,6 +11,8 @@
 #ifndef I2CMPU_H_
 #define I2CMPU_H_
 
+#include <i2cShadow.h>
+
 //********** Defines for Preset Values **********
 
 #define _pi 3.141592
@@ -136,6 +138,11 @@ typedef struct MPU6050 {
     float pitch;
     float pitchAccel;
     float roll;
+    I2C_SHADOW_t cfgShadow;		// CONFIG, GYRO_CONFIG, ACCEL_CONFIG
+    I2C_SHADOW_t pwrShadow;		// PWR_MGMT_1, PWR_MGMT_2
+    I2C_TRANSFER_t tempXfer;		// Queued temperature read, see mpuPollTemp()
+    uint8_t tempReg;
+    uint8_t tempBuf[2];
 
 } MPU6050_t;
 
@@ -167,6 +174,7 @@ extern int16_t mpuGetGyro(MPU6050_t* sensor);
 
 extern float mpuGetTemp(MPU6050_t* sensor);
 extern float mpuTemp(MPU6050_t* sensor);
+extern float mpuPollTemp(MPU6050_t* sensor, I2C_PRIO_t prio);
 
 void mpuSetLpFilt(MPU6050_t* sensor);
 
@@ -0,0 +1,46 @@
+/*
+ * i2cSched.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: T Flaemig
+ *
+ *  Cycle based scheduler for I2C1 and I2C2: the jobs of both buses run concurrently,
+ *  the jobs of one bus are chained by the completion interrupt. A job whose bus does not become
+ *  idle within a few us in the interrupt is started by polling i2cSchedCycleDone()/i2cSchedWaitCycle().
+ */
+
+#ifndef I2CSCHED_H_
+#define I2CSCHED_H_
+
+#include <mcalI2C.h>
+
+#define I2C_SCHED_MAX_JOBS      8
+
+// Bus mask of a job: on which bus(es) the device can be reached
+#define I2C_SCHED_BUS1          0b01
+#define I2C_SCHED_BUS2          0b10
+
+typedef struct
+{
+	I2C_TypeDef     *i2c;           // Assigned bus
+	uint8_t          busMask;       // I2C_SCHED_BUS1 | I2C_SCHED_BUS2
+	bool             enabled;
+	I2C_TRANSFER_t   xfer;          // Executed once per cycle
+} I2C_SCHED_JOB_t;
+
+
+extern void              i2cSchedInit(void);
+extern int8_t            i2cSchedAddJob(I2C_TypeDef *i2c, uint8_t busMask, const I2C_SEGMENT_t *segments, uint8_t numSegments, bool useDma);
+extern void              i2cSchedEnableJob(int8_t job, bool enable);
+extern I2C_RETURN_CODE_t i2cSchedJobResult(int8_t job);
+extern I2C_TypeDef      *i2cSchedJobBus(int8_t job);
+
+extern I2C_RETURN_CODE_t i2cSchedStartCycle(void);
+extern bool              i2cSchedCycleDone(void);
+extern I2C_RETURN_CODE_t i2cSchedWaitCycle(void);
+
+extern uint32_t          i2cSchedBusTimeUs(I2C_TypeDef *i2c);
+extern void              i2cSchedPlaceDevices(void);
+
+
+#endif /* I2CSCHED_H_ */
@@ -0,0 +1,49 @@
+/*
+ * i2cShadow.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: T Flaemig
+ *
+ *  Register shadow of I2C slave configuration registers: writes of unchanged values are
+ *  suppressed, adjacent changed registers are merged into one auto-increment burst.
+ */
+
+#ifndef I2CSHADOW_H_
+#define I2CSHADOW_H_
+
+#include <mcalI2C.h>
+
+#ifndef I2C_SHADOW_MAX_REGS
+#define I2C_SHADOW_MAX_REGS     8       // max. 32
+#endif
+
+typedef enum
+{
+	I2C_SHADOW_REGS = 0,                // Register device with auto-increment, e.g. MPU6050
+	I2C_SHADOW_BLOCK                    // Command with fixed payload, e.g. AMIS SetMotorParam: sent as a whole
+} I2C_SHADOW_MODE_t;
+
+typedef struct
+{
+	I2C_TypeDef       *i2c;
+	uint8_t            saddr;
+	uint8_t            base;            // First register (I2C_SHADOW_REGS) or command code (I2C_SHADOW_BLOCK)
+	uint8_t            size;            // Number of shadowed registers / payload bytes
+	I2C_SHADOW_MODE_t  mode;
+	uint32_t           valid;           // Bit n: cache[n] equals the slave
+	uint32_t           dirty;           // Bit n: cache[n] has to be written
+	uint16_t           written;         // Statistics: data bytes sent
+	uint16_t           saved;           // Statistics: data bytes suppressed
+	uint8_t            cache[I2C_SHADOW_MAX_REGS];
+} I2C_SHADOW_t;
+
+
+extern void              i2cShadowInit(I2C_SHADOW_t *sh, I2C_TypeDef *i2c, uint8_t saddr, uint8_t base, uint8_t size, I2C_SHADOW_MODE_t mode);
+extern void              i2cShadowInvalidate(I2C_SHADOW_t *sh);
+extern bool              i2cShadowSet(I2C_SHADOW_t *sh, uint8_t reg, uint8_t value);
+extern I2C_RETURN_CODE_t i2cShadowFlush(I2C_SHADOW_t *sh);
+extern I2C_RETURN_CODE_t i2cShadowWrite(I2C_SHADOW_t *sh, uint8_t reg, uint8_t value);
+extern I2C_RETURN_CODE_t i2cShadowWriteBlock(I2C_SHADOW_t *sh, uint8_t reg, const uint8_t *data, uint8_t len);
+
+
+#endif /* I2CSHADOW_H_ */
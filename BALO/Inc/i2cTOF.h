@@ -72,6 +72,7 @@
 
 // include standard libraries
 #include <stdbool.h>
+#include <mcalI2C.h>
 
 // Register defines for communication with the TOF sensor (according to the API)
 #define TOF_REG_SYSRANGE_START                               (0x00)  // Trigger start of range measurement
@@ -771,6 +772,29 @@ extern bool TOF_start_up_task(TOFSensor_t* TOFSENS);
 extern bool TOF_read_distance_task(TOFSensor_t* TOFSENS);
 
 
+/**
+ * @function:    TOF_read_distance_queued
+ *
+ * @brief:       Non-blocking variant of TOF_read_distance_task() for the shared I2C bus.
+ *
+ * @details:     Every bus access (status, result, interrupt clear and each register write of the restart
+ *               sequence) is a separate transfer queued with the given priority (see i2cQueueTransfer).
+ *               Transfers of the control loop are started in between, so the sequence never delays the
+ *               next control cycle by more than one short transaction. One call advances the sequence
+ *               by one step; call it periodically, e.g. in the display task.
+ *
+ * @param[in]:   TOFSENS
+ * 					- TOF_address_used          			The sensor's I2C address (e.g., 0x29 for VL53LOX)
+ *					- distanceFromTOF           			The current distance measurement (in mm)
+ *					- TOF_measuringage  		  			Age of the measured distance
+ *				prio										Bus priority, e.g. I2C_PRIO_TELEMETRY
+ *
+ * @returns:     bool: true if a status poll or a new measurement has been completed (same as TOF_read_distance_task),
+ *               false while transfers are pending or after an I2C error.
+ */
+extern bool TOF_read_distance_queued(TOFSensor_t* TOFSENS, I2C_PRIO_t prio);
+
+
 /**
  * @function:    TOF_set_address
  *
@@ -0,0 +1,52 @@
+/*
+ * tftBand.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: T Flaemig
+ *
+ *  Band renderer for the ST7735 without framebuffer: the primitives of a frame are recorded
+ *  in a display list, tftBandRender() rasterizes the list band by band into two small
+ *  buffers and streams them by DMA, one band is sent while the next one is drawn.
+ *  RAM: 2 * TFT_BAND_LINES * 160 * 2 bytes + display list (default approx. 4 KB).
+ */
+
+#ifndef TFTBAND_H_
+#define TFTBAND_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <ST7735.h>
+
+#ifndef TFT_BAND_LINES
+#define TFT_BAND_LINES		4		// lines per band
+#endif
+#ifndef TFT_BAND_LIST_MAX
+#define TFT_BAND_LIST_MAX	48		// primitives per frame
+#endif
+#ifndef TFT_BAND_TEXT_POOL
+#define TFT_BAND_TEXT_POOL	256		// characters of all texts per frame
+#endif
+
+typedef enum
+{
+	TFT_BAND_OK			=  0,
+	TFT_BAND_LIST_FULL	= -1,		// primitive not recorded
+	TFT_BAND_POOL_FULL	= -2		// text not recorded
+} TFT_BAND_RETURN_CODE_t;
+
+
+extern void tftBandBegin(uint16_t background);
+extern TFT_BAND_RETURN_CODE_t tftBandFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+extern TFT_BAND_RETURN_CODE_t tftBandDrawPixel(int16_t x, int16_t y, uint16_t color);
+extern TFT_BAND_RETURN_CODE_t tftBandDrawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+extern TFT_BAND_RETURN_CODE_t tftBandDrawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+extern TFT_BAND_RETURN_CODE_t tftBandDrawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+extern TFT_BAND_RETURN_CODE_t tftBandDrawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+extern TFT_BAND_RETURN_CODE_t tftBandDrawCircle(int16_t x, int16_t y, int16_t radius, uint16_t color);
+extern TFT_BAND_RETURN_CODE_t tftBandFillCircle(int16_t x, int16_t y, int16_t radius, uint16_t color);
+extern TFT_BAND_RETURN_CODE_t tftBandPrint(const char *st, int16_t x, int16_t y, const uint8_t *font, uint16_t fg, uint16_t bg);
+extern TFT_BAND_RETURN_CODE_t tftBandPrintTransparent(const char *st, int16_t x, int16_t y, const uint8_t *font, uint16_t fg);
+extern TFT_BAND_RETURN_CODE_t tftBandDrawBitmap(int16_t x, int16_t y, int16_t sx, int16_t sy, const uint16_t *data);
+extern void tftBandRender(void);
+
+#endif /* TFTBAND_H_ */
@@ -0,0 +1,62 @@
+/*
+ * tftImage.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: T Flaemig
+ *
+ *  Compressed images for the ST7735, created on the PC with BALO/tools/tftImageEnc.c.
+ *  The decoder expands the image row by row into two line buffers, one is sent by DMA
+ *  while the next rows are decoded, so the image goes to the panel in one address window
+ *  without an RGB565 copy in flash or RAM.
+ *
+ *  Layout (multi-byte values little endian):
+ *  0  'T' 'I'         magic
+ *  2  format          TFT_IMG_FORMAT_t
+ *  3  bpp             bits per index (1, 2, 4, 8) for TFT_IMG_PAL, else 0
+ *  4  width, height   uint16_t each
+ *  8  colors          palette entries (TFT_IMG_PAL, TFT_IMG_PAL_RLE), uint16_t
+ *  10 palette         colors * RGB565
+ *  .. data
+ *
+ *  TFT_IMG_RAW:     RGB565 pixels
+ *  TFT_IMG_RLE:     control byte c, c < 0x80: c + 1 literal RGB565 pixels follow,
+ *                   c >= 0x80: the following RGB565 pixel repeats (c & 0x7F) + 1 times
+ *  TFT_IMG_PAL:     palette indices with bpp bits, left pixel in the high bits, no row padding
+ *  TFT_IMG_PAL_RLE: as TFT_IMG_RLE with one byte palette indices instead of pixels
+ *  TFT_IMG_QOI:     QOI stream ("qoif" header ... end marker), needs TFT_IMAGE_QOI
+ */
+
+#ifndef TFTIMAGE_H_
+#define TFTIMAGE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <ST7735.h>
+
+// QOI decoder (about 1 KB code, 256 bytes RAM)
+//#define TFT_IMAGE_QOI
+
+#define TFT_IMG_HEADER		(10)		// bytes in front of the palette
+
+typedef enum
+{
+	TFT_IMG_RAW			= 0,
+	TFT_IMG_RLE			= 1,
+	TFT_IMG_PAL			= 2,
+	TFT_IMG_PAL_RLE		= 3,
+	TFT_IMG_QOI			= 4
+} TFT_IMG_FORMAT_t;
+
+typedef enum
+{
+	TFT_IMG_OK			=  0,
+	TFT_IMG_BAD_FORMAT	= -1,		// no image, unknown or disabled format
+	TFT_IMG_BAD_SIZE	= -2		// outside the screen
+} TFT_IMG_RETURN_CODE_t;
+
+
+extern TFT_IMG_RETURN_CODE_t tftImageSize(const uint8_t *img, uint16_t *w, uint16_t *h);
+extern TFT_IMG_RETURN_CODE_t tftDrawImage(int16_t x, int16_t y, const uint8_t *img);
+extern TFT_IMG_RETURN_CODE_t st7735DrawImage(ST7735_t *tft, int16_t x, int16_t y, const uint8_t *img);
+
+#endif /* TFTIMAGE_H_ */
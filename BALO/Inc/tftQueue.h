@@ -0,0 +1,64 @@
+/*
+ * tftQueue.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: T Flaemig
+ *
+ *  Deferred display commands for the ST7735: the tftQueue... functions only record the
+ *  command with a copy of its arguments (texts included) in a ring buffer, tftQueueDrain()
+ *  executes as many of them as fit into a time slice, e.g. the rest of a control cycle.
+ *  A rectangle at the same place as a pending one replaces it, as does a text at the same
+ *  place which covers the pending text (not shorter, same length if centered or right aligned),
+ *  as long as no later pending command overlaps the region (the result on screen is the same).
+ *  Fills larger than the time slice are drawn in bands of rows across several drains.
+ */
+
+#ifndef TFTQUEUE_H_
+#define TFTQUEUE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <ST7735.h>
+
+#ifndef TFT_QUEUE_LEN
+#define TFT_QUEUE_LEN		16		// pending commands
+#endif
+#ifndef TFT_QUEUE_TEXT
+#define TFT_QUEUE_TEXT		24		// characters per text command
+#endif
+
+typedef enum
+{
+	TFT_QUEUE_OK		=  0,
+	TFT_QUEUE_FULL		= -1,		// command not recorded
+	TFT_QUEUE_TEXT_LONG	= -2		// text not recorded
+} TFT_QUEUE_RETURN_CODE_t;
+
+typedef struct
+{
+	uint32_t	queued;
+	uint32_t	coalesced;			// replaced a pending command
+	uint32_t	executed;
+	uint32_t	dropped;			// queue full
+	uint32_t	forced;				// over the budget: one row of a fill, or another command longer than the whole budget
+	uint32_t	bands;				// fills drawn partly, the rest in the next drain
+	uint32_t	cyclesPerPixel;		// learned cost, used for the budget
+} TFT_QUEUE_STATS_t;
+
+
+extern void tftQueueInit(void);
+extern TFT_QUEUE_RETURN_CODE_t tftQueueFillScreen(uint16_t color);
+extern TFT_QUEUE_RETURN_CODE_t tftQueueFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+extern TFT_QUEUE_RETURN_CODE_t tftQueueDrawPixel(int16_t x, int16_t y, uint16_t color);
+extern TFT_QUEUE_RETURN_CODE_t tftQueueDrawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+extern TFT_QUEUE_RETURN_CODE_t tftQueueDrawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+extern TFT_QUEUE_RETURN_CODE_t tftQueueDrawLine(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint16_t color);
+extern TFT_QUEUE_RETURN_CODE_t tftQueueDrawRect(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint16_t color);
+extern TFT_QUEUE_RETURN_CODE_t tftQueueDrawCircle(int16_t x, int16_t y, int16_t radius, uint16_t color);
+extern TFT_QUEUE_RETURN_CODE_t tftQueueFillCircle(int16_t x, int16_t y, int16_t radius, uint16_t color);
+extern TFT_QUEUE_RETURN_CODE_t tftQueuePrint(const char *st, int16_t x, int16_t y, const uint8_t *font, uint16_t fg, uint16_t bg);
+extern uint8_t tftQueueDrain(uint32_t budgetUs);
+extern uint8_t tftQueuePending(void);
+extern void tftQueueGetStats(TFT_QUEUE_STATS_t *stats);
+
+#endif /* TFTQUEUE_H_ */
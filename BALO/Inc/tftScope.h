@@ -0,0 +1,70 @@
+/*
+ * tftScope.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: T Flaemig
+ *
+ *  Strip chart (roll mode oscilloscope) with the hardware scroll of the ST7735: every new
+ *  time column is written as one address window on the memory line that leaves the screen,
+ *  then the scroll position advances by one line. The rest of the plot is not touched.
+ *  In LANDSCAPE the time axis is horizontal. The whole screen scrolls, texts within the
+ *  scroll direction move with the plot. Framebuffer has to be off.
+ *
+ *  With more samples than columns (decimation > 1) every column shows the min/max
+ *  envelope of its samples per channel, so short peaks stay visible.
+ */
+
+#ifndef TFTSCOPE_H_
+#define TFTSCOPE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <ST7735.h>
+
+#ifndef TFT_SCOPE_CHANNELS
+#define TFT_SCOPE_CHANNELS	4		// max. channels per scope
+#endif
+#define TFT_SCOPE_GRID_T	20		// columns between vertical grid lines, 0 = none
+#define TFT_SCOPE_GRID_Y	4		// horizontal grid divisions, 0 = none
+
+typedef enum
+{
+	TFT_SCOPE_OK			=  0,
+	TFT_SCOPE_CHANNEL		= -1,		// channel number too high
+	TFT_SCOPE_RANGE			= -2		// hi <= lo, size < 2 or outside the screen
+} TFT_SCOPE_RETURN_CODE_t;
+
+typedef struct
+{
+	uint16_t	color;
+	int16_t		min;				// envelope of the current column
+	int16_t		max;
+	int16_t		prevMin;			// envelope of the previous column
+	int16_t		prevMax;
+	bool		active;
+	bool		valid;				// previous column exists
+} TFT_SCOPE_CH_t;
+
+typedef struct
+{
+	uint8_t			pos;			// first pixel across the time axis (y in LANDSCAPE)
+	uint8_t			size;			// pixels across the time axis
+	int16_t			lo;				// value at pos + size - 1
+	int16_t			hi;				// value at pos
+	uint16_t		decim;			// samples per column
+	uint16_t		count;			// samples in the current column
+	uint16_t		line;			// memory line of the next column
+	uint16_t		column;			// columns since start, for the grid
+	uint16_t		bg;
+	uint16_t		grid;
+	TFT_SCOPE_CH_t	ch[TFT_SCOPE_CHANNELS];
+} TFT_SCOPE_t;
+
+
+extern TFT_SCOPE_RETURN_CODE_t tftScopeInit(TFT_SCOPE_t *scope, uint8_t pos, uint8_t size, int16_t lo, int16_t hi,
+											uint16_t decim, uint16_t bg, uint16_t grid);
+extern TFT_SCOPE_RETURN_CODE_t tftScopeSetChannel(TFT_SCOPE_t *scope, uint8_t ch, uint16_t color);
+extern bool tftScopeAddSample(TFT_SCOPE_t *scope, const int16_t *values);
+extern void tftScopeStop(TFT_SCOPE_t *scope);
+
+#endif /* TFTSCOPE_H_ */
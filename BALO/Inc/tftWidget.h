@@ -0,0 +1,97 @@
+/*
+ * tftWidget.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: T Flaemig
+ *
+ *  Retained widgets for the ST7735: every widget keeps the state it has drawn last, the Set
+ *  functions only redraw what differs (changed characters, the changed part of a bar, two
+ *  menu cells, the changed rows of an icon). The first Set after Init draws the whole widget,
+ *  after clearing the screen the widgets have to be initialized again.
+ *
+ *  Every Set function returns its cost in bus bytes (pixel data + 11 bytes per address
+ *  window), 0 if nothing changed. At SPI CLK_DIV_16 (5.25 MBit/s) one byte takes 1.5 us.
+ */
+
+#ifndef TFTWIDGET_H_
+#define TFTWIDGET_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <ST7735.h>
+
+#ifndef TFT_WIDGET_TEXT
+#define TFT_WIDGET_TEXT		20		// max. characters of a label
+#endif
+#define TFT_MENU_GAP		2		// pixels between menu cells
+
+typedef struct
+{
+	uint32_t	pixels;
+	uint32_t	windows;
+	uint32_t	bytes;
+} TFT_WIDGET_COST_t;
+
+typedef struct
+{
+	int16_t			x, y;
+	const uint8_t	*font;
+	uint16_t		fg, bg;
+	uint8_t			len;						// field width in characters
+	bool			valid;						// text is on the screen
+	char			text[TFT_WIDGET_TEXT + 1];	// as drawn
+} TFT_LABEL_t;
+
+typedef struct
+{
+	TFT_LABEL_t		label;
+	uint8_t			decimals;
+} TFT_NUMBER_t;
+
+typedef struct
+{
+	int16_t			x, y, w, h;
+	uint16_t		fg, bg, frame;
+	int32_t			min, max;
+	int16_t			fill;						// filled pixels as drawn, -1 = not drawn
+} TFT_BAR_t;
+
+typedef struct
+{
+	int16_t				x, y;
+	const char * const	*items;
+	uint8_t				num;
+	uint8_t				cols;
+	uint8_t				chars;					// characters per cell
+	const uint8_t		*font;
+	uint16_t			fg, bg, selFg, selBg;
+	int16_t				sel;					// selected cell as drawn, -1 = not drawn, -2 = none
+} TFT_MENU_t;
+
+typedef struct
+{
+	int16_t					x, y, w, h;
+	const uint16_t * const	*images;			// RGB565, w * h pixels per state
+	uint8_t					states;
+	int16_t					state;				// as drawn, -1 = not drawn
+} TFT_ICON_t;
+
+
+extern void tftLabelInit(TFT_LABEL_t *lbl, int16_t x, int16_t y, const uint8_t *font, uint16_t fg, uint16_t bg, uint8_t len);
+extern uint32_t tftLabelSet(TFT_LABEL_t *lbl, const char *text);
+extern void tftNumberInit(TFT_NUMBER_t *num, int16_t x, int16_t y, const uint8_t *font, uint16_t fg, uint16_t bg,
+						  uint8_t len, uint8_t decimals);
+extern uint32_t tftNumberSet(TFT_NUMBER_t *num, int32_t value);
+extern void tftBarInit(TFT_BAR_t *bar, int16_t x, int16_t y, int16_t w, int16_t h, int32_t min, int32_t max,
+					   uint16_t fg, uint16_t bg, uint16_t frame);
+extern uint32_t tftBarSet(TFT_BAR_t *bar, int32_t value);
+extern void tftMenuInit(TFT_MENU_t *menu, int16_t x, int16_t y, const char * const *items, uint8_t num, uint8_t cols,
+						uint8_t chars, const uint8_t *font, uint16_t fg, uint16_t bg, uint16_t selFg, uint16_t selBg);
+extern uint32_t tftMenuSelect(TFT_MENU_t *menu, int16_t sel);
+extern void tftIconInit(TFT_ICON_t *icon, int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t * const *images,
+						uint8_t states);
+extern uint32_t tftIconSet(TFT_ICON_t *icon, uint8_t state);
+extern void tftWidgetGetCost(TFT_WIDGET_COST_t *cost);
+extern void tftWidgetResetCost(void);
+
+#endif /* TFTWIDGET_H_ */
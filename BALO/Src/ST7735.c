@@ -45,45 +45,50 @@
 #include <mcalGPIO.h>
 #include <mcalSPI.h>
 
-static uint16_t width = ST7735_TFTWIDTH;
-static uint16_t height = ST7735_TFTHEIGHT;
+/*
+ * display used by the tft... functions, further displays have their own ST7735_t and are
+ * driven with the st7735... functions
+ */
+static ST7735_t tftDefault =
+{
+	.width       = ST7735_TFTWIDTH,
+	.height      = ST7735_TFTHEIGHT,
+	.orientation = PORTRAIT,
+	.fg          = tft_GREEN,
+	.bg          = tft_BLACK,
+	.winValid    = 0
+};
 
 /*****************************************************************************************
 Hardware Configuration
 ******************************************************************************************/
-/**
- * @brief define prototype structure for the ST7735 Piggyback IO Interface
- *
- */
-static ST7735io_t *TFT ;
-static SPI_TypeDef  *spi ;
 
-void _DC1(void)
+static inline void _DC1(ST7735_t *tft)
 {
-	gpioSetPin(TFT->DC_PORT, TFT->DC);
+	gpioSetPin(tft->io->DC_PORT, tft->io->DC);
 }
-void _DC0(void)
+static inline void _DC0(ST7735_t *tft)
 {
-	gpioResetPin(TFT->DC_PORT, TFT->DC);
+	gpioResetPin(tft->io->DC_PORT, tft->io->DC);
 }
 
-void _RST1(void)
+static inline void _RST1(ST7735_t *tft)
 {
-	gpioSetPin(TFT->RST_PORT, TFT->RST);
+	gpioSetPin(tft->io->RST_PORT, tft->io->RST);
 }
 
-void _RST0(void)
+static inline void _RST0(ST7735_t *tft)
 {
-	gpioResetPin(TFT->RST_PORT, TFT->RST);
+	gpioResetPin(tft->io->RST_PORT, tft->io->RST);
 }
 
-void _CS1(void)
+static inline void _CS1(ST7735_t *tft)
 {
-	gpioSetPin(TFT->CS_PORT, TFT->CS);
+	gpioSetPin(tft->io->CS_PORT, tft->io->CS);
 }
-void _CS0(void)
+static inline void _CS0(ST7735_t *tft)
 {
-	gpioResetPin(TFT->CS_PORT, TFT->CS);
+	gpioResetPin(tft->io->CS_PORT, tft->io->CS);
 }
 
 
@@ -151,60 +156,67 @@ void delayms(uint32_t delayValue)
 
 
 // Function sends byte via SPI to controller
-void tftSPISenddata(const uint8_t data)
+void st7735SPISenddata(ST7735_t *tft, const uint8_t data)
 {
-	spiWriteByte(spi, TFT->CS_PORT, TFT->CS, data);
+	spiBeginSession(tft->spi, tft->io->CS_PORT, tft->io->CS, SPI_DATA_8_BIT);
+	spiSessionWrite8(tft->spi, data);
+	spiEndSession(tft->spi, tft->io->CS_PORT, tft->io->CS);
 }
 
 
-// Function sends byte via SPI to controller
-void tftSPISenddata16(const uint16_t data)
+// Function sends 16-bit word (MSB first) via SPI to controller
+void st7735SPISenddata16(ST7735_t *tft, const uint16_t data)
 {
-	spiWriteWord(spi, TFT->CS_PORT, TFT->CS, data);
+	spiBeginSession(tft->spi, tft->io->CS_PORT, tft->io->CS, SPI_DATA_16_BIT);
+	spiSessionWrite16(tft->spi, data);
+	spiEndSession(tft->spi, tft->io->CS_PORT, tft->io->CS);
 }
 
 
 // Function sends control command to controller
-void tftSendCmd(const uint8_t cmd)
+// the address window cache is cleared, the command may change or reset the window
+void st7735SendCmd(ST7735_t *tft, const uint8_t cmd)
 {
-	_DC0();
-    tftSPISenddata(cmd);
+	tft->winValid = 0;
+	_DC0(tft);
+    st7735SPISenddata(tft, cmd);
 }
 
 
 // Function that sends parameters or a command to controller
-void tftSendData(const uint8_t data)
+void st7735SendData(ST7735_t *tft, const uint8_t data)
 {
-	_DC1();
-    tftSPISenddata(data);
+	_DC1(tft);
+    st7735SPISenddata(tft, data);
 }
 
 // Function that initializes the hardware configuration
-void IOspiInit(ST7735io_t *TFTset)
+void st7735IoInit(ST7735_t *tft, ST7735io_t *TFTset)
 {
-	TFT = TFTset;
-	spi = TFT->SPI;
+	tft->io = TFTset;
+	tft->spi = TFTset->SPI;
+	tft->winValid = 0;
     // Declaration of SPI & IO Pins for ST7735-Port
-    gpioSelectPort(TFT->RST_PORT);
-    gpioSelectPinMode(TFT->RST_PORT, TFT->RST, OUTPUT);		// RESET
-    gpioSelectPort(TFT->DC_PORT);
-    gpioSelectPinMode(TFT->DC_PORT, TFT->DC, OUTPUT);		// DATA/Command
+    gpioSelectPort(tft->io->RST_PORT);
+    gpioSelectPinMode(tft->io->RST_PORT, tft->io->RST, OUTPUT);		// RESET
+    gpioSelectPort(tft->io->DC_PORT);
+    gpioSelectPinMode(tft->io->DC_PORT, tft->io->DC, OUTPUT);		// DATA/Command
 
 
 
-    gpioInitPort(TFT->CS_PORT);
-    gpioSelectPinMode(TFT->CS_PORT,TFT->CS, OUTPUT);        // CS
-    gpioSelectPushPullMode(TFT->CS_PORT, TFT->CS, PULLUP);
+    gpioInitPort(tft->io->CS_PORT);
+    gpioSelectPinMode(tft->io->CS_PORT,tft->io->CS, OUTPUT);        // CS
+    gpioSelectPushPullMode(tft->io->CS_PORT, tft->io->CS, PULLUP);
 
-    gpioInitPort(TFT->SPI_PORT);
-    gpioSelectPinMode(TFT->SPI_PORT, TFT->CLK, ALTFUNC);	// SPI1 Clock
-    gpioSelectAltFunc(TFT->SPI_PORT, TFT->CLK, AF5);
-    gpioSelectPinMode(TFT->SPI_PORT, TFT->MOSI, ALTFUNC);	// SPI1 MOSI
-    gpioSelectAltFunc(TFT->SPI_PORT, TFT->MOSI, AF5);
+    gpioInitPort(tft->io->SPI_PORT);
+    gpioSelectPinMode(tft->io->SPI_PORT, tft->io->CLK, ALTFUNC);	// SPI1 Clock
+    gpioSelectAltFunc(tft->io->SPI_PORT, tft->io->CLK, AF5);
+    gpioSelectPinMode(tft->io->SPI_PORT, tft->io->MOSI, ALTFUNC);	// SPI1 MOSI
+    gpioSelectAltFunc(tft->io->SPI_PORT, tft->io->MOSI, AF5);
 
     // initialization of  SPI1
-    spiSelectSPI(spi);
-    spiInitSPI(spi, CLK_DIV_16, SPI_DATA_8_BIT, SSM_ON, SSI_LVL_HIGH, MASTER, SPI_PHASE_EDGE_1, SPI_IDLE_LOW);
+    spiSelectSPI(tft->spi);
+    spiInitSPI(tft->spi, CLK_DIV_16, SPI_DATA_8_BIT, SSM_ON, SSI_LVL_HIGH, MASTER, SPI_PHASE_EDGE_1, SPI_IDLE_LOW);
 
 }
 
@@ -578,43 +590,360 @@ static const uint8_t Rcmd3[] = {
 	100							//     100 ms delay
 };
 
-#define putpix(c) { tftSPISenddata(c >> 8); tftSPISenddata(c & 0xFF); }
-//define putpix(c) { tftSPISenddata16(c);} //doesnt work
+#ifdef TFT_FRAMEBUFFER
+/*
+ * Framebuffer core: while tftFbOn is set the address window and the pixel stream are
+ * emulated in RAM (same wrap-around as the panel RAM), every window is marked dirty.
+ */
+typedef struct
+{
+	uint8_t x0, y0, x1, y1;			// inclusive
+} TFT_RECT_t;
+
+static bool tftFbOn = false;
+static uint8_t tftFbX0, tftFbY0, tftFbX1, tftFbY1;
+static uint16_t tftFbCx, tftFbCy;	// write position, uint16_t: x1 + 1 may be 256
+static TFT_RECT_t tftFbDirty[TFT_FB_DIRTY_MAX];
+static uint8_t tftFbDirtyNum = 0;
+
+// the framebuffer belongs to the default display
+static inline bool tftFbActive(const ST7735_t *tft)
+{
+	return tftFbOn && (tft == &tftDefault);
+}
+
+static int32_t tftRectArea(const TFT_RECT_t *r)
+{
+	return (int32_t) (r->x1 - r->x0 + 1) * (r->y1 - r->y0 + 1);
+}
+
+static void tftRectUnion(TFT_RECT_t *r, const TFT_RECT_t *s)
+{
+	if (s->x0 < r->x0) r->x0 = s->x0;
+	if (s->y0 < r->y0) r->y0 = s->y0;
+	if (s->x1 > r->x1) r->x1 = s->x1;
+	if (s->y1 > r->y1) r->y1 = s->y1;
+}
+
+// pixels that the union of a and b sends in addition to a and b (negative: overlap)
+static int32_t tftRectMergeCost(const TFT_RECT_t *a, const TFT_RECT_t *b)
+{
+	TFT_RECT_t u = *a;
+
+	tftRectUnion(&u, b);
+	return tftRectArea(&u) - tftRectArea(a) - tftRectArea(b);
+}
+
+static void tftFbMarkDirty(TFT_RECT_t r)
+{
+	uint8_t i = 0, best = 0;
+	int32_t cost, bestCost = INT32_MAX;
+
+	// coalesce with overlapping or cheap neighbours, the grown rectangle is checked again
+	while (i < tftFbDirtyNum)
+	{
+		if (tftRectMergeCost(&r, &tftFbDirty[i]) <= TFT_FB_MERGE_SLACK)
+		{
+			tftRectUnion(&r, &tftFbDirty[i]);
+			tftFbDirty[i] = tftFbDirty[--tftFbDirtyNum];
+			i = 0;
+		}
+		else
+		{
+			i++;
+		}
+	}
+	if (tftFbDirtyNum == TFT_FB_DIRTY_MAX)
+	{
+		// list full: merge with the rectangle that grows least
+		for (i = 0; i < tftFbDirtyNum; i++)
+		{
+			cost = tftRectMergeCost(&r, &tftFbDirty[i]);
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				best = i;
+			}
+		}
+		tftRectUnion(&r, &tftFbDirty[best]);
+		tftFbDirty[best] = tftFbDirty[--tftFbDirtyNum];
+		tftFbMarkDirty(r);
+		return;
+	}
+	tftFbDirty[tftFbDirtyNum++] = r;
+}
+
+static void tftFbSetWindow(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1)
+{
+	TFT_RECT_t r;
+
+	if (x1 < x0) x1 = x0;
+	if (y1 < y0) y1 = y0;
+	tftFbX0 = x0; tftFbY0 = y0; tftFbX1 = x1; tftFbY1 = y1;
+	tftFbCx = x0;
+	tftFbCy = y0;
+
+	if ((x0 >= tftDefault.width) || (y0 >= tftDefault.height))
+	{
+		return;
+	}
+	r.x0 = x0;
+	r.y0 = y0;
+	r.x1 = (x1 < tftDefault.width)  ? x1 : tftDefault.width - 1;
+	r.y1 = (y1 < tftDefault.height) ? y1 : tftDefault.height - 1;
+	tftFbMarkDirty(r);
+}
+
+#ifdef TFT_FRAMEBUFFER_4BPP
+/*
+ * 4 bpp: two pixels per byte, the left one in the high nibble. Colors are mapped to the
+ * nearest palette entry when drawn and expanded to RGB565 line by line in tftFbFlush().
+ * tftFbPairLut holds both pixels of every byte value, so the expansion is one table access
+ * per two pixels.
+ */
+static uint8_t tftFb[ST7735_TFTWIDTH * ST7735_TFTHEIGHT / 2];
+static uint16_t tftPalette[16] =
+{
+	tft_BLACK, tft_BLUE, tft_RED, tft_GREEN, tft_CYAN, tft_MAGENTA, tft_YELLOW, tft_WHITE,
+	tft_GREY, 0x000F, 0x7800, 0x03E0, 0x03EF, 0x780F, 0x7BE0, 0xC618
+};
+static uint32_t tftFbPairLut[256];
+static bool tftFbLutValid = false;
+static uint16_t tftFbLastColor = tft_BLACK;
+static uint8_t tftFbLastIndex = 0;
+
+static uint8_t tftFbColorIndex(uint16_t color)
+{
+	int16_t dr, dg, db;
+	uint32_t d, best = UINT32_MAX;
+	uint8_t i;
+
+	if (color == tftFbLastColor)
+	{
+		return tftFbLastIndex;
+	}
+	for (i = 0; i < 16; i++)
+	{
+		dr = (int16_t) (color >> 11) - (tftPalette[i] >> 11);
+		dg = (int16_t) ((color >> 5) & 0x3F) - ((tftPalette[i] >> 5) & 0x3F);
+		db = (int16_t) (color & 0x1F) - (tftPalette[i] & 0x1F);
+		d  = 4 * dr * dr + dg * dg + 4 * db * db;		// 5 bit red/blue weighted like 6 bit green
+		if (d < best)
+		{
+			best = d;
+			tftFbLastIndex = i;
+			if (d == 0)
+			{
+				break;
+			}
+		}
+	}
+	tftFbLastColor = color;
+	return tftFbLastIndex;
+}
+
+static inline void tftFbStore(uint32_t pos, uint16_t color)
+{
+	uint8_t *p = &tftFb[pos >> 1];
+	uint8_t idx = tftFbColorIndex(color);
+
+	*p = (pos & 1) ? (*p & 0xF0) | idx : (*p & 0x0F) | (idx << 4);
+}
+
+static void tftFbFill(uint32_t pos, uint16_t num, uint16_t color)
+{
+	uint8_t idx = tftFbColorIndex(color);
+
+	if (num && (pos & 1))
+	{
+		tftFbStore(pos++, color);
+		num--;
+	}
+	memset(&tftFb[pos >> 1], idx * 0x11, num >> 1);
+	if (num & 1)
+	{
+		tftFbStore(pos + num - 1, color);
+	}
+}
+
+static void tftFbCopy(uint32_t pos, uint16_t num, const uint16_t *pix)
+{
+	while (num--)
+	{
+		tftFbStore(pos++, *pix++);
+	}
+}
+
+// returns the RGB565 pixels of a line segment, expanded into buf
+static const uint16_t *tftFbLine(uint16_t y, uint16_t x, uint16_t num, uint16_t *buf)
+{
+	const uint8_t *src = &tftFb[(y * tftDefault.width + x) >> 1];
+	uint16_t *dst = buf;
+	uint32_t pair;
+	uint16_t i;
+
+	if (!tftFbLutValid)
+	{
+		for (i = 0; i < 256; i++)
+		{
+			tftFbPairLut[i] = tftPalette[i >> 4] | ((uint32_t) tftPalette[i & 0x0F] << 16);
+		}
+		tftFbLutValid = true;
+	}
+	if (x & 1)
+	{
+		*dst++ = tftPalette[*src++ & 0x0F];
+		num--;
+	}
+	while (num >= 2)
+	{
+		pair = tftFbPairLut[*src++];
+		*dst++ = (uint16_t) pair;
+		*dst++ = (uint16_t) (pair >> 16);
+		num -= 2;
+	}
+	if (num)
+	{
+		*dst = tftPalette[*src >> 4];
+	}
+	return buf;
+}
+#else
+static uint16_t tftFb[ST7735_TFTWIDTH * ST7735_TFTHEIGHT];
+
+static inline void tftFbStore(uint32_t pos, uint16_t color)
+{
+	tftFb[pos] = color;
+}
+
+static void tftFbFill(uint32_t pos, uint16_t num, uint16_t color)
+{
+	uint16_t *dst = &tftFb[pos];
+
+	while (num--)
+	{
+		*dst++ = color;
+	}
+}
+
+static void tftFbCopy(uint32_t pos, uint16_t num, const uint16_t *pix)
+{
+	memcpy(&tftFb[pos], pix, num * sizeof(uint16_t));
+}
+
+static const uint16_t *tftFbLine(uint16_t y, uint16_t x, uint16_t num, uint16_t *buf)
+{
+	(void) num;				// RGB565 is sent directly from the framebuffer
+	(void) buf;
+	return &tftFb[y * tftDefault.width + x];
+}
+#endif /* TFT_FRAMEBUFFER_4BPP */
+
+static inline void tftFbPut(uint16_t color)
+{
+	if ((tftFbCx < tftDefault.width) && (tftFbCy < tftDefault.height))
+	{
+		tftFbStore(tftFbCy * tftDefault.width + tftFbCx, color);
+	}
+	if (++tftFbCx > tftFbX1)
+	{
+		tftFbCx = tftFbX0;
+		if (++tftFbCy > tftFbY1)
+		{
+			tftFbCy = tftFbY0;
+		}
+	}
+}
+
+// writes num pixels (memIncr = false: num times *pix) row by row into the window
+static void tftFbWrite(const uint16_t *pix, uint32_t num, bool memIncr)
+{
+	uint16_t run, vis;
+	uint32_t pos;
+
+	while (num > 0)
+	{
+		run = tftFbX1 - tftFbCx + 1;
+		if (run > num)
+		{
+			run = num;
+		}
+		vis = 0;
+		if ((tftFbCy < tftDefault.height) && (tftFbCx < tftDefault.width))
+		{
+			vis = (run < tftDefault.width - tftFbCx) ? run : tftDefault.width - tftFbCx;
+		}
+		pos = tftFbCy * tftDefault.width + tftFbCx;
+		if (memIncr)
+		{
+			tftFbCopy(pos, vis, pix);
+			pix += run;
+		}
+		else
+		{
+			tftFbFill(pos, vis, *pix);
+		}
+		num -= run;
+		tftFbCx += run;
+		if (tftFbCx > tftFbX1)
+		{
+			tftFbCx = tftFbX0;
+			if (++tftFbCy > tftFbY1)
+			{
+				tftFbCy = tftFbY0;
+			}
+		}
+	}
+}
+#endif /* TFT_FRAMEBUFFER */
+
+// putpix() only between tftPixelBegin() and tftPixelEnd(): one 16-bit frame per pixel, CS held low
+static inline void putpix(ST7735_t *tft, uint16_t color)
+{
+#ifdef TFT_FRAMEBUFFER
+	if (tftFbActive(tft))
+	{
+		tftFbPut(color);
+		return;
+	}
+#endif
+	spiSessionWrite16(tft->spi, color);
+}
 
-//default values for start Position
-static int colstart = 0; // May be overwritten in init func
-static int rowstart = 0; // May be overwritten in init func
+static void tftPixelBegin(ST7735_t *tft)
+{
+#ifdef TFT_FRAMEBUFFER
+	if (tftFbActive(tft)) return;
+#endif
+	_DC1(tft);
+	spiBeginSession(tft->spi, tft->io->CS_PORT, tft->io->CS, SPI_DATA_16_BIT);
+}
 
-static uint8_t orientation = PORTRAIT;
-typedef struct _font {
-	uint8_t 	*font;
-	uint8_t 	x_size;
-	uint8_t 	y_size;
-	uint8_t		offset;
-	uint16_t	numchars;
-} Font;
+static void tftPixelEnd(ST7735_t *tft)
+{
+#ifdef TFT_FRAMEBUFFER
+	if (tftFbActive(tft)) return;
+#endif
+	spiEndSession(tft->spi, tft->io->CS_PORT, tft->io->CS);
+}
 
-static Font cfont;
-static uint8_t _transparent = 0;
-static uint16_t _fg = tft_GREEN;
-static uint16_t _bg = tft_BLACK;
 
 /*Companion code to the above tables.  Reads and issues
 * a series of tft commands stored in PROGMEM byte array.
 */
-static void commandList(const uint8_t *addr)
+static void commandList(ST7735_t *tft, const uint8_t *addr)
 {
 	uint8_t  numCommands, numArgs;
 	uint16_t ms;
 
 	numCommands = *addr++;   // Number of commands to follow
 	while(numCommands--) {                 // For each command...
-		tftSendCmd(*addr++); //   Read, issue command
+		st7735SendCmd(tft, *addr++); //   Read, issue command
 		numArgs  = *addr++;    //   Number of args to follow
 		ms       = numArgs & DELAY;          //   If hibit set, delay follows args
 		numArgs &= ~DELAY;                   //   Mask out delay bit
 		while(numArgs--) {                   //   For each argument...
-			tftSendData(*addr++);  //     Read, issue argument
+			st7735SendData(tft, *addr++);  //     Read, issue argument
 		}
 
 		if(ms) {
@@ -626,261 +955,505 @@ static void commandList(const uint8_t *addr)
 }
 
 // Initialization code common to both 'B' and 'R' type displays
-static void commonInit(const uint8_t *cmdList)
+static void commonInit(ST7735_t *tft, const uint8_t *cmdList)
 {
 	// toggle RST low to reset; CS low so it'll listen to us
-	_CS0();
+	_CS0(tft);
 #ifdef tft_SOFT_RESET
-	tftSendCmd(ST7735_SWRESET);
+	st7735SendCmd(tft, ST7735_SWRESET);
 	delayms(500);
 #else
 	//ST7735_RST1;
 	//delay_ms(500);
-	_RST0();
+	_RST0(tft);
 	delayms(50);  //default value 50
-	_RST1();
+	_RST1(tft);
 	//delay_ms(500);
 #endif
-	if(cmdList) commandList(cmdList);
+	if(cmdList) commandList(tft, cmdList);
 }
 
 // Initialization for ST7735R screens (green or red tabs)
-void tftInitR(uint8_t options)
+void st7735InitR(ST7735_t *tft, uint8_t options)
 {
 	delayms(50);
-	commonInit(Rcmd1);
+	commonInit(tft, Rcmd1);
 	//chooses initialization for specific display type
 	if(options == INITR_GREENTAB)
 	{
-		commandList(Rcmd2green);
+		commandList(tft, Rcmd2green);
 		//Starting position of rows and columns
-		colstart = 2;
-		rowstart = 1;
+		tft->colstart = 2;
+		tft->rowstart = 1;
 	}
 	else
 	{
 		// colstart, rowstart left at default '0' values
-		commandList(Rcmd2red);
+		commandList(tft, Rcmd2red);
 	}
-	commandList(Rcmd3);
+	commandList(tft, Rcmd3);
 
 	// if black, change MADCTL color filter
 	if (options == INITR_BLACKTAB)
 	{
-		tftSendCmd(ST7735_MADCTL);
-		tftSendData(0xC0);
+		st7735SendCmd(tft, ST7735_MADCTL);
+		st7735SendData(tft, 0xC0);
 	}
 
 	//  tabcolor = options;
 }
 
-/*sets Window for what will be printed on display
- * x0, x1 are start column and end column
- * y0, y1 are start row and end row
+/* IO and panel initialization of a further display with its own context, e.g.
+ * static ST7735_t tft2;  st7735Init(&tft2, &ST7735bala, INITR_REDTAB);
+ * font and colors have to be set afterwards
  */
-void tftSetAddrWindow(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1)
+void st7735Init(ST7735_t *tft, ST7735io_t *io, uint8_t options)
 {
-	tftSendCmd(ST7735_CASET);		// Column addr set
-	tftSendData(0x00);
-	tftSendData(x0+colstart);     // XSTART
-	tftSendData(0x00);
-	tftSendData(x1+colstart);     // XEND
-
-	tftSendCmd(ST7735_RASET); // Row addr set
-	tftSendData(0x00);
-	tftSendData(y0+rowstart);     // YSTART
-	tftSendData(0x00);
-	tftSendData(y1+rowstart);     // YEND
-
-	tftSendCmd(ST7735_RAMWR); // write to RAM
+	memset(tft, 0, sizeof(ST7735_t));
+	tft->width       = ST7735_TFTWIDTH;
+	tft->height      = ST7735_TFTHEIGHT;
+	tft->orientation = PORTRAIT;
+	tft->fg          = tft_GREEN;
+	tft->bg          = tft_BLACK;
+	st7735IoInit(tft, io);
+	st7735InitR(tft, options);
 }
 
-//colors selected pixel in chosen color
-void tftPushColor(uint16_t color)
+/* command with two 16-bit parameters within a session
+ * DC is sampled with the last bit of a frame, therefore the bus is idle before DC changes
+ */
+static void tftSessionCmd2x16(ST7735_t *tft, uint8_t cmd, uint16_t p1, uint16_t p2)
 {
-	_DC1();
-	putpix(color);
+	_DC0(tft);
+	spiSessionWrite8(tft->spi, cmd);
+	spiSessionFlush(tft->spi);
+	_DC1(tft);
+	spiSwitchDataLen(tft->spi, SPI_DATA_16_BIT);
+	spiSessionWrite16(tft->spi, p1);
+	spiSessionWrite16(tft->spi, p2);
+	spiSwitchDataLen(tft->spi, SPI_DATA_8_BIT);		// waits for the last parameter
 }
 
-/* draw single colored pixel on screen
- * x and y are the Position, color examples are defined in tft Display Header
+#define TFT_WIN_CASET	(0x01)		// winCol holds the column window of the panel
+#define TFT_WIN_RASET	(0x02)		// winRow holds the row window of the panel
+
+/* sets the panel address window (RAM addresses, offsets included) and starts RAMWR
+ * CASET and RASET are skipped if the panel holds the same values from the previous window,
+ * e.g. glyphs in one text line (same rows) or bar updates (same rows); RAMWR is always sent,
+ * it moves the write position back to the window start
  */
-void tftDrawPixel(int16_t x, int16_t y, uint16_t color)
+static void tftWindow(ST7735_t *tft, uint16_t c0, uint16_t c1, uint16_t r0, uint16_t r1)
 {
-	if((x < 0) ||(x >= width) || (y < 0) || (y >= height))
-		{
-		return;
-		}
-
-	tftSetAddrWindow(x,y,x+1,y+1);
-	tftPushColor(color);
+	spiBeginSession(tft->spi, tft->io->CS_PORT, tft->io->CS, SPI_DATA_8_BIT);
+	if (!(tft->winValid & TFT_WIN_CASET) || (c0 != tft->winCol[0]) || (c1 != tft->winCol[1]))
+	{
+		tftSessionCmd2x16(tft, ST7735_CASET, c0, c1);	// Column addr set: XSTART, XEND
+		tft->winCol[0] = c0;
+		tft->winCol[1] = c1;
+	}
+	if (!(tft->winValid & TFT_WIN_RASET) || (r0 != tft->winRow[0]) || (r1 != tft->winRow[1]))
+	{
+		tftSessionCmd2x16(tft, ST7735_RASET, r0, r1);	// Row addr set: YSTART, YEND
+		tft->winRow[0] = r0;
+		tft->winRow[1] = r1;
+	}
+	tft->winValid = TFT_WIN_CASET | TFT_WIN_RASET;
+	_DC0(tft);
+	spiSessionWrite8(tft->spi, ST7735_RAMWR);	// write to RAM
+	spiEndSession(tft->spi, tft->io->CS_PORT, tft->io->CS);
 }
 
-/*fill a rectangle
- * x and y are starting position
- * w is width, h is height
+/*sets Window for what will be printed on display
+ * x0, x1 are start column and end column
+ * y0, y1 are start row and end row
  */
-void tftFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+void st7735SetAddrWindow(ST7735_t *tft, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1)
 {
-	// rudimentary clipping (drawChar w/big text requires this)
-	if((x >= width) || (y >= height))
-		{
+#ifdef TFT_FRAMEBUFFER
+	if (tftFbActive(tft))
+	{
+		tftFbSetWindow(x0, y0, x1, y1);
 		return;
-		}
-
-	if((x + w - 1) >= width)
-		{
-		w = width  - x;
-		}
-
-	if((y + h - 1) >= height)
-		{
-		h = height - y;
-		}
-
-	tftSetAddrWindow(x, y, x+w-1, y+h-1);
+	}
+#endif
+	tftWindow(tft, x0+tft->colstart, x1+tft->colstart, y0+tft->rowstart, y1+tft->rowstart);
+}
 
-	_DC1();
-	for(y=h; y>0; y--)
+//colors selected pixel in chosen color
+void st7735PushColor(ST7735_t *tft, uint16_t color)
+{
+#ifdef TFT_FRAMEBUFFER
+	if (tftFbActive(tft))
 	{
-		for(x=w; x>0; x--)
-		{
-			putpix(color);
-		}
+		tftFbPut(color);
+		return;
 	}
+#endif
+	_DC1(tft);
+	st7735SPISenddata16(tft, color);
 }
 
 /*
- * draws vertical line
- * x an y are starting point
- * h is height
+ * DMA streaming of pixel data into the current address window:
+ * CS stays low for the whole window, the SPI sends 16-bit frames (RGB565, MSB first).
+ * Shorter runs than TFT_DMA_MIN_PIXELS are sent with putpix, the DMA setup would take longer.
  */
-void tftDrawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
-	// Rudimentary clipping
-	if((x >= width) || (y >= height)) return;
-	if((y+h-1) >= height) h = height-y;
-	tftSetAddrWindow(x, y, x, y+h-1);
+#define TFT_DMA_MIN_PIXELS	(8)
+#define TFT_DMA_MAX_CHUNK	(0xFFFF)			// NDTR is 16 bit
+#define TFT_LINE_BUF		(ST7735_TFTHEIGHT)	// longest line in any rotation
 
-	_DC1();
-	while (h--) {
-		putpix(color);
-	}
+static uint16_t tftLineBuf[2][TFT_LINE_BUF];	// ping-pong: one line is built while the other is sent
+static uint16_t tftFillColor;					// fixed DMA source of tftPushRepeated()
+
+static void tftDmaBegin(ST7735_t *tft)
+{
+#ifdef TFT_FRAMEBUFFER
+	if (tftFbActive(tft)) return;
+#endif
+	_DC1(tft);
+	spiBeginSession(tft->spi, tft->io->CS_PORT, tft->io->CS, SPI_DATA_16_BIT);
 }
 
-/*
- * draws horizontal line
- * x an y are starting point
- * w is width
- */
-void tftDrawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+// waits for the previous chunk only, so the caller can prepare the next one meanwhile
+static void tftDmaPush(ST7735_t *tft, const uint16_t *pix, uint16_t num, bool memIncr)
 {
-	// Rudimentary clipping
-	if((x >= width) || (y >= height))
-		{
+#ifdef TFT_FRAMEBUFFER
+	if (tftFbActive(tft))
+	{
+		tftFbWrite(pix, num, memIncr);
 		return;
-		}
+	}
+#endif
+	spiWaitDMA(tft->spi);
+	spiWriteDMA(tft->spi, pix, num, SPI_DATA_16_BIT, memIncr);
+}
 
-	if((x+w-1) >= width)
-		{
-		w = width-x;
-		}
+static void tftDmaEnd(ST7735_t *tft)
+{
+#ifdef TFT_FRAMEBUFFER
+	if (tftFbActive(tft)) return;
+#endif
+	spiWaitDMA(tft->spi);
+	spiEndSession(tft->spi, tft->io->CS_PORT, tft->io->CS);
+}
 
-	tftSetAddrWindow(x, y, x+w-1, y);
+// public interface of the DMA stream, e.g. for band renderers
+void st7735StreamBegin(ST7735_t *tft)
+{
+	tftDmaBegin(tft);
+}
 
-	_DC1();
-	while (w--)
-	{
-		putpix(color);
-	}
+void st7735StreamPush(ST7735_t *tft, const uint16_t *pix, uint16_t num)
+{
+	tftDmaPush(tft, pix, num, true);
 }
 
-/*
- * draws line between two x-/y-coordinates
- * x1, y1 is starting point
- * x2, y2 is ending point
- */
-void tftDrawFastLine(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint16_t color)
+void st7735StreamEnd(ST7735_t *tft)
 {
-	signed char   dx, dy, sx, sy;
-	unsigned char  x,  y, mdx, mdy, l;
+	tftDmaEnd(tft);
+}
 
-	// horizontal or vertical line
-	if (x1==x2) {
-		tftFillRect(x1,y1, x1,y2, color); // vertical line
-		return;
-	}
+// sends num pixels from memory into the address window
+static void tftPushPixels(ST7735_t *tft, const uint16_t *data, uint32_t num)
+{
+	uint16_t chunk;
 
-	if (y1==y2) {
-		tftFillRect(x1,y1, x2,y1, color); // horizontal line
+#ifdef TFT_FRAMEBUFFER
+	if (tftFbActive(tft))
+	{
+		tftFbWrite(data, num, true);
 		return;
 	}
-
-	// angled line
-	dx=x2-x1;
-	dy=y2-y1;
-
-	//setting gradient depending on chosen coordinates
-	if (dx>=0)
+#endif
+	if (num < TFT_DMA_MIN_PIXELS)
 	{
-		mdx=dx;
-		sx=1;
-	}
-	else
+		tftPixelBegin(tft);
+		while (num--)
+		{
+			putpix(tft, *data);
+			data++;
+		}
+		tftPixelEnd(tft);
+		return;
+	}
+	tftDmaBegin(tft);
+	while (num > 0)
 	{
-		mdx=x1-x2;
-		sx=-1;
+		chunk = (num > TFT_DMA_MAX_CHUNK) ? TFT_DMA_MAX_CHUNK : num;
+		tftDmaPush(tft, data, chunk, true);
+		data += chunk;
+		num  -= chunk;
 	}
+	tftDmaEnd(tft);
+}
+
+// sends the same color num times into the address window
+static void tftPushRepeated(ST7735_t *tft, uint16_t color, uint32_t num)
+{
+	uint16_t chunk;
 
-	if (dy>=0)
+#ifdef TFT_FRAMEBUFFER
+	if (tftFbActive(tft))
 	{
-		mdy=dy;
-		sy=1;
+		tftFbWrite(&color, num, false);
+		return;
 	}
-	else
+#endif
+	if (num < TFT_DMA_MIN_PIXELS)
+	{
+		tftPixelBegin(tft);
+		while (num--)
+		{
+			putpix(tft, color);
+		}
+		tftPixelEnd(tft);
+		return;
+	}
+	tftFillColor = color;
+	tftDmaBegin(tft);
+	while (num > 0)
 	{
-		mdy=y1-y2;
-		sy=-1;
+		chunk = (num > TFT_DMA_MAX_CHUNK) ? TFT_DMA_MAX_CHUNK : num;
+		tftDmaPush(tft, &tftFillColor, chunk, false);
+		num -= chunk;
 	}
+	tftDmaEnd(tft);
+}
+
+#ifdef TFT_FRAMEBUFFER
+/* switches the framebuffer on or off
+ * on:  all drawing functions render into RAM, the panel is only written by tftFbFlush()
+ * off: pending changes are flushed, drawing goes to the panel directly again
+ */
+void tftFbEnable(uint8_t on)
+{
+	if (!on && tftFbOn)
+	{
+		tftFbFlush();
+	}
+	tftFbOn = (on != 0);
+}
 
-	x=x1;
-	y=y1;
+// marks the whole screen as changed, e.g. after tftSetRotation()
+void tftFbInvalidate(void)
+{
+	tftFbDirty[0].x0 = 0;
+	tftFbDirty[0].y0 = 0;
+	tftFbDirty[0].x1 = tftDefault.width - 1;
+	tftFbDirty[0].y1 = tftDefault.height - 1;
+	tftFbDirtyNum = 1;
+}
 
-	if (mdx>=mdy)
+/* sends the dirty regions of the framebuffer to the panel
+ * every region is one address window, its lines are streamed by DMA
+ * returns the number of pixels sent
+ */
+uint32_t tftFbFlush(void)
+{
+	TFT_RECT_t *r;
+	uint16_t y, w;
+	uint32_t sent = 0;
+	bool on = tftFbOn;
+	uint8_t i, buf = 0;
+
+	tftFbOn = false;				// window and pixels go to the panel
+	for (i = 0; i < tftFbDirtyNum; i++)
 	{
-		l=mdx;
-		while (l>0)
+		r = &tftFbDirty[i];
+		w = r->x1 - r->x0 + 1;
+		st7735SetAddrWindow(&tftDefault, r->x0, r->y0, r->x1, r->y1);
+#ifndef TFT_FRAMEBUFFER_4BPP
+		if (w == tftDefault.width)
 		{
-			if (dy>0)
-			{
-				y=y1+mdy*(x-x1)/mdx; // straight line equation for positive gradient
-			}
-			else
+			tftPushPixels(&tftDefault, &tftFb[r->y0 * tftDefault.width], (uint32_t) w * (r->y1 - r->y0 + 1));
+		}
+		else
+#endif
+		{
+			// 4 bpp: one line is expanded while the other one is sent
+			tftDmaBegin(&tftDefault);
+			for (y = r->y0; y <= r->y1; y++)
 			{
-				y=y1-mdy*(x-x1)/mdx; // straight line equation for negative gradient
+				tftDmaPush(&tftDefault, tftFbLine(y, r->x0, w, tftLineBuf[buf]), w, true);
+				buf ^= 1;
 			}
-			tftDrawPixel(x,y,color); //colors pixels of the line
-			x=x+sx;
-			l--;
+			tftDmaEnd(&tftDefault);
 		}
-	} else
+		sent += (uint32_t) w * (r->y1 - r->y0 + 1);
+	}
+	tftFbDirtyNum = 0;
+	tftFbOn = on;
+	return sent;
+}
+
+#ifdef TFT_FRAMEBUFFER_4BPP
+/* changes one palette entry, the whole screen is sent with the next tftFbFlush()
+ * palette effects (blinking, fading, color themes) need no redraw of the content
+ */
+void tftFbSetPalette(uint8_t index, uint16_t color)
+{
+	index &= 0x0F;
+	if (tftPalette[index] == color)
 	{
-		l=mdy;
-		while (l>0)
+		return;
+	}
+	tftPalette[index] = color;
+	tftFbLutValid = false;
+	tftFbLastColor = tftPalette[tftFbLastIndex];	// color cache must not hit the old entry
+	tftFbInvalidate();
+}
+
+uint16_t tftFbGetPalette(uint8_t index)
+{
+	return tftPalette[index & 0x0F];
+}
+
+// loads all 16 entries
+void tftFbLoadPalette(const uint16_t *colors)
+{
+	uint8_t i;
+
+	for (i = 0; i < 16; i++)
+	{
+		tftFbSetPalette(i, colors[i]);
+	}
+}
+#endif /* TFT_FRAMEBUFFER_4BPP */
+#endif /* TFT_FRAMEBUFFER */
+
+/* draw single colored pixel on screen
+ * x and y are the Position, color examples are defined in tft Display Header
+ */
+void st7735DrawPixel(ST7735_t *tft, int16_t x, int16_t y, uint16_t color)
+{
+	if((x < 0) ||(x >= tft->width) || (y < 0) || (y >= tft->height))
 		{
-			if (dy>0)
-			{
-				x=x1+((mdx*(y-y1))/mdy); // straight line equation for positive gradient
-			}
-			else
-			{
-				x=x1+((mdx*(y1-y))/mdy); // straight line equation for negative gradient
-			}
-			tftDrawPixel(x,y,color); // colors pixels of the line
-			y=y+sy;
-			l--;
+		return;
+		}
+
+	st7735SetAddrWindow(tft, x,y,x+1,y+1);
+	st7735PushColor(tft, color);
+}
+
+/*
+ * Span rasterizer: lines, circles and fills are split into horizontal or vertical runs,
+ * every run is clipped to the screen and costs one address window and one burst.
+ * x0 <= x1 and y0 <= y1, inclusive
+ */
+static void tftSpan(ST7735_t *tft, int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
+{
+	if (x0 < 0) x0 = 0;
+	if (y0 < 0) y0 = 0;
+	if (x1 >= tft->width)  x1 = tft->width - 1;
+	if (y1 >= tft->height) y1 = tft->height - 1;
+	if ((x0 > x1) || (y0 > y1))
+	{
+		return;
+	}
+	st7735SetAddrWindow(tft, x0, y0, x1, y1);
+	tftPushRepeated(tft, color, (uint32_t) (x1 - x0 + 1) * (y1 - y0 + 1));
+}
+
+/*fill a rectangle
+ * x and y are starting position
+ * w is width, h is height
+ */
+void st7735FillRect(ST7735_t *tft, int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+	if ((w > 0) && (h > 0))
+	{
+		tftSpan(tft, x, y, x+w-1, y+h-1, color);
+	}
+}
+
+/*
+ * draws vertical line
+ * x an y are starting point
+ * h is height
+ */
+void st7735DrawFastVLine(ST7735_t *tft, int16_t x, int16_t y, int16_t h, uint16_t color)
+{
+	if (h > 0)
+	{
+		tftSpan(tft, x, y, x, y+h-1, color);
+	}
+}
+
+/*
+ * draws horizontal line
+ * x an y are starting point
+ * w is width
+ */
+void st7735DrawFastHLine(ST7735_t *tft, int16_t x, int16_t y, int16_t w, uint16_t color)
+{
+	if (w > 0)
+	{
+		tftSpan(tft, x, y, x+w-1, y, color);
+	}
+}
+
+/*
+ * draws line between two x-/y-coordinates
+ * x1, y1 is starting point
+ * x2, y2 is ending point
+ * integer Bresenham, pixels in the same row (flat lines) or column (steep lines)
+ * are sent as one span
+ */
+void st7735DrawFastLine(ST7735_t *tft, uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint16_t color)
+{
+	int16_t dx = (x2 > x1) ? x2 - x1 : x1 - x2;
+	int16_t dy = (y2 > y1) ? y1 - y2 : y2 - y1;		// -|dy|
+	int16_t sx = (x1 < x2) ? 1 : -1;
+	int16_t sy = (y1 < y2) ? 1 : -1;
+	int16_t err = dx + dy, e2;
+	int16_t x = x1, y = y1;
+	int16_t rx = x1, ry = y1, ex = x1, ey = y1;		// current run
+	bool flat = (dx >= -dy);
+
+	// horizontal or vertical line
+	if (x1 == x2)
+	{
+		st7735DrawFastVLine(tft, x1, (y1 < y2) ? y1 : y2, 1 - dy, color);
+		return;
+	}
+	if (y1 == y2)
+	{
+		st7735DrawFastHLine(tft, (x1 < x2) ? x1 : x2, y1, dx + 1, color);
+		return;
+	}
+
+	// angled line: the run (rx, ry) ... (ex, ey) grows as long as the pixels are neighbours
+	// in the same row (flat) or column (steep)
+	for (;;)
+	{
+		e2 = 2 * err;
+		if ((x == x2) && (y == y2))
+		{
+			break;
+		}
+		if (e2 >= dy)
+		{
+			err += dy;
+			x += sx;
+		}
+		if (e2 <= dx)
+		{
+			err += dx;
+			y += sy;
+		}
+		if (flat ? (y == ey) : (x == ex))
+		{
+			ex = x;
+			ey = y;
+		}
+		else
+		{
+			tftSpan(tft, (rx < ex) ? rx : ex, (ry < ey) ? ry : ey, (rx < ex) ? ex : rx, (ry < ey) ? ey : ry, color);
+			rx = ex = x;
+			ry = ey = y;
 		}
 	}
-	tftDrawPixel(x2, y2, color);
+	tftSpan(tft, (rx < ex) ? rx : ex, (ry < ey) ? ry : ey, (rx < ex) ? ex : rx, (ry < ey) ? ey : ry, color);
 }
 
 
@@ -890,12 +1463,12 @@ void tftDrawFastLine(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint16_t co
  * y1 is start parameter y
  * y2 is end parameter y
 */
-void tftDrawRect(uint8_t x1,uint8_t y1,uint8_t x2,uint8_t y2, uint16_t color)
+void st7735DrawRect(ST7735_t *tft, uint8_t x1,uint8_t y1,uint8_t x2,uint8_t y2, uint16_t color)
 {
-	tftDrawFastHLine(x1,y1,x2-x1, color);
-	tftDrawFastVLine(x2,y1,y2-y1, color);
-	tftDrawFastHLine(x1,y2,x2-x1, color);
-	tftDrawFastVLine(x1,y1,y2-y1, color);
+	st7735DrawFastHLine(tft, x1,y1,x2-x1, color);
+	st7735DrawFastVLine(tft, x2,y1,y2-y1, color);
+	st7735DrawFastHLine(tft, x1,y2,x2-x1, color);
+	st7735DrawFastVLine(tft, x1,y1,y2-y1, color);
 }
 
 
@@ -903,54 +1476,54 @@ void tftDrawRect(uint8_t x1,uint8_t y1,uint8_t x2,uint8_t y2, uint16_t color)
  * x is x center coordinate
  * y is y center coordinate
  * radius is radius in pixel
+ * midpoint algorithm, all points with the same y1 form a horizontal run in the flat
+ * octants and a vertical run in the steep ones: 4 + 4 spans per step of y1
 */
-void tftDrawCircle(int16_t x, int16_t y, int radius, uint16_t color)
+void st7735DrawCircle(ST7735_t *tft, int16_t x, int16_t y, int radius, uint16_t color)
 {
 	int f = 1 - radius;
 	int ddF_x = 1;
 	int ddF_y = -2 * radius;
 	int x1 = 0;
 	int y1 = radius;
+	int xa = 0;						// first x1 of the current y1
 
-	tftSetAddrWindow(x, y + radius, x, y + radius);
-	tftPushColor(color);
-	tftSetAddrWindow(x, y - radius, x, y - radius);
-	tftPushColor(color);
-	tftSetAddrWindow(x + radius, y, x + radius, y);
-	tftPushColor(color);
-	tftSetAddrWindow(x - radius, y, x - radius, y);
-	tftPushColor(color);
-
-	while(x1 < y1)
+	for (;;)
 	{
-		if(f >= 0)
+		if ((x1 >= y1) || (f >= 0))
 		{
+			// y1 changes or end: runs xa ... x1 at distance y1
+			if (xa == 0)
+			{
+				tftSpan(tft, x - x1, y + y1, x + x1, y + y1, color);
+				tftSpan(tft, x - x1, y - y1, x + x1, y - y1, color);
+				tftSpan(tft, x + y1, y - x1, x + y1, y + x1, color);
+				tftSpan(tft, x - y1, y - x1, x - y1, y + x1, color);
+			}
+			else
+			{
+				tftSpan(tft, x + xa, y + y1, x + x1, y + y1, color);
+				tftSpan(tft, x - x1, y + y1, x - xa, y + y1, color);
+				tftSpan(tft, x + xa, y - y1, x + x1, y - y1, color);
+				tftSpan(tft, x - x1, y - y1, x - xa, y - y1, color);
+				tftSpan(tft, x + y1, y + xa, x + y1, y + x1, color);
+				tftSpan(tft, x + y1, y - x1, x + y1, y - xa, color);
+				tftSpan(tft, x - y1, y + xa, x - y1, y + x1, color);
+				tftSpan(tft, x - y1, y - x1, x - y1, y - xa, color);
+			}
+			if (x1 >= y1)
+			{
+				break;
+			}
 			y1--;
 			ddF_y += 2;
 			f += ddF_y;
+			xa = x1 + 1;
 		}
 
 		x1++;
 		ddF_x += 2;
 		f += ddF_x;
-
-
-		tftSetAddrWindow(x + x1, y + y1, x + x1, y + y1);
-		tftPushColor(color);
-		tftSetAddrWindow(x - x1, y + y1, x - x1, y + y1);
-		tftPushColor(color);
-		tftSetAddrWindow(x + x1, y - y1, x + x1, y - y1);
-		tftPushColor(color);
-		tftSetAddrWindow(x - x1, y - y1, x - x1, y - y1);
-		tftPushColor(color);
-		tftSetAddrWindow(x + y1, y + x1, x + y1, y + x1);
-		tftPushColor(color);
-		tftSetAddrWindow(x - y1, y + x1, x - y1, y + x1);
-		tftPushColor(color);
-		tftSetAddrWindow(x + y1, y - x1, x + y1, y - x1);
-		tftPushColor(color);
-		tftSetAddrWindow(x - y1, y - x1, x - y1, y - x1);
-		tftPushColor(color);
 	}
 }
 
@@ -958,20 +1531,26 @@ void tftDrawCircle(int16_t x, int16_t y, int radius, uint16_t color)
 /* Function that draws a filled Circle
  * x is x-center-coordinate
  * y is y-center-coordinate
+ * row y+-y1 covers x-d ... x+d-1 with d*d + y1*y1 <= radius*radius, d grows from the
+ * poles to the equator, so it is found incrementally without search
 */
-void tftFillCircle(int16_t x, int16_t y, int radius, uint16_t color)
+void st7735FillCircle(ST7735_t *tft, int16_t x, int16_t y, int radius, uint16_t color)
 {
-	int x1,y1;
+	int y1, d = 0;
+	int32_t r2 = (int32_t) radius * radius;
 
-	for(y1=-radius; y1<=0; y1++)
+	for(y1=radius; y1>=0; y1--)
 	{
-		for(x1=-radius; x1<=0; x1++)
+		while ((int32_t) (d + 1) * (d + 1) + (int32_t) y1 * y1 <= r2)
 		{
-			if(x1*x1+y1*y1 <= radius*radius)
+			d++;
+		}
+		if (d > 0)
+		{
+			tftSpan(tft, x - d, y - y1, x + d - 1, y - y1, color); //Draw a line from one side of the circular arc to the other side.
+			if (y1 > 0)
 			{
-				tftDrawFastHLine(x+x1, y+y1, 2*(-x1), color); //Draw a line from one side of the circular arc to the other side.
-				tftDrawFastHLine(x+x1, y-y1, 2*(-x1), color);
-				break;
+				tftSpan(tft, x - d, y + y1, x + d - 1, y + y1, color);
 			}
 		}
 	}
@@ -985,73 +1564,45 @@ void tftFillCircle(int16_t x, int16_t y, int radius, uint16_t color)
  * ys is the height of the picture in pixels
  * data contains the bitmap-graphic
  * scale: e.g. 2 means twice the original size
+ * pixel data is streamed by DMA; scaled lines wider than the display are clipped
 */
-void tftDrawBitmap(int x, int y, int sx, int sy, bitmapdatatype data, int scale)
+void st7735DrawBitmap(ST7735_t *tft, int x, int y, int sx, int sy, bitmapdatatype data, int scale)
 {
-	int tx, ty, tc, tsx, tsy;
+	int tx, ty, tsy, w, src;
+	uint16_t *line;
+	uint8_t buf = 0;
+	bool mirror = !(tft->orientation == PORTRAIT || tft->orientation == PORTRAIT_FLIP);
 
-	if (scale==1)
+	if ((scale == 1) && !mirror)
 	{
-		if (orientation == PORTRAIT || orientation == PORTRAIT_FLIP)
-		{
-			tftSetAddrWindow(x, y, x+sx-1, y+sy-1);
-			_DC1();
+		st7735SetAddrWindow(tft, x, y, x+sx-1, y+sy-1);
+		tftPushPixels(tft, data, (uint32_t) sx * sy);
+		return;
+	}
 
-			for (tc=0; tc<(sx*sy); tc++)
-			{
-				putpix(data[tc]);
-			}
-		}
-		else
-		{
-			for (ty=0; ty<sy; ty++)
-			{
-				tftSetAddrWindow(x, y+ty, x+sx-1, y+ty);
-				_DC1();
-				for (tx=sx-1; tx>=0; tx--)
-				{
-					putpix(data[(ty*sx)+tx]);
-				}
-			}
-		}
+	// Landscape lines are mirrored and/or scaled in the line buffer, then streamed scale times
+	w = sx * scale;
+	if (w > TFT_LINE_BUF)
+	{
+		w = TFT_LINE_BUF;
 	}
-	else
+	st7735SetAddrWindow(tft, x, y, x+w-1, y+(sy*scale)-1);
+	tftDmaBegin(tft);
+	for (ty=0; ty<sy; ty++)
 	{
-		if (orientation == PORTRAIT || orientation == PORTRAIT_FLIP)
+		line = tftLineBuf[buf];
+		for (tx=0; tx<w; tx++)
 		{
-			for (ty=0; ty<sy; ty++)
-			{
-				tftSetAddrWindow(x, y+(ty*scale), x+((sx*scale)-1), y+(ty*scale)+scale);
-				for (tsy=0; tsy<scale; tsy++)
-				{
-					for (tx=0; tx<sx; tx++)
-					{
-						for (tsx=0; tsx<scale; tsx++)
-						{
-							tftPushColor(data[(ty*sx)+tx]);
-						}
-					}
-				}
-			}
+			src = tx / scale;
+			line[tx] = data[(ty*sx) + (mirror ? (sx-1-src) : src)];
 		}
-		else
+		for (tsy=0; tsy<scale; tsy++)
 		{
-			for (ty=0; ty<sy; ty++)
-			{
-				for (tsy=0; tsy<scale; tsy++)
-				{
-					tftSetAddrWindow(x, y+(ty*scale)+tsy, x+((sx*scale)-1), y+(ty*scale)+tsy);
-					for (tx=sx-1; tx>=0; tx--)
-					{
-						for (tsx=0; tsx<scale; tsx++)
-						{
-							tftPushColor(data[(ty*sx)+tx]);
-						}
-					}
-				}
-			}
+			tftDmaPush(tft, line, w, true);
 		}
+		buf ^= 1;
 	}
+	tftDmaEnd(tft);
 }
 
 
@@ -1065,7 +1616,7 @@ void tftDrawBitmap(int x, int y, int sx, int sy, bitmapdatatype data, int scale)
  * rox is x-position of rotation origin
  * roy is y-position of rotation origin
 */
-void tftDrawBitmapRotate(int x, int y, int sx, int sy, bitmapdatatype data, int deg, int rox, int roy)
+void st7735DrawBitmapRotate(ST7735_t *tft, int x, int y, int sx, int sy, bitmapdatatype data, int deg, int rox, int roy)
 {
 	int tx, ty, newx, newy;
 	double radian;
@@ -1073,7 +1624,7 @@ void tftDrawBitmapRotate(int x, int y, int sx, int sy, bitmapdatatype data, int
 
 	if (deg==0)
 	{
-		tftDrawBitmap(x, y, sx, sy, data, 1);
+		st7735DrawBitmap(tft, x, y, sx, sy, data, 1);
 	}
 	else
 	{
@@ -1084,8 +1635,8 @@ void tftDrawBitmapRotate(int x, int y, int sx, int sy, bitmapdatatype data, int
 				newx=x+rox+(((tx-rox)*cos(radian))-((ty-roy)*sin(radian)));
 				newy=y+roy+(((ty-roy)*cos(radian))+((tx-rox)*sin(radian)));
 
-				tftSetAddrWindow(newx, newy, newx, newy);
-				tftPushColor(data[(ty*sx)+tx]);
+				st7735SetAddrWindow(tft, newx, newy, newx, newy);
+				st7735PushColor(tft, data[(ty*sx)+tx]);
 			}
 		}
 	}
@@ -1096,13 +1647,13 @@ void tftDrawBitmapRotate(int x, int y, int sx, int sy, bitmapdatatype data, int
 /* Function that sets the font
  * fonts are listed in DefaultFonts.h
 */
-void tftSetFont(uint8_t* font)
+void st7735SetFont(ST7735_t *tft, uint8_t* font)
 {
-	cfont.font=font;
-	cfont.x_size=font[0];
-	cfont.y_size=font[1];
-	cfont.offset=font[2];
-	cfont.numchars=font[3];
+	tft->font.font=font;
+	tft->font.x_size=font[0];
+	tft->font.y_size=font[1];
+	tft->font.offset=font[2];
+	tft->font.numchars=font[3];
 }
 
 
@@ -1111,69 +1662,217 @@ void tftSetFont(uint8_t* font)
  * x is x position of character
  * y is y position of character
 */
-void tftSetColor(uint16_t FontColor, uint16_t BackColor)
+void st7735SetColor(ST7735_t *tft, uint16_t FontColor, uint16_t BackColor)
 {
-	_fg = FontColor;
-	_bg = BackColor;
+	tft->fg = FontColor;
+	tft->bg = BackColor;
 }
 
-void tftPrintChar(uint8_t charval, int x, int y)
+// expands bytes of 1 bpp glyph data into RGB565 pixels, MSB is the left pixel
+static uint16_t *tftGlyphExpand(ST7735_t *tft, const uint8_t *glyph, uint16_t bytes, uint16_t *dst)
 {
-	uint8_t i,ch,fz;
-	uint16_t j;
-	uint16_t temp;
-	int zz;
+	uint8_t i, bits;
 
-	if(cfont.x_size < 8)
+	while (bytes--)
 	{
-		fz = cfont.x_size;
+		bits = *glyph++;
+		for (i = 0; i < 8; i++)
+		{
+			*dst++ = (bits & 0x80) ? tft->fg : tft->bg;
+			bits <<= 1;
+		}
 	}
-	else
+	return dst;
+}
+
+#ifdef TFT_GLYPH_CACHE_BYTES
+/*
+ * LRU cache of expanded glyphs for opaque text, key is (font, char, fg, bg).
+ * The images lie packed in tftGlyphPool in the order of tftGlyphTab; an evicted image is
+ * removed by moving the following ones down, so there are no gaps. Misses and evictions
+ * cost a memmove, hits one DMA burst from the pool.
+ */
+typedef struct
+{
+	const uint8_t	*font;
+	uint16_t		fg;
+	uint16_t		bg;
+	uint16_t		offset;			// first pixel in tftGlyphPool
+	uint16_t		num;			// pixels
+	uint32_t		used;			// LRU time stamp
+	uint8_t			charval;
+} TFT_GLYPH_t;
+
+static uint16_t tftGlyphPool[TFT_GLYPH_CACHE_BYTES / sizeof(uint16_t)];
+static TFT_GLYPH_t tftGlyphTab[TFT_GLYPH_CACHE_ENTRIES];
+static uint8_t tftGlyphNum = 0;
+static uint16_t tftGlyphFill = 0;	// used pixels of the pool
+static uint32_t tftGlyphClock = 0;
+static TFT_GLYPH_CACHE_STATS_t tftGlyphStats;
+
+static void tftGlyphEvict(uint8_t k)
+{
+	uint16_t off = tftGlyphTab[k].offset;
+	uint16_t num = tftGlyphTab[k].num;
+	uint8_t i;
+
+	memmove(&tftGlyphPool[off], &tftGlyphPool[off + num], (tftGlyphFill - off - num) * sizeof(uint16_t));
+	for (i = k; i < tftGlyphNum - 1; i++)
 	{
-		fz = cfont.x_size/8;
+		tftGlyphTab[i] = tftGlyphTab[i + 1];
+		tftGlyphTab[i].offset -= num;
 	}
-	if (!_transparent)
-	{
-		tftSetAddrWindow(x,y,x+cfont.x_size-1,y+cfont.y_size-1);
-		temp=((charval-cfont.offset)*((fz)*cfont.y_size))+4;
+	tftGlyphNum--;
+	tftGlyphFill -= num;
+	tftGlyphStats.evictions++;
+}
 
-		for(j=0;j<((fz)*cfont.y_size);j++)
+/* returns the expanded image of the character in the current font and colors,
+ * NULL if the glyph is larger than the pool
+ */
+static const uint16_t *tftGlyphGet(ST7735_t *tft, const uint8_t *glyph, uint8_t charval, uint16_t bytes)
+{
+	TFT_GLYPH_t *e;
+	uint16_t num = bytes * 8;
+	uint8_t i, lru;
+
+	for (i = 0; i < tftGlyphNum; i++)
+	{
+		e = &tftGlyphTab[i];
+		if ((e->charval == charval) && (e->font == tft->font.font) && (e->fg == tft->fg) && (e->bg == tft->bg))
 		{
-			ch = cfont.font[temp];
+			e->used = ++tftGlyphClock;
+			tftGlyphStats.hits++;
+			return &tftGlyphPool[e->offset];
+		}
+	}
+	tftGlyphStats.misses++;
+	if (num > sizeof(tftGlyphPool) / sizeof(uint16_t))
+	{
+		return NULL;
+	}
+	while ((tftGlyphNum == TFT_GLYPH_CACHE_ENTRIES) ||
+		   (tftGlyphFill + num > sizeof(tftGlyphPool) / sizeof(uint16_t)))
+	{
+		lru = 0;
+		for (i = 1; i < tftGlyphNum; i++)
+		{
+			if (tftGlyphTab[i].used < tftGlyphTab[lru].used)
+			{
+				lru = i;
+			}
+		}
+		tftGlyphEvict(lru);
+	}
+	e = &tftGlyphTab[tftGlyphNum++];
+	e->font    = tft->font.font;
+	e->charval = charval;
+	e->fg      = tft->fg;
+	e->bg      = tft->bg;
+	e->offset  = tftGlyphFill;
+	e->num     = num;
+	e->used    = ++tftGlyphClock;
+	tftGlyphFill += num;
+	tftGlyphExpand(tft, glyph, bytes, &tftGlyphPool[e->offset]);
+	return &tftGlyphPool[e->offset];
+}
 
-			for(i=0;i<8;i++)
+void tftGlyphCacheClear(void)
+{
+	tftGlyphNum  = 0;
+	tftGlyphFill = 0;
+	memset(&tftGlyphStats, 0, sizeof(tftGlyphStats));
+}
+
+// hits, misses and evictions since tftGlyphCacheClear(), bytes in use
+void tftGlyphCacheGetStats(TFT_GLYPH_CACHE_STATS_t *stats)
+{
+	*stats = tftGlyphStats;
+	stats->bytesUsed = tftGlyphFill * sizeof(uint16_t);
+}
+#endif /* TFT_GLYPH_CACHE_BYTES */
+
+/* text mode: transparent characters draw only the set pixels, the background stays visible
+ */
+void st7735SetTransparent(ST7735_t *tft, uint8_t on)
+{
+	tft->transparent = (on != 0);
+}
+
+/*
+ * Glyph blitter: the font bits are expanded row by row into RGB565.
+ * opaque:      one address window per character, as many complete rows as fit into the line
+ *              buffer are sent with one DMA transfer (SmallFont 20, BigFont 10, SevenSegNumFont 5),
+ *              with TFT_GLYPH_CACHE_BYTES a cached image is sent as a whole
+ * transparent: runs of set pixels in a row form a span, one address window per span instead
+ *              of one per pixel
+ */
+void st7735PrintChar(ST7735_t *tft, uint8_t charval, int x, int y)
+{
+	const uint8_t *glyph;
+	uint8_t fz, w, i, run;
+	uint16_t j, rows;
+	uint8_t buf = 0;
+#ifdef TFT_GLYPH_CACHE_BYTES
+	const uint16_t *img;
+#endif
+
+	if(tft->font.x_size < 8)
+	{
+		fz = tft->font.x_size;
+	}
+	else
+	{
+		fz = tft->font.x_size/8;
+	}
+	w = fz * 8;						// pixels per glyph row
+	glyph = &tft->font.font[((charval-tft->font.offset)*((fz)*tft->font.y_size))+4];
+
+	if (!tft->transparent)
+	{
+		st7735SetAddrWindow(tft, x,y,x+tft->font.x_size-1,y+tft->font.y_size-1);
+#ifdef TFT_GLYPH_CACHE_BYTES
+		img = tftGlyphGet(tft, glyph, charval, fz * tft->font.y_size);
+		if (img != NULL)
+		{
+			tftPushPixels(tft, img, (uint32_t) w * tft->font.y_size);
+			return;
+		}
+#endif
+		rows = TFT_LINE_BUF / w;
+		tftDmaBegin(tft);
+		for (j = 0; j < tft->font.y_size; j += rows)
+		{
+			if (rows > tft->font.y_size - j)
 			{
-				if((ch&(1<<(7-i)))!=0)
-				{
-					tftPushColor(_fg);
-				}
-				else
-				{
-					tftPushColor(_bg);
-				}
+				rows = tft->font.y_size - j;
 			}
-			temp++;
+			tftGlyphExpand(tft, glyph, rows * fz, tftLineBuf[buf]);
+			glyph += rows * fz;
+			tftDmaPush(tft, tftLineBuf[buf], rows * w, true);
+			buf ^= 1;
 		}
+		tftDmaEnd(tft);
 	}
 	else
 	{
-		temp=((charval-cfont.offset)*((fz)*cfont.y_size))+4;
-		for(j=0;j<cfont.y_size;j++)
+		for (j = 0; j < tft->font.y_size; j++)
 		{
-			for (zz=0; zz<(fz); zz++)
+			run = 0;
+			for (i = 0; i <= w; i++)
 			{
-				ch = cfont.font[temp+zz];
-				for(i=0;i<8;i++)
+				if ((i < w) && (glyph[i >> 3] & (0x80 >> (i & 7))))
 				{
-					tftSetAddrWindow(x+i+(zz*8),y+j,x+i+(zz*8)+1,y+j+1);
-
-					if((ch&(1<<(7-i)))!=0)
-					{
-						tftPushColor(_fg);
-					}
+					run++;
+				}
+				else if (run > 0)
+				{
+					st7735SetAddrWindow(tft, x+i-run, y+j, x+i-1, y+j);
+					tftPushRepeated(tft, tft->fg, run);
+					run = 0;
 				}
 			}
-			temp+=(fz);
+			glyph += fz;
 		}
 	}
 }
@@ -1186,7 +1885,7 @@ void tftPrintChar(uint8_t charval, int x, int y)
  * pos is the position of that character in a text (number of preceding characters)
  * deg is the rotation angle in degree
 */
-void tftRotateChar(uint8_t charval, int x, int y, int pos, int deg)
+void st7735RotateChar(ST7735_t *tft, uint8_t charval, int x, int y, int pos, int deg)
 {
 	uint8_t i,j,ch,fz;
 	uint16_t temp;
@@ -1194,37 +1893,37 @@ void tftRotateChar(uint8_t charval, int x, int y, int pos, int deg)
 	double radian = deg*0.0175;
 	int zz;
 
-	if(cfont.x_size < 8)
+	if(tft->font.x_size < 8)
 	{
-		fz = cfont.x_size;
+		fz = tft->font.x_size;
 	}
 	else
 	{
-	fz = cfont.x_size/8;
-	temp=((charval-cfont.offset)*((fz)*cfont.y_size))+4;
+	fz = tft->font.x_size/8;
+	temp=((charval-tft->font.offset)*((fz)*tft->font.y_size))+4;
 	}
-	for(j=0; j<cfont.y_size; j++)
+	for(j=0; j<tft->font.y_size; j++)
 	{
 		for (zz=0;zz<(fz);zz++)
 		{
-			ch = cfont.font[temp+zz];
+			ch = tft->font.font[temp+zz];
 
 			for(i=0;i<8;i++)
 			{
-				newx=x+(((i+(zz*8)+(pos*cfont.x_size))*cos(radian))-((j)*sin(radian)));
-				newy=y+(((j)*cos(radian))+((i+(zz*8)+(pos*cfont.x_size))*sin(radian)));
+				newx=x+(((i+(zz*8)+(pos*tft->font.x_size))*cos(radian))-((j)*sin(radian)));
+				newy=y+(((j)*cos(radian))+((i+(zz*8)+(pos*tft->font.x_size))*sin(radian)));
 
-				tftSetAddrWindow(newx,newy,newx+1,newy+1);
+				st7735SetAddrWindow(tft, newx,newy,newx+1,newy+1);
 
 				if((ch&(1<<(7-i)))!=0)
 				{
-					tftPushColor(_fg);
+					st7735PushColor(tft, tft->fg);
 				}
 				else
 				{
-					if (!_transparent)
+					if (!tft->transparent)
 					{
-						tftPushColor(_bg);
+						st7735PushColor(tft, tft->bg);
 					}
 				}
 			}
@@ -1240,11 +1939,11 @@ void tftRotateChar(uint8_t charval, int x, int y, int pos, int deg)
  * y is y-coordinate in pixels
  * deg is angle of rotation in degree
 */
-void tftPrintInt(int value,int x, int y, int deg)
+void st7735PrintInt(ST7735_t *tft, int value,int x, int y, int deg)
 {
 	char buffer[100];
 	sprintf(buffer,"%d",value);
-	tftPrint(buffer,x,y,deg);
+	st7735Print(tft, buffer,x,y,deg);
 }
 
 
@@ -1254,11 +1953,11 @@ void tftPrintInt(int value,int x, int y, int deg)
  * y is y-coordinate in pixels
  * deg is angle of rotation in degree
 */
-void tftPrintLong(long value,int x, int y, int deg)
+void st7735PrintLong(ST7735_t *tft, long value,int x, int y, int deg)
 {
 	char buffer[100];
 	sprintf(buffer,"%ld",value);
-	tftPrint(buffer,x,y,deg);
+	st7735Print(tft, buffer,x,y,deg);
 }
 
 
@@ -1268,11 +1967,11 @@ void tftPrintLong(long value,int x, int y, int deg)
  * y is y-coordinate in pixels
  * deg is angle of rotation in degree
 */
-void tftPrintFloat(float value,int x, int y, int deg)
+void st7735PrintFloat(ST7735_t *tft, float value,int x, int y, int deg)
 {
 	char buffer[100];
 	sprintf(buffer,"%lf",value);
-	tftPrint(buffer,x,y,deg);
+	st7735Print(tft, buffer,x,y,deg);
 }
 
 
@@ -1282,11 +1981,11 @@ void tftPrintFloat(float value,int x, int y, int deg)
  * y is y-coordinate in pixels
  * deg is angle of rotation in degree
 */
-void tftPrintDouble(double value,int x, int y, int deg)
+void st7735PrintDouble(ST7735_t *tft, double value,int x, int y, int deg)
 {
 	char buffer[100];
 	sprintf(buffer,"%lf",value);
-	tftPrint(buffer,x,y,deg);
+	st7735Print(tft, buffer,x,y,deg);
 }
 
 
@@ -1297,7 +1996,7 @@ void tftPrintDouble(double value,int x, int y, int deg)
  * y is y-coordinate in pixels
  * deg is angle of rotation in degree
 */
-void tftPrint(char *st, int x, int y, int deg)
+void st7735Print(ST7735_t *tft, char *st, int x, int y, int deg)
 {
 	int stl, i;
 	int lettercount = 0;
@@ -1309,11 +2008,11 @@ void tftPrint(char *st, int x, int y, int deg)
 
 	if (x==RIGHT)
 	{
-		x=(width+1)-(stl*cfont.x_size);
+		x=(tft->width+1)-(stl*tft->font.x_size);
 	}
 	if (x==CENTER)
 	{
-		x=((height+1)-(stl*cfont.x_size))/2;
+		x=((tft->height+1)-(stl*tft->font.x_size))/2;
 	}
 	for (i=0;i<stl;i++) // write each character of string onto screen
 	{
@@ -1322,23 +2021,23 @@ void tftPrint(char *st, int x, int y, int deg)
 		// check wheter char shall be rotated
 		if (deg==0)
 		{
-			tftPrintChar(*st++,xvalue, y);
-			xvalue=x+(lettercount*(cfont.x_size)); // go to next letter position in x direction
+			st7735PrintChar(tft, *st++,xvalue, y);
+			xvalue=x+(lettercount*(tft->font.x_size)); // go to next letter position in x direction
 		}
 		else
 		{
-			tftRotateChar(*st++, x, y, i, deg);
+			st7735RotateChar(tft, *st++, x, y, i, deg);
 		}
-		if(lettercount>((tftGetWidth()/cfont.x_size)-1)) //check if max letters in one line is reached
+		if(lettercount>((st7735GetWidth(tft)/tft->font.x_size)-1)) //check if max letters in one line is reached
 		{
 			xvalue=0; //if so set x to zero
 			lettercount=0;
-			yvalue=y+cfont.y_size;
+			yvalue=y+tft->font.y_size;
 
-			if(yvalue>(tftGetHeight()-cfont.y_size)) // check if max letters on screen is reached
+			if(yvalue>(st7735GetHeight(tft)-tft->font.y_size)) // check if max letters on screen is reached
 			{
 				delayms(2000); // if so wait for 2s
-				tftFillScreen(tft_BLACK); // clear screen
+				st7735FillScreen(tft, tft_BLACK); // clear screen
 				y=0; // start at top left of new Page
 			}
 			else
@@ -1350,12 +2049,12 @@ void tftPrint(char *st, int x, int y, int deg)
 
 	}
 }
-void tftPrintColor(char *st, int x, int y, uint16_t FontColor)
+void st7735PrintColor(ST7735_t *tft, char *st, int x, int y, uint16_t FontColor)
 {
-	uint16_t _fg_old = _fg;
-	_fg = FontColor;
-	tftPrint(st, x, y, 0);
-	_fg = _fg_old;
+	uint16_t _fg_old = tft->fg;
+	tft->fg = FontColor;
+	st7735Print(tft, st, x, y, 0);
+	tft->fg = _fg_old;
 }
 
 
@@ -1367,9 +2066,9 @@ void tftPrintColor(char *st, int x, int y, uint16_t FontColor)
 
 
 // Function that fills screen with one color
-void tftFillScreen(uint16_t color)
+void st7735FillScreen(ST7735_t *tft, uint16_t color)
 {
-	tftFillRect(0, 0,width,height, color);
+	st7735FillRect(tft, 0, 0,tft->width,tft->height, color);
 }
 
 
@@ -1385,39 +2084,39 @@ uint16_t tftColor565(uint8_t r, uint8_t g, uint8_t b)
  * LANDSCAPE: x_max=160px y_max=128px
  * choose Between: PORTRAIT; POTRAIT_FLIP; LANDSCAPE; LANDSCAPE_FLIP
  */
-void tftSetRotation(uint8_t m)
+void st7735SetRotation(ST7735_t *tft, uint8_t m)
 {
 	uint8_t rotation = m % 4; // can't be higher than 3
-	tftSendCmd(ST7735_MADCTL);
+	st7735SendCmd(tft, ST7735_MADCTL);
 
 	switch (rotation)
 	{
 		case PORTRAIT:
 		{
-		tftSendData(MADCTL_MX | MADCTL_MY | MADCTL_RGB);
-		width  = ST7735_TFTWIDTH;
-		height = ST7735_TFTHEIGHT;
+		st7735SendData(tft, MADCTL_MX | MADCTL_MY | MADCTL_RGB);
+		tft->width  = ST7735_TFTWIDTH;
+		tft->height = ST7735_TFTHEIGHT;
 		break;
 		}
 	   case LANDSCAPE:
 	   {
-		   tftSendData(MADCTL_MY | MADCTL_MV | MADCTL_RGB);
-		   width  = ST7735_TFTHEIGHT;
-		   height = ST7735_TFTWIDTH;
+		   st7735SendData(tft, MADCTL_MY | MADCTL_MV | MADCTL_RGB);
+		   tft->width  = ST7735_TFTHEIGHT;
+		   tft->height = ST7735_TFTWIDTH;
 		   break;
 	   }
 	   case PORTRAIT_FLIP:
 	   {
-		   tftSendData(MADCTL_RGB);
-		   width  = ST7735_TFTWIDTH;
-		   height = ST7735_TFTHEIGHT;
+		   st7735SendData(tft, MADCTL_RGB);
+		   tft->width  = ST7735_TFTWIDTH;
+		   tft->height = ST7735_TFTHEIGHT;
 		   break;
 	   }
 	   case LANDSCAPE_FLIP:
 	   {
-		   tftSendData(MADCTL_MX | MADCTL_MV | MADCTL_RGB);
-		   width  = ST7735_TFTHEIGHT;
-		   height = ST7735_TFTWIDTH;
+		   st7735SendData(tft, MADCTL_MX | MADCTL_MV | MADCTL_RGB);
+		   tft->width  = ST7735_TFTHEIGHT;
+		   tft->height = ST7735_TFTWIDTH;
 		   break;
 	   }
 	   default:
@@ -1426,46 +2125,349 @@ void tftSetRotation(uint8_t m)
 	   }
 	}
 
-	orientation = m;
+	tft->orientation = m;
+#ifdef TFT_FRAMEBUFFER
+	if (tft == &tftDefault)
+	{
+		tftFbDirtyNum = 0;			// line length changed, the content has to be redrawn
+	}
+#endif
 }
 
 
 // function that inverts DisplayColors
-void tftInvertDisplay(const uint8_t mode)
+void st7735InvertDisplay(ST7735_t *tft, const uint8_t mode)
 {
 	if( mode == INVERT_ON )
 	{
-		tftSendCmd(ST7735_INVON);
+		st7735SendCmd(tft, ST7735_INVON);
 
 	}
 	else if( mode == INVERT_OFF )
 	{
-		tftSendCmd(ST7735_INVOFF);
+		st7735SendCmd(tft, ST7735_INVOFF);
+	}
+}
+
+
+/*
+ * Hardware scroll: the panel scrolls along its gate lines (memory rows), i.e. vertically in
+ * PORTRAIT and horizontally in LANDSCAPE. Display line n shows memory line
+ * (vsp + n) mod vsa within the scroll area, nothing is copied on the bus.
+ */
+static void tftCmd16(ST7735_t *tft, uint8_t cmd, const uint16_t *param, uint8_t num)
+{
+	spiBeginSession(tft->spi, tft->io->CS_PORT, tft->io->CS, SPI_DATA_8_BIT);
+	_DC0(tft);
+	spiSessionWrite8(tft->spi, cmd);
+	spiSessionFlush(tft->spi);
+	_DC1(tft);
+	spiSwitchDataLen(tft->spi, SPI_DATA_16_BIT);
+	spiSessionWrite(tft->spi, param, num);
+	spiEndSession(tft->spi, tft->io->CS_PORT, tft->io->CS);
+}
+
+// number of memory lines along the scroll direction: 162 with rowstart = 1 of the green tab, 160 for the red tab
+uint16_t st7735ScrollLines(ST7735_t *tft)
+{
+	return ST7735_TFTHEIGHT + 2 * tft->rowstart;
+}
+
+/* tfa: fixed lines at the start, vsa: scrolling lines, bfa: fixed lines at the end
+ * tfa + vsa + bfa = tftScrollLines()
+ */
+void st7735ScrollDefine(ST7735_t *tft, uint16_t tfa, uint16_t vsa, uint16_t bfa)
+{
+	uint16_t param[3] = { tfa, vsa, bfa };
+
+	tftCmd16(tft, ST7735_VSCRDEF, param, 3);
+}
+
+// vsp: memory line shown as first line of the scroll area
+void st7735ScrollTo(ST7735_t *tft, uint16_t vsp)
+{
+	tftCmd16(tft, ST7735_VSCRSADD, &vsp, 1);
+}
+
+/* address window on one memory line, independent of the scroll position
+ * line: memory line (0 ... tftScrollLines() - 1)
+ * from, to: screen coordinates across the line (x in PORTRAIT, y in LANDSCAPE)
+ */
+void st7735ScrollLineWindow(ST7735_t *tft, uint16_t line, uint8_t from, uint8_t to)
+{
+	uint8_t rot = tft->orientation % 4;
+	uint16_t addr = line;
+
+	if ((rot == PORTRAIT) || (rot == LANDSCAPE))
+	{
+		addr = st7735ScrollLines(tft) - 1 - line;		// MY mirrors the memory lines
+	}
+#ifdef TFT_FRAMEBUFFER
+	if (tftFbActive(tft))
+	{
+		return;									// the framebuffer has no scroll position
+	}
+#endif
+	if ((rot == PORTRAIT) || (rot == PORTRAIT_FLIP))
+	{
+		tftWindow(tft, from+tft->colstart, to+tft->colstart, addr, addr);
+	}
+	else
+	{
+		tftWindow(tft, addr, addr, from+tft->rowstart, to+tft->rowstart);
 	}
 }
 
 
 // tft off currently means only background light activated
-void tftOff()
+void st7735Off(ST7735_t *tft)
 {
-	tftSendCmd(ST7735_DISPOFF);
+	st7735SendCmd(tft, ST7735_DISPOFF);
 }
 
 
 // turn on display
-void tftOn()
+void st7735On(ST7735_t *tft)
 {
-	tftSendCmd(ST7735_DISPON);
+	st7735SendCmd(tft, ST7735_DISPON);
 }
 
 
-uint8_t tftGetWidth()
+uint8_t st7735GetWidth(ST7735_t *tft)
+{
+	return(tft->width); // width depends on Rotation Mode
+}
+
+
+uint8_t st7735GetHeight(ST7735_t *tft)
+{
+	return(tft->height); // height depends on Rotation Mode
+}
+
+
+/********************************************************************
+*********************************************************************
+***************** Interface of the default display ******************
+*********************************************************************
+*********************************************************************/
+
+// context of the default display, e.g. for modules with an st7735... interface
+ST7735_t *tftGetDisplay(void)
+{
+	return &tftDefault;
+}
+
+void tftSPISenddata(const uint8_t data)
+{
+	st7735SPISenddata(&tftDefault, data);
+}
+
+void tftSPISenddata16(const uint16_t data)
+{
+	st7735SPISenddata16(&tftDefault, data);
+}
+
+void tftSendCmd(const uint8_t cmd)
+{
+	st7735SendCmd(&tftDefault, cmd);
+}
+
+void tftSendData(const uint8_t data)
+{
+	st7735SendData(&tftDefault, data);
+}
+
+void IOspiInit(ST7735io_t *TFTset)
+{
+	st7735IoInit(&tftDefault, TFTset);
+}
+
+void tftInitR(uint8_t options)
+{
+	st7735InitR(&tftDefault, options);
+}
+
+void tftSetAddrWindow(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1)
+{
+	st7735SetAddrWindow(&tftDefault, x0, y0, x1, y1);
+}
+
+void tftPushColor(uint16_t color)
+{
+	st7735PushColor(&tftDefault, color);
+}
+
+void tftStreamBegin(void)
+{
+	st7735StreamBegin(&tftDefault);
+}
+
+void tftStreamPush(const uint16_t *pix, uint16_t num)
+{
+	st7735StreamPush(&tftDefault, pix, num);
+}
+
+void tftStreamEnd(void)
+{
+	st7735StreamEnd(&tftDefault);
+}
+
+void tftDrawPixel(int16_t x, int16_t y, uint16_t color)
+{
+	st7735DrawPixel(&tftDefault, x, y, color);
+}
+
+void tftFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+	st7735FillRect(&tftDefault, x, y, w, h, color);
+}
+
+void tftDrawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+{
+	st7735DrawFastVLine(&tftDefault, x, y, h, color);
+}
+
+void tftDrawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+{
+	st7735DrawFastHLine(&tftDefault, x, y, w, color);
+}
+
+void tftDrawFastLine(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint16_t color)
+{
+	st7735DrawFastLine(&tftDefault, x1, y1, x2, y2, color);
+}
+
+void tftDrawRect(uint8_t x1,uint8_t y1,uint8_t x2,uint8_t y2, uint16_t color)
+{
+	st7735DrawRect(&tftDefault, x1, y1, x2, y2, color);
+}
+
+void tftDrawCircle(int16_t x, int16_t y, int radius, uint16_t color)
+{
+	st7735DrawCircle(&tftDefault, x, y, radius, color);
+}
+
+void tftFillCircle(int16_t x, int16_t y, int radius, uint16_t color)
+{
+	st7735FillCircle(&tftDefault, x, y, radius, color);
+}
+
+void tftDrawBitmap(int x, int y, int sx, int sy, bitmapdatatype data, int scale)
+{
+	st7735DrawBitmap(&tftDefault, x, y, sx, sy, data, scale);
+}
+
+void tftDrawBitmapRotate(int x, int y, int sx, int sy, bitmapdatatype data, int deg, int rox, int roy)
+{
+	st7735DrawBitmapRotate(&tftDefault, x, y, sx, sy, data, deg, rox, roy);
+}
+
+void tftSetFont(uint8_t* font)
+{
+	st7735SetFont(&tftDefault, font);
+}
+
+void tftSetColor(uint16_t FontColor, uint16_t BackColor)
+{
+	st7735SetColor(&tftDefault, FontColor, BackColor);
+}
+
+void tftSetTransparent(uint8_t on)
+{
+	st7735SetTransparent(&tftDefault, on);
+}
+
+void tftPrintChar(uint8_t charval, int x, int y)
+{
+	st7735PrintChar(&tftDefault, charval, x, y);
+}
+
+void tftRotateChar(uint8_t charval, int x, int y, int pos, int deg)
+{
+	st7735RotateChar(&tftDefault, charval, x, y, pos, deg);
+}
+
+void tftPrintInt(int value,int x, int y, int deg)
+{
+	st7735PrintInt(&tftDefault, value, x, y, deg);
+}
+
+void tftPrintLong(long value,int x, int y, int deg)
+{
+	st7735PrintLong(&tftDefault, value, x, y, deg);
+}
+
+void tftPrintFloat(float value,int x, int y, int deg)
+{
+	st7735PrintFloat(&tftDefault, value, x, y, deg);
+}
+
+void tftPrintDouble(double value,int x, int y, int deg)
+{
+	st7735PrintDouble(&tftDefault, value, x, y, deg);
+}
+
+void tftPrint(char *st, int x, int y, int deg)
+{
+	st7735Print(&tftDefault, st, x, y, deg);
+}
+
+void tftPrintColor(char *st, int x, int y, uint16_t FontColor)
+{
+	st7735PrintColor(&tftDefault, st, x, y, FontColor);
+}
+
+void tftFillScreen(uint16_t color)
+{
+	st7735FillScreen(&tftDefault, color);
+}
+
+void tftSetRotation(uint8_t m)
+{
+	st7735SetRotation(&tftDefault, m);
+}
+
+void tftInvertDisplay(const uint8_t mode)
+{
+	st7735InvertDisplay(&tftDefault, mode);
+}
+
+uint16_t tftScrollLines(void)
+{
+	return st7735ScrollLines(&tftDefault);
+}
+
+void tftScrollDefine(uint16_t tfa, uint16_t vsa, uint16_t bfa)
+{
+	st7735ScrollDefine(&tftDefault, tfa, vsa, bfa);
+}
+
+void tftScrollTo(uint16_t vsp)
 {
-	return(width); // width depends on Rotation Mode
+	st7735ScrollTo(&tftDefault, vsp);
 }
 
+void tftScrollLineWindow(uint16_t line, uint8_t from, uint8_t to)
+{
+	st7735ScrollLineWindow(&tftDefault, line, from, to);
+}
+
+void tftOff()
+{
+	st7735Off(&tftDefault);
+}
+
+void tftOn()
+{
+	st7735On(&tftDefault);
+}
+
+uint8_t tftGetWidth()
+{
+	return st7735GetWidth(&tftDefault);
+}
 
 uint8_t tftGetHeight()
 {
-	return(height); // height depends on Rotation Mode
+	return st7735GetHeight(&tftDefault);
 }
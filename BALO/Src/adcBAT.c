@@ -188,11 +188,22 @@ uint8_t *convDecByteToHex(uint8_t byte)
  *
  */
 uint8_t I2C_SCAN(I2C_TypeDef *i2c, uint8_t scanAddr)
+{
+	uint8_t foundAddr = 0;
+
+	foundAddr = i2cFindSlaveAddr(i2c, scanAddr);
+	I2C_SCAN_SHOW(i2c, scanAddr, foundAddr);
+	return foundAddr;
+}
+
+/* Display part of I2C_SCAN, e.g. for the result of i2cScanBus().
+ * scanAdr 0 restarts the list of the port, found addresses are listed one per line.
+ */
+void I2C_SCAN_SHOW(I2C_TypeDef *i2c, uint8_t scanAddr, uint8_t foundAddr)
 {
 	uint8_t 	*outString2 = (uint8_t *) "Addr at: \0";
 	uint8_t     port, *result;
 #define yPosBase 18
-	uint8_t foundAddr = 0;
 	static int xPos[2] = {0,100};
 	static int yPos[2] = {yPosBase, yPosBase};
 
@@ -210,7 +221,6 @@ uint8_t I2C_SCAN(I2C_TypeDef *i2c, uint8_t scanAddr)
     yPos[1] = yPosBase;
     }
 
-	foundAddr = i2cFindSlaveAddr(i2c, scanAddr);
 	if (yPos[port] == 0)
 	{
 		tftPrint((char *)outString2,xPos[port],yPos[port],0);
@@ -231,7 +241,6 @@ uint8_t I2C_SCAN(I2C_TypeDef *i2c, uint8_t scanAddr)
 	{
 	//	tftPrint((char *)result,xPos,14,0);
 	}
-	return foundAddr;
 }
 
 // Tiefpassfilterung der drei Richtungsvektoren xyz
@@ -7,13 +7,23 @@
  */
 
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <stm32f4xx.h>
 #include <mcalGPIO.h>
 #include <mcalI2C.h>
+#include <i2cShadow.h>
 #include <i2cAMIS.h>
 
+#define AMIS_CMD_SET_MOTOR_PARAM	0x89
+#define AMIS_CMD_SET_STALL_PARAM	0x96
+
+// Shadows of the parameter commands: a setter only causes bus traffic if the payload changed
+#define AMIS_MAX_SHADOWS			4		// 2 steppers x 2 commands
+static I2C_SHADOW_t amisShadow[AMIS_MAX_SHADOWS];
+static uint8_t amisNumShadows = 0;
+
 
 // define the parameter names
 char i2cBusName[] = "i2c Bus";
@@ -112,9 +122,7 @@ void getFullStatus1(Stepper_t* stepper, uint8_t readArray[8])
 	i2c = stepper->i2cBus.i2c;
 	addr = stepper->i2cAddress.value;
 	uint8_t befehl = (uint8_t) 0x81; // 0x81 is the command to get the FullStatus1
-	i2cBurstWrite(i2c, addr, &befehl, 1);
-	//for(int i = 0; i<10000; i++){;}		// small delay
-	i2cBurstRead(i2c, addr, readArray, 8);
+	i2cWriteRead(i2c, addr, &befehl, 1, readArray, 8);	// repeated START, no STOP between command and read
 }
 
 /**
@@ -129,9 +137,69 @@ void getFullStatus2(Stepper_t* stepper, uint8_t readArray[8])
 	uint8_t addr;
 	i2c = stepper->i2cBus.i2c;
 	addr = stepper->i2cAddress.value;
-	i2cBurstWrite(i2c, addr, &befehl, 1);
-	i2cBurstRead(i2c, addr, readArray, 8);
+	i2cWriteRead(i2c, addr, &befehl, 1, readArray, 8);	// repeated START, no STOP between command and read
+}
+/**
+ * get the shadow of a parameter command of the stepper, a new one is created if required
+ * @returns NULL if all shadows are in use
+ */
+static I2C_SHADOW_t* amisGetShadow(Stepper_t* stepper, uint8_t cmd, uint8_t size)
+{
+	I2C_SHADOW_t *sh;
+	uint8_t i;
+
+	for (i = 0; i < amisNumShadows; i++)
+	{
+		sh = &amisShadow[i];
+		if ((sh->i2c == stepper->i2cBus.i2c) && (sh->saddr == stepper->i2cAddress.value) && (sh->base == cmd))
+		{
+			return sh;
+		}
+	}
+	if (amisNumShadows >= AMIS_MAX_SHADOWS)
+	{
+		return NULL;
+	}
+	sh = &amisShadow[amisNumShadows++];
+	i2cShadowInit(sh, stepper->i2cBus.i2c, stepper->i2cAddress.value, cmd, size, I2C_SHADOW_BLOCK);
+	return sh;
+}
+
+/**
+ * the parameters of the stepper are unknown (init, reset, other payload of the command),
+ * the next setter sends the complete command again
+ */
+static void amisInvalidateShadow(Stepper_t* stepper, uint8_t cmd)
+{
+	uint8_t i;
+
+	for (i = 0; i < amisNumShadows; i++)
+	{
+		if ((amisShadow[i].i2c == stepper->i2cBus.i2c) && (amisShadow[i].saddr == stepper->i2cAddress.value) &&
+			((cmd == 0) || (amisShadow[i].base == cmd)))
+		{
+			i2cShadowInvalidate(&amisShadow[i]);
+		}
+	}
+}
+
+/**
+ * writes a parameter command, suppressed if the payload has not changed since the last write
+ */
+static void amisWriteParam(Stepper_t* stepper, uint8_t data[], uint8_t len)
+{
+	I2C_SHADOW_t *sh = amisGetShadow(stepper, data[0], len - 1);
+
+	if (sh != NULL)
+	{
+		i2cShadowWriteBlock(sh, 0, &data[1], len - 1);
+	}
+	else
+	{
+		i2cBurstWrite(stepper->i2cBus.i2c, stepper->i2cAddress.value, data, len);
+	}
 }
+
 /**
  * This method is called once during initialization.
  * The motor is initially set to these values.
@@ -142,10 +210,7 @@ void getFullStatus2(Stepper_t* stepper, uint8_t readArray[8])
  */
 void setMotorParam(Stepper_t* stepper)
 {
-	I2C_TypeDef   *i2c;
-	uint8_t Addr = stepper->i2cAddress.value;
-	i2c = stepper->i2cBus.i2c;
-	uint8_t befehl = (uint8_t) 0x89;
+	uint8_t befehl = (uint8_t) AMIS_CMD_SET_MOTOR_PARAM;
 	uint8_t data[8];
 
 	data[0] = befehl;
@@ -159,14 +224,11 @@ void setMotorParam(Stepper_t* stepper)
 	data[7] = 0b10100010 | ((stepper->pwmFrequency.value) << 6) | ((stepper->accelerationShape.value) << 4) | ((stepper->stepMode.value) << 2) | (stepper->pwmJitter.value);
 								// uint8_t 1|w|1|x|yy|1|z  w=pwmFrequency x=accelerationShape y=stepMode z=pwmJitter
 
-	i2cBurstWrite(i2c, Addr, data, 8);
+	amisWriteParam(stepper, data, 8);	// only sent if a parameter changed
 }
 void setStallParam5(Stepper_t* stepper)
 {
-	I2C_TypeDef   *i2c;
-	uint8_t Addr = stepper->i2cAddress.value;
-	i2c = stepper->i2cBus.i2c;
-	uint8_t befehl = (uint8_t) 0x96;
+	uint8_t befehl = (uint8_t) AMIS_CMD_SET_STALL_PARAM;
 	uint8_t data[6];
 
 	data[0] = befehl;
@@ -175,7 +237,7 @@ void setStallParam5(Stepper_t* stepper)
 	data[3] = (stepper->iRun.value << 4) | (stepper->iHold.value);		// uint8_t xxxx|yyyy x=iRun y=iHold
 	data[4] = (stepper->vMax.value << 4) | (stepper->vMin.value);			// uint8_t xxxx|yyyy x=vMax y=vMin
 	data[5] = ((stepper->securePosition.value >> 3)& 0b1110000) | ((stepper->rotationDirection.value & 0b1)<< 4) | (stepper->acceleration.value);		// uint8_t xxx|y|zzzz   XXXXXXX  z=acceleration(3:0)
-	i2cBurstWrite(i2c, Addr, data, 6);
+	amisWriteParam(stepper, data, 6);	// only sent if a parameter changed
 }
 void setStallParam(Stepper_t* stepper)
 {
@@ -196,6 +258,7 @@ void setStallParam(Stepper_t* stepper)
 	data[7] = 0b10100010 | (stepper->pwmFrequency.value << 6) | (stepper->accelerationShape.value << 4) | (stepper->stepMode.value << 2) | stepper->pwmJitter.value;	// uint8_t ooo|x|yy|d|z  o=FS2Stall x=accelerationShape y=stepMode d =DC100SfEn z=pwmJitter
 	//data[7]=0b00001100;				// xxx|y|zz|xx  x=N/A y=AccShape z=stepMode
 	i2cBurstWrite(i2c, Addr, data, 4);
+	amisInvalidateShadow(stepper, AMIS_CMD_SET_STALL_PARAM);	// other payload than setStallParam5()
 }
 
 
@@ -463,8 +526,7 @@ int16_t StepperGetPos(Stepper_t* stepper)
 	uint8_t addr;
 	i2c = stepper->i2cBus.i2c;
 	addr = stepper->i2cAddress.value;
-	i2cBurstWrite(i2c, addr, &befehl, 1);
-	i2cBurstRead(i2c, addr, data, 3);
+	i2cWriteRead(i2c, addr, &befehl, 1, data, 3);		// repeated START, no STOP between command and read
 
 
 	stepper->position.value = (int16_t) ((((uint16_t) data[1]) << 8) | (uint16_t) data[2]);
@@ -616,6 +678,7 @@ void setRelativeMotionThreshold(Stepper_t* stepper, uint8_t value)
 	data[6] = 0b00001111 & stepper->relativeMotionThreshold.value; 	// xxxx|yyyy x = absolute motion threshold (use 0), y = relative motion threshold
 	data[7] = (stepper->accelerationShape.value << 4) | (stepper->stepMode.value << 2) | stepper->pwmJitter.value;	// vvv|w|xx|y|z    v = FS2StallEn (use 0), w = accelerationShape, x = stepMode, y = DC100StEn (default = 0), z = pwmJitter
 	i2cBurstWrite(i2c, Addr, data, 8); 	// send the data to the stepper
+	amisInvalidateShadow(stepper, AMIS_CMD_SET_STALL_PARAM);	// other payload than setStallParam5()
 }
 
 
@@ -699,6 +762,7 @@ void StepperResetToDefault(Stepper_t* stepper)
 	i2c = stepper->i2cBus.i2c;
 	uint8_t befehl = (uint8_t) 0x87;
 	i2cBurstWrite(i2c, Addr, &befehl, 1);
+	amisInvalidateShadow(stepper, 0);		// parameters are back to the OTP values
 }
 
 
@@ -731,6 +795,7 @@ void StepperHardStop (Stepper_t* stepper)
 	uint8_t Addr = stepper->i2cAddress.value;
 	i2c = stepper->i2cBus.i2c;
 	i2cBurstWrite(i2c, Addr, &befehl, 1);
+	amisInvalidateShadow(stepper, 0);		// init has to be executed again
 }
 
 
@@ -804,6 +869,7 @@ void StepperInit(Stepper_t* stepper, I2C_TypeDef* i2cBus, uint8_t i2cAddress, ui
 	uint8_t data[8];
 	getFullStatus1(stepper, data);
 	getFullStatus2(stepper, data);
+	amisInvalidateShadow(stepper, 0);		// always send the complete parameter set at init
 	setMotorParam(stepper);
 
 	StepperResetPosition(stepper); 			/*
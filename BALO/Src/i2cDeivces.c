@@ -34,6 +34,7 @@ void activateI2C1()
      */
     gpioSetOutputType(portB, PIN8, OPENDRAIN);   // Immer externe Pull-up-
     gpioSetOutputType(portB, PIN9, OPENDRAIN);   // Widerstaende verwenden!!!
+    i2cSetBusPins(i2c, portB, PIN8, AF4, portB, PIN9, AF4);     // for bus recovery
     // Initialisierung des I2C-Controllers
     i2cInitI2C(i2c, IC2_DUTY_CYCLE_16_9, 15, I2C_CLOCK_200);
     i2cEnableDevice(i2c);                        // MCAL I2C1 activ
@@ -56,6 +57,7 @@ void activateI2C2()
      */
     gpioSetOutputType(portB, PIN10, OPENDRAIN);   // Immer externe Pull-up-
     gpioSetOutputType(portB, PIN3, OPENDRAIN);   // Widerstaende verwenden!!!
+    i2cSetBusPins(i2c2, portB, PIN10, AF4, portB, PIN3, AF9);   // for bus recovery
     // Initialisierung des I2C-Controllers
     i2cInitI2C(i2c2, IC2_DUTY_CYCLE_16_9, 15, I2C_CLOCK_200);
     i2cEnableDevice(i2c2);                        // MCAL I2C2 activ
@@ -108,7 +110,7 @@ int8_t LIS3DHINIT(I2C_TypeDef *i2c, int8_t restart)
 			//i2cResetDevice(i2c);
 			//i2cInitI2C(i2c, I2C_DUTY_CYCLE_2, 17, I2C_CLOCK_400);
 
-			i2cSetClkSpd(i2c,  I2C_CLOCK_1Mz); //set I2C Clock 1000kHz fast Mode
+			i2cSetSlaveSpeed(i2c, i2cAddr_LIS3DH, 1000000); //set I2C Clock 1000kHz fast Mode for the LIS3DH only
 			//i2cEnableDevice(i2c);
 			step = -6;
 			break;
@@ -98,6 +98,11 @@ int8_t mpuInit(MPU6050_t* sensor, I2C_TypeDef* i2cBus, uint8_t i2cAddr, MPUfscal
 		 */
 		sensor->i2c_address = (uint8_t) i2cAddr_MPU6050;
 	}
+	if ((sensor->cfgShadow.i2c != sensor->i2c) || (sensor->cfgShadow.saddr != sensor->i2c_address))
+	{	// configuration registers are only written if changed, adjacent ones in one burst
+		i2cShadowInit(&sensor->cfgShadow, sensor->i2c, sensor->i2c_address, MPU6050_CONFIG, 3, I2C_SHADOW_REGS);
+		i2cShadowInit(&sensor->pwrShadow, sensor->i2c, sensor->i2c_address, MPU6050_PWR_MGMT_1, 2, I2C_SHADOW_REGS);
+	}
 
 	uint8_t gyroReturn;
 	gyroScale = sensor->gyro_scale;
@@ -124,7 +129,7 @@ int8_t mpuInit(MPU6050_t* sensor, I2C_TypeDef* i2cBus, uint8_t i2cAddr, MPUfscal
 		gyroReturn = 2;							// Error handling for wrong user input
 		break;
 	}
-	i2cSendByteToSlaveReg(sensor->i2c, sensor->i2c_address, MPU6050_GYRO_CONFIG, sensor->gyro_scale); 	// set scale range of gyroscope
+	i2cShadowSet(&sensor->cfgShadow, MPU6050_GYRO_CONFIG, sensor->gyro_scale); 	// set scale range of gyroscope, sent by mpuSetLpFilt()
 
 
 	uint8_t accelReturn;
@@ -152,7 +157,7 @@ int8_t mpuInit(MPU6050_t* sensor, I2C_TypeDef* i2cBus, uint8_t i2cAddr, MPUfscal
 		accelReturn = 4;
 		break;
 	}
-	i2cSendByteToSlaveReg(sensor->i2c, sensor->i2c_address, MPU6050_ACCEL_CONFIG, sensor->accel_range);	// set scale range of accelerometer
+	i2cShadowSet(&sensor->cfgShadow, MPU6050_ACCEL_CONFIG, sensor->accel_range);	// set scale range of accelerometer, sent by mpuSetLpFilt()
 
 	sensor->LowPassFilt = lPconfig;
 	mpuSetLpFilt(sensor);
@@ -162,8 +167,8 @@ int8_t mpuInit(MPU6050_t* sensor, I2C_TypeDef* i2cBus, uint8_t i2cAddr, MPUfscal
 	//TF for (int8_t i = step; i < 0; i++) {
 
 		switch (step) {
-		case -3:		// increase CLK Speed for I2C up to  1000kHz
-			i2cSetClkSpd(sensor->i2c, I2C_CLOCK_1Mz); //set I2C Clock 1Mz
+		case -3:		// increase CLK Speed for I2C up to  1000kHz, only for the MPU (speed profile)
+			i2cSetSlaveSpeed(sensor->i2c, sensor->i2c_address, 1000000); //set I2C Clock 1Mz
 			step = -2;
 			break;
 
@@ -171,6 +176,8 @@ int8_t mpuInit(MPU6050_t* sensor, I2C_TypeDef* i2cBus, uint8_t i2cAddr, MPUfscal
 			if (restart != 0)
 			{
 				i2cSendByteToSlaveReg(sensor->i2c, sensor->i2c_address, MPU6050_PWR_MGMT_1, (MPU6050_SWRESET)); // reboot memory content
+				i2cShadowInvalidate(&sensor->cfgShadow);		// registers are back to their reset values
+				i2cShadowInvalidate(&sensor->pwrShadow);
 
 			}
 			else
@@ -184,20 +191,20 @@ int8_t mpuInit(MPU6050_t* sensor, I2C_TypeDef* i2cBus, uint8_t i2cAddr, MPUfscal
 			// PWR Mngt
 			if (sensor->accel_range == ACCEL_OFF)
 			{ // Disable acceleration measurement
-				i2cSendByteToSlaveReg(sensor->i2c, sensor->i2c_address, MPU6050_PWR_MGMT_1, (MPU6050_PWR1_CLKSEL));
-				i2cSendByteToSlaveReg(sensor->i2c, sensor->i2c_address, MPU6050_PWR_MGMT_2, (0b00000111));
+				i2cShadowSet(&sensor->pwrShadow, MPU6050_PWR_MGMT_1, (MPU6050_PWR1_CLKSEL));
+				i2cShadowWrite(&sensor->pwrShadow, MPU6050_PWR_MGMT_2, (0b00000111));
 			}
 			else
 			{
 				if (sensor->gyro_scale == GYRO_OFF)
 				{ // Disable gyroscope
-					i2cSendByteToSlaveReg(sensor->i2c, sensor->i2c_address, MPU6050_PWR_MGMT_1, (MPU6050_PWR1_CLKSEL));
-					i2cSendByteToSlaveReg(sensor->i2c, sensor->i2c_address, MPU6050_PWR_MGMT_2, (0b00111000));
+					i2cShadowSet(&sensor->pwrShadow, MPU6050_PWR_MGMT_1, (MPU6050_PWR1_CLKSEL));
+					i2cShadowWrite(&sensor->pwrShadow, MPU6050_PWR_MGMT_2, (0b00111000));
 				}
 				else
 				{ // enable all measurements
-					i2cSendByteToSlaveReg(sensor->i2c, sensor->i2c_address, MPU6050_PWR_MGMT_1, (MPU6050_PWR1_CLKSEL));
-					i2cSendByteToSlaveReg(sensor->i2c, sensor->i2c_address, MPU6050_PWR_MGMT_2, (0b00000000));
+					i2cShadowSet(&sensor->pwrShadow, MPU6050_PWR_MGMT_1, (MPU6050_PWR1_CLKSEL));
+					i2cShadowWrite(&sensor->pwrShadow, MPU6050_PWR_MGMT_2, (0b00000000));
 				}
 			}
 			step = 0;
@@ -492,6 +499,45 @@ float mpuGetTemp(MPU6050_t* sensor)
 }
 
 
+/**
+ * @function mpuPollTemp
+ *
+ * @brief Non-blocking variant of mpuGetTemp() for display and telemetry tasks.
+ *
+ * Takes over the result of the read queued by the previous call and queues the next one with
+ * the given priority (see i2cQueueTransfer). The control loop is never delayed by more than
+ * this one 2 byte transaction.
+ *
+ * @param sensor       Pointer to an instance of the `MPU6050_t` structure.
+ * @param prio         Bus priority of the read, e.g. I2C_PRIO_UI
+ *
+ * @return float       Temperature of the previous read in degrees Celsius (unchanged if it failed or is still pending).
+ */
+float mpuPollTemp(MPU6050_t* sensor, I2C_PRIO_t prio)
+{
+	I2C_TRANSFER_t *xfer = &sensor->tempXfer;
+
+	i2cCheckTimeout(sensor->i2c);
+	if ((xfer->state == I2C_XFER_BUSY) || (xfer->state == I2C_XFER_QUEUED))
+	{
+		return (sensor->temperature);
+	}
+	if ((xfer->state == I2C_XFER_DONE) && (xfer->result == I2C_OK))
+	{
+		sensor->temp_raw = (int16_t) (sensor->tempBuf[0]<<8) + sensor->tempBuf[1];
+		mpuTemp(sensor);
+	}
+	sensor->tempReg = MPU6050_Temp;
+	xfer->saddr = sensor->i2c_address;
+	xfer->txBuf = &sensor->tempReg;
+	xfer->txLen = 1;
+	xfer->rxBuf = sensor->tempBuf;
+	xfer->rxLen = 2;
+	i2cQueueTransfer(sensor->i2c, xfer, prio);
+
+	return (sensor->temperature);
+}
+
 float mpuTemp(MPU6050_t* sensor)
 {
 	const float temp_factor = (float)1.0 / 340;
@@ -526,5 +572,5 @@ float mpuTemp(MPU6050_t* sensor)
  * - Refer to the MPU6050 datasheet for valid DLPF configuration values and their corresponding cutoff frequencies.
  */
 void mpuSetLpFilt(MPU6050_t* sensor) {
-	i2cSendByteToSlaveReg(sensor->i2c, sensor->i2c_address, MPU6050_CONFIG, sensor->LowPassFilt);
+	i2cShadowWrite(&sensor->cfgShadow, MPU6050_CONFIG, sensor->LowPassFilt);		// only sent if changed
 }
@@ -76,7 +76,8 @@ int8_t RFID_readCard(I2C_TypeDef *i2c, char *CardID)
 	switch (step)
 	{
 		case 1:
-		{
+		{	// no i2cWriteRead() here: the SL018 needs processing time before the response is valid,
+			// therefore the response is read with the next call (task tick)
 			i2cBurstWrite(i2c, i2cAddr_RFID, RFIDcmd_getMifareUID, 2);
 			step = 2;
 			break;
@@ -0,0 +1,339 @@
+/*
+ * i2cSched.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: T Flaemig
+ *
+ *  Concurrent transaction scheduler for I2C1 and I2C2.
+ *  Every job is a segment list (see i2cTransfer) which is executed once per control cycle.
+ *  i2cSchedStartCycle() submits the first job of each bus, all further jobs of the same bus
+ *  are queued from the completion callback, i.e. in interrupt context. The interrupt waits a
+ *  few us for STOP to complete and starts the next job at once; only if the bus does not become
+ *  idle in time the job stays queued and is started (incl. a bus recovery) by i2cSchedCycleDone()
+ *  or i2cSchedWaitCycle().
+ *  Poll one of both while the cycle runs, in between the CPU is free for the control algorithm.
+ *
+ *  The jobs are queued with I2C_PRIO_CONTROL: a job which finds the bus occupied by background
+ *  traffic (see i2cQueueTransfer) is started at the next transaction boundary.
+ */
+#include <stddef.h>
+#include <mcalI2C.h>
+#include <i2cSched.h>
+
+
+static I2C_SCHED_JOB_t  schedJob[I2C_SCHED_MAX_JOBS];
+static uint8_t          schedNumJobs = 0;
+static volatile uint8_t schedPending = 0;       // Jobs of the current cycle not yet finished
+
+
+static void schedJobFinished(void)
+{
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	if (schedPending > 0)
+	{
+		schedPending--;
+	}
+	__set_PRIMASK(primask);
+}
+
+/*
+ * Submits the next enabled job of the bus, starting at job index first
+ */
+static void schedSubmitNext(I2C_TypeDef *i2c, uint8_t first)
+{
+	uint8_t j;
+	I2C_RETURN_CODE_t rc;
+
+	for (j = first; j < schedNumJobs; j++)
+	{
+		if ((schedJob[j].i2c != i2c) || !schedJob[j].enabled)
+		{
+			continue;
+		}
+		schedJob[j].xfer.state = I2C_XFER_IDLE;            // Only marked busy by i2cSchedStartCycle()
+		rc = i2cQueueTransfer(i2c, &schedJob[j].xfer, I2C_PRIO_CONTROL);
+		if (rc == I2C_OK)
+		{
+			return;
+		}
+		schedJob[j].xfer.result = rc;
+		schedJob[j].xfer.state  = I2C_XFER_DONE;
+		schedJobFinished();
+	}
+}
+
+/*
+ * Completion callback (interrupt context): queue the next job of the same bus,
+ * started at once as soon as STOP has completed (see i2cQueueTransfer)
+ */
+static void schedCallback(I2C_TRANSFER_t *xfer)
+{
+	I2C_SCHED_JOB_t *job = (I2C_SCHED_JOB_t *) xfer->user;
+
+	schedJobFinished();
+	schedSubmitNext(job->i2c, (uint8_t) (job - schedJob) + 1);
+}
+
+/*
+ * Estimated bus time of a job in us: 9 SCL clocks per byte incl. address bytes
+ * plus START/STOP. The job runs with the lowest speed profile of its slaves (see i2cSetSlaveSpeed).
+ */
+static uint32_t schedJobTimeUs(I2C_SCHED_JOB_t *job, I2C_TypeDef *i2c)
+{
+	const I2C_SEGMENT_t *seg;
+	uint32_t bits = 1;
+	uint32_t scl  = 0xFFFFFFFFUL;
+	uint32_t hz;
+	uint8_t  s;
+
+	for (s = 0; s < job->xfer.numSegments; s++)
+	{
+		seg = &job->xfer.segments[s];
+		if ((seg->dir == I2C_SEG_WRITE) && (seg->flags & I2C_SEG_NOSTART) && (s > 0))
+		{
+			bits += seg->len * 9;                   // No START and address byte
+			continue;
+		}
+		bits += (seg->len + 1) * 9 + 1;
+		hz = i2cGetSlaveSpeed(i2c, seg->saddr);
+		if (hz < scl)
+		{
+			scl = hz;
+		}
+	}
+	if ((scl == 0) || (scl == 0xFFFFFFFFUL))
+	{
+		return 0;
+	}
+	return (uint32_t) (((uint64_t) bits * 1000000UL + scl - 1) / scl);
+}
+
+
+/**
+ * @function i2cSchedInit
+ * removes all jobs
+ */
+void i2cSchedInit(void)
+{
+	schedNumJobs = 0;
+	schedPending = 0;
+}
+
+/**
+ * @function i2cSchedAddJob
+ *
+ * @param i2c         : Bus the device has been found on
+ * @param busMask     : I2C_SCHED_BUS1 and/or I2C_SCHED_BUS2 - buses the device can be placed on
+ * @param segments    : Segment list, executed once per cycle. Must stay valid.
+ * @param numSegments : Number of segments
+ * @param useDma      : Transfer segments with >= 2 bytes by DMA
+ *
+ * @returns job number, -1 if no free job or the bus is neither I2C1 nor I2C2
+ */
+int8_t i2cSchedAddJob(I2C_TypeDef *i2c, uint8_t busMask, const I2C_SEGMENT_t *segments, uint8_t numSegments, bool useDma)
+{
+	I2C_SCHED_JOB_t *job;
+
+	if ((schedNumJobs >= I2C_SCHED_MAX_JOBS) || (segments == NULL) || (numSegments == 0) ||
+		((i2c != I2C1) && (i2c != I2C2)))
+	{
+		return -1;
+	}
+	job = &schedJob[schedNumJobs];
+	job->i2c     = i2c;
+	job->busMask = busMask;
+	job->enabled = true;
+	job->xfer.segments    = segments;
+	job->xfer.numSegments = numSegments;
+	job->xfer.useDma      = useDma;
+	job->xfer.callback    = schedCallback;
+	job->xfer.user        = job;
+	job->xfer.state       = I2C_XFER_IDLE;
+	job->xfer.result      = I2C_OK;
+
+	return (int8_t) schedNumJobs++;
+}
+
+void i2cSchedEnableJob(int8_t job, bool enable)
+{
+	if ((job >= 0) && (job < schedNumJobs))
+	{
+		schedJob[job].enabled = enable;
+	}
+}
+
+I2C_RETURN_CODE_t i2cSchedJobResult(int8_t job)
+{
+	if ((job < 0) || (job >= schedNumJobs))
+	{
+		return I2C_INVALID_TRANSFER;
+	}
+	return schedJob[job].xfer.result;
+}
+
+I2C_TypeDef *i2cSchedJobBus(int8_t job)
+{
+	if ((job < 0) || (job >= schedNumJobs))
+	{
+		return NULL;
+	}
+	return schedJob[job].i2c;
+}
+
+/**
+ * @function i2cSchedStartCycle
+ * starts all enabled jobs; I2C1 and I2C2 work in parallel
+ *
+ * @returns I2C_BUSY if the previous cycle has not finished yet
+ */
+I2C_RETURN_CODE_t i2cSchedStartCycle(void)
+{
+	uint8_t j, pending = 0;
+
+	if (schedPending > 0)
+	{
+		return I2C_BUSY;
+	}
+	for (j = 0; j < schedNumJobs; j++)
+	{
+		if (schedJob[j].enabled)
+		{
+			schedJob[j].xfer.state = I2C_XFER_BUSY;
+			pending++;
+		}
+	}
+	schedPending = pending;
+	schedSubmitNext(I2C1, 0);
+	schedSubmitNext(I2C2, 0);
+
+	return I2C_OK;
+}
+
+/**
+ * @function i2cSchedCycleDone
+ * starts the jobs deferred by the completion interrupt and checks the time budget
+ *
+ * @returns true if all jobs of the cycle are finished
+ */
+bool i2cSchedCycleDone(void)
+{
+	if (schedPending > 0)
+	{
+		i2cCheckTimeout(I2C1);
+		i2cCheckTimeout(I2C2);
+	}
+	return (schedPending == 0);
+}
+
+/**
+ * @function i2cSchedWaitCycle
+ * waits until all jobs of the cycle are finished; deferred jobs are started here,
+ * hanging transfers are aborted by the time budget
+ *
+ * @returns I2C_OK or the result of the first failed job
+ */
+I2C_RETURN_CODE_t i2cSchedWaitCycle(void)
+{
+	uint8_t j;
+
+	while (!i2cSchedCycleDone())
+	{
+	}
+	for (j = 0; j < schedNumJobs; j++)
+	{
+		if (schedJob[j].enabled && (schedJob[j].xfer.result != I2C_OK))
+		{
+			return schedJob[j].xfer.result;
+		}
+	}
+	return I2C_OK;
+}
+
+/**
+ * @function i2cSchedBusTimeUs
+ * @returns estimated bus time per cycle of all enabled jobs assigned to the bus
+ */
+uint32_t i2cSchedBusTimeUs(I2C_TypeDef *i2c)
+{
+	uint32_t sum = 0;
+	uint8_t  j;
+
+	for (j = 0; j < schedNumJobs; j++)
+	{
+		if (schedJob[j].enabled && (schedJob[j].i2c == i2c))
+		{
+			sum += schedJobTimeUs(&schedJob[j], i2c);
+		}
+	}
+	return sum;
+}
+
+/**
+ * @function i2cSchedPlaceDevices
+ * assigns the jobs which can be reached on both buses so that the longer of both bus times
+ * per cycle becomes short: greedy heuristic, the longest job first onto the bus which finishes
+ * it earlier. The result is not guaranteed to be the optimum.
+ * Must not be called while a cycle is running.
+ */
+void i2cSchedPlaceDevices(void)
+{
+	bool     placed[I2C_SCHED_MAX_JOBS] = { false };
+	uint32_t load1 = 0, load2 = 0, t1, t2, tMax;
+	int8_t   best;
+	uint8_t  j;
+
+	// Fixed jobs first
+	for (j = 0; j < schedNumJobs; j++)
+	{
+		if (!schedJob[j].enabled || (schedJob[j].busMask != (I2C_SCHED_BUS1 | I2C_SCHED_BUS2)))
+		{
+			placed[j] = true;
+			if (schedJob[j].enabled && (schedJob[j].i2c == I2C1))
+			{
+				load1 += schedJobTimeUs(&schedJob[j], I2C1);
+			}
+			else if (schedJob[j].enabled && (schedJob[j].i2c == I2C2))
+			{
+				load2 += schedJobTimeUs(&schedJob[j], I2C2);
+			}
+		}
+	}
+
+	do
+	{
+		best = -1;
+		tMax = 0;
+		for (j = 0; j < schedNumJobs; j++)
+		{
+			t1 = schedJobTimeUs(&schedJob[j], I2C1);
+			t2 = schedJobTimeUs(&schedJob[j], I2C2);
+			if (t2 > t1)
+			{
+				t1 = t2;
+			}
+			if (!placed[j] && (t1 >= tMax))
+			{
+				tMax = t1;
+				best = j;
+			}
+		}
+		if (best >= 0)
+		{
+			t1 = schedJobTimeUs(&schedJob[best], I2C1);
+			t2 = schedJobTimeUs(&schedJob[best], I2C2);
+			if ((load1 + t1) <= (load2 + t2))
+			{
+				schedJob[best].i2c = I2C1;
+				load1 += t1;
+			}
+			else
+			{
+				schedJob[best].i2c = I2C2;
+				load2 += t2;
+			}
+			placed[best] = true;
+		}
+	} while (best >= 0);
+}
@@ -0,0 +1,174 @@
+/*
+ * i2cShadow.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: T Flaemig
+ *
+ *  Register shadow on top of i2cBurstWrite().
+ *  i2cShadowSet() only stores a value in the cache and marks it dirty if it differs from the
+ *  value known to be in the slave. i2cShadowFlush() sends the dirty registers:
+ *  - I2C_SHADOW_REGS : every run of adjacent dirty registers as one auto-increment burst
+ *  - I2C_SHADOW_BLOCK: command code + complete payload, if at least one byte is dirty
+ *  After a reset of the slave the cache has to be invalidated with i2cShadowInvalidate().
+ */
+#include <stddef.h>
+#include <mcalI2C.h>
+#include <i2cShadow.h>
+
+
+/**
+ * @function i2cShadowInit
+ *
+ * @param sh    : Shadow of one register block
+ * @param i2c   : Bus of the slave
+ * @param saddr : 7Bit slave address
+ * @param base  : First register (I2C_SHADOW_REGS) or command code (I2C_SHADOW_BLOCK)
+ * @param size  : Number of registers / payload bytes, max. I2C_SHADOW_MAX_REGS
+ * @param mode  : I2C_SHADOW_REGS or I2C_SHADOW_BLOCK
+ */
+void i2cShadowInit(I2C_SHADOW_t *sh, I2C_TypeDef *i2c, uint8_t saddr, uint8_t base, uint8_t size, I2C_SHADOW_MODE_t mode)
+{
+	sh->i2c     = i2c;
+	sh->saddr   = saddr;
+	sh->base    = base;
+	sh->size    = (size > I2C_SHADOW_MAX_REGS) ? I2C_SHADOW_MAX_REGS : size;
+	sh->mode    = mode;
+	sh->valid   = 0;
+	sh->dirty   = 0;
+	sh->written = 0;
+	sh->saved   = 0;
+}
+
+/**
+ * @function i2cShadowInvalidate
+ * the content of the slave is unknown (e.g. after a reset), the next write of each register is sent
+ */
+void i2cShadowInvalidate(I2C_SHADOW_t *sh)
+{
+	sh->valid = 0;
+}
+
+/**
+ * @function i2cShadowSet
+ * stores the value in the cache without bus access
+ *
+ * @param reg   : Register address (I2C_SHADOW_REGS) or payload index (I2C_SHADOW_BLOCK)
+ *
+ * @returns true if the register has to be written
+ */
+bool i2cShadowSet(I2C_SHADOW_t *sh, uint8_t reg, uint8_t value)
+{
+	uint8_t  idx = (I2C_SHADOW_REGS == sh->mode) ? (uint8_t) (reg - sh->base) : reg;
+	uint32_t bit;
+
+	if (idx >= sh->size)
+	{
+		return false;
+	}
+	bit = 1UL << idx;
+	if ((sh->valid & bit) && !(sh->dirty & bit) && (sh->cache[idx] == value))
+	{
+		sh->saved++;
+		return false;
+	}
+	sh->cache[idx] = value;
+	sh->dirty |= bit;
+	return true;
+}
+
+/**
+ * @function i2cShadowFlush
+ * writes all dirty registers
+ *
+ * @returns I2C_OK or the error of i2cBurstWrite(); failed registers stay dirty
+ */
+I2C_RETURN_CODE_t i2cShadowFlush(I2C_SHADOW_t *sh)
+{
+	uint8_t           buf[I2C_SHADOW_MAX_REGS + 1];
+	uint8_t           first, last, i;
+	uint32_t          run;
+	I2C_RETURN_CODE_t rc;
+
+	if (NULL == sh->i2c)
+	{
+		return I2C_INVALID_TYPE;
+	}
+	if (0 == sh->dirty)
+	{
+		return I2C_OK;
+	}
+
+	if (I2C_SHADOW_BLOCK == sh->mode)
+	{
+		buf[0] = sh->base;
+		for (i = 0; i < sh->size; i++)
+		{
+			buf[i + 1] = sh->cache[i];
+		}
+		rc = i2cBurstWrite(sh->i2c, sh->saddr, buf, sh->size + 1);
+		if (I2C_OK != rc)
+		{
+			sh->valid = 0;
+			return rc;
+		}
+		sh->valid    = 0xFFFFFFFFUL >> (32 - sh->size);
+		sh->dirty    = 0;
+		sh->written += sh->size;
+		return I2C_OK;
+	}
+
+	for (first = 0; first < sh->size; first = last + 1)
+	{
+		if (!(sh->dirty & (1UL << first)))
+		{
+			last = first;
+			continue;
+		}
+		for (last = first; ((last + 1) < sh->size) && (sh->dirty & (1UL << (last + 1))); last++)
+		{
+			;
+		}
+		buf[0] = sh->base + first;                  // Start register, auto-increment for the others
+		for (i = first; i <= last; i++)
+		{
+			buf[i - first + 1] = sh->cache[i];
+		}
+		run = (0xFFFFFFFFUL >> (31 - (last - first))) << first;
+		rc  = i2cBurstWrite(sh->i2c, sh->saddr, buf, last - first + 2);
+		if (I2C_OK != rc)
+		{
+			sh->valid &= ~run;
+			return rc;
+		}
+		sh->valid   |= run;
+		sh->dirty   &= ~run;
+		sh->written += last - first + 1;
+	}
+	return I2C_OK;
+}
+
+/**
+ * @function i2cShadowWrite
+ * replacement of i2cSendByteToSlaveReg(): the register is only sent if the value changed,
+ * other dirty registers of the block are written in the same burst
+ */
+I2C_RETURN_CODE_t i2cShadowWrite(I2C_SHADOW_t *sh, uint8_t reg, uint8_t value)
+{
+	i2cShadowSet(sh, reg, value);
+	return i2cShadowFlush(sh);
+}
+
+/**
+ * @function i2cShadowWriteBlock
+ * replacement of i2cBurstWrite() for len registers starting at reg
+ */
+I2C_RETURN_CODE_t i2cShadowWriteBlock(I2C_SHADOW_t *sh, uint8_t reg, const uint8_t *data, uint8_t len)
+{
+	uint8_t i;
+
+	for (i = 0; i < len; i++)
+	{
+		i2cShadowSet(sh, reg + i, data[i]);
+	}
+	return i2cShadowFlush(sh);
+}
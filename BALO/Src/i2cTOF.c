@@ -1326,6 +1326,125 @@ bool TOF_read_distance_task(TOFSensor_t* TOFSENS)
 }
 
 
+// Transfers of TOF_read_distance_queued(): status, result and the restart sequence
+static const uint8_t TOF_restart_seq[][2] =
+{
+	{ TOF_REG_SYSTEM_INTERRUPT_CLEAR,           0x01 },
+	{ TOF_REG_POWER_MANAGEMENT_GO1_POWER_FORCE, 0x01 },
+	{ TOF_REG_INTERNAL_TUNING_2,                0x01 },
+	{ TOF_REG_SYSRANGE_START,                   0x00 },
+	{ TOF_REG_INTERNAL_TUNING_1,                0x00 },		// replaced by TOF_stop_variable
+	{ TOF_REG_SYSRANGE_START,                   0x01 },
+	{ TOF_REG_INTERNAL_TUNING_2,                0x00 },
+	{ TOF_REG_POWER_MANAGEMENT_GO1_POWER_FORCE, 0x00 },
+	{ TOF_REG_SYSRANGE_START,                   0x01 }
+};
+#define TOF_RESTART_STEPS	(sizeof(TOF_restart_seq) / sizeof(TOF_restart_seq[0]))
+#define TOF_QUEUE_XFERS		(TOF_RESTART_STEPS + 2)
+
+static I2C_TRANSFER_t TOF_xfer[TOF_QUEUE_XFERS];
+static uint8_t TOF_xferTx[TOF_QUEUE_XFERS][2];
+static uint8_t TOF_xferRx[2];
+static uint8_t TOF_queue_step = 0;
+
+static bool TOF_queue(uint8_t idx, uint8_t reg, uint8_t value, uint8_t txLen, uint8_t rxLen, I2C_PRIO_t prio)
+{
+	I2C_TRANSFER_t *xfer = &TOF_xfer[idx];
+
+	TOF_xferTx[idx][0] = reg;
+	TOF_xferTx[idx][1] = value;
+	xfer->saddr = TOF_address_used;
+	xfer->txBuf = TOF_xferTx[idx];
+	xfer->txLen = txLen;
+	xfer->rxBuf = TOF_xferRx;
+	xfer->rxLen = rxLen;
+	return (i2cQueueTransfer(TOF_i2c, xfer, prio) == I2C_OK);
+}
+
+/**
+ * @function:    TOF_read_distance_queued
+ *
+ * @brief:       Non-blocking variant of TOF_read_distance_task(): one step of the sequence per call,
+ *               every bus access is queued with priority prio (see i2cTOF.h).
+ *
+ * @returns:     bool: true if a status poll or a new measurement has been completed.
+ */
+bool TOF_read_distance_queued(TOFSensor_t* TOFSENS, I2C_PRIO_t prio)
+{
+	uint16_t taskdistance;
+	uint8_t i;
+	bool ok = true;
+
+	TOF_address_used = TOFSENS->TOF_address_used;	//TOF Adress from Struct TOF
+	TOF_i2c = TOFSENS->i2c_tof;		//I2C Adress from Struct TOF
+	i2cCheckTimeout(TOF_i2c);
+
+	switch (TOF_queue_step)
+	{
+		case 0:		// check the ReadyData Flag
+		{
+			if (TOF_queue(0, TOF_REG_RESULT_INTERRUPT_STATUS, 0, 1, 1, prio))
+			{
+				TOF_queue_step = 1;
+			}
+			return false;
+		}
+		case 1:
+		{
+			if (!i2cIsTransferDone(&TOF_xfer[0]))
+			{
+				return false;
+			}
+			TOF_queue_step = 0;
+			if (TOF_xfer[0].result != I2C_OK)
+			{
+				return false;
+			}
+			if ((TOF_xferRx[0] & 0x07) == 0)		//readydata Flag LOW !
+			{
+				TOFSENS->TOF_measuringage ++;
+				return true;
+			}
+			// read measurement result, clear the interrupt and start a new measurement
+			ok = TOF_queue(1, TOF_REG_RESULT_RANGE_STATUS + 10, 0, 1, 2, prio);
+			for (i = 0; ok && (i < TOF_RESTART_STEPS); i++)
+			{
+				ok = TOF_queue(i + 2, TOF_restart_seq[i][0],
+						(TOF_restart_seq[i][0] == TOF_REG_INTERNAL_TUNING_1) ? TOF_stop_variable : TOF_restart_seq[i][1], 2, 0, prio);
+			}
+			TOF_queue_step = ok ? 2 : 3;
+			return false;
+		}
+		default:	// wait for the sequence
+		{
+			for (i = 1; i < TOF_QUEUE_XFERS; i++)
+			{
+				if ((TOF_xfer[i].state == I2C_XFER_BUSY) || (TOF_xfer[i].state == I2C_XFER_QUEUED))
+				{
+					return false;
+				}
+				ok = ok && (TOF_xfer[i].result == I2C_OK);
+			}
+			ok = ok && (TOF_queue_step == 2);
+			TOF_queue_step = 0;
+			if (!ok)
+			{
+				return false;
+			}
+			taskdistance = (TOF_xferRx[0] << 8) + TOF_xferRx[1];
+			TOFSENS->measuredRange = taskdistance;
+			if (taskdistance == 8190 || taskdistance == 8191)
+			{
+				taskdistance = TOF_VL53L0X_OUT_OF_RANGE;
+			}
+			TOFSENS->distanceFromTOF = taskdistance;
+			TOFSENS->TOF_measuringage = 0; 		//reset measuring age
+			return true;
+		}
+	}
+}
+
+
 /**
  * @function:    TOF_set_address
  *
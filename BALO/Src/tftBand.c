@@ -0,0 +1,512 @@
+/*
+ * tftBand.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: T Flaemig
+ *
+ *  Band renderer on top of the DMA pixel stream of ST7735.c.
+ *  tftBandBegin() starts a frame, the tftBand... drawing functions only record the primitive
+ *  (texts are copied, bitmaps are referenced and have to stay valid), tftBandRender() sets the
+ *  full screen as address window once and streams it band by band:
+ *  background -> all primitives in list order, clipped to the rows of the band -> DMA.
+ *  The screen is redrawn completely at bus speed, no framebuffer is needed.
+ */
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ST7735.h>
+#include <tftBand.h>
+
+typedef enum
+{
+	BAND_RECT,						// x0, y0, x1, y1 inclusive
+	BAND_LINE,						// (x0, y0) - (x1, y1), y0 <= y1
+	BAND_CIRCLE,					// center x0, y0, radius x1
+	BAND_DISC,
+	BAND_TEXT,						// x0, y0, string in the pool
+	BAND_TEXT_TRANSP,
+	BAND_BITMAP						// x0, y0, size x1 * y1
+} BAND_PRIM_t;
+
+typedef struct
+{
+	uint8_t			type;
+	uint16_t		color;
+	uint16_t		bg;
+	int16_t			x0, y0, x1, y1;
+	const void		*data;			// text or bitmap
+	const uint8_t	*font;
+} BAND_CMD_t;
+
+static BAND_CMD_t	bandList[TFT_BAND_LIST_MAX];
+static uint8_t		bandNum = 0;
+static char			bandPool[TFT_BAND_TEXT_POOL];
+static uint16_t		bandPoolUsed = 0;
+static uint16_t		bandBackground = tft_BLACK;
+
+static uint16_t		bandBuf[2][TFT_BAND_LINES * ST7735_TFTHEIGHT];
+
+// band being rasterized
+static uint16_t		*bandPix;
+static int16_t		bandY0, bandY1, bandW;
+
+
+static BAND_CMD_t *bandAdd(uint8_t type, uint16_t color)
+{
+	BAND_CMD_t *cmd;
+
+	if (bandNum >= TFT_BAND_LIST_MAX)
+	{
+		return NULL;
+	}
+	cmd = &bandList[bandNum++];
+	cmd->type  = type;
+	cmd->color = color;
+	return cmd;
+}
+
+/**
+ * @function tftBandBegin
+ * starts a new frame: the display list is cleared
+ *
+ * @param background : color of all pixels not covered by a primitive
+ */
+void tftBandBegin(uint16_t background)
+{
+	bandNum        = 0;
+	bandPoolUsed   = 0;
+	bandBackground = background;
+}
+
+/**
+ * @function tftBandFillRect
+ * records a filled rectangle, x and y are the top left corner, w is width, h is height
+ */
+TFT_BAND_RETURN_CODE_t tftBandFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+	BAND_CMD_t *cmd;
+
+	if ((w <= 0) || (h <= 0))
+	{
+		return TFT_BAND_OK;
+	}
+	cmd = bandAdd(BAND_RECT, color);
+	if (NULL == cmd)
+	{
+		return TFT_BAND_LIST_FULL;
+	}
+	cmd->x0 = x;
+	cmd->y0 = y;
+	cmd->x1 = x + w - 1;
+	cmd->y1 = y + h - 1;
+	return TFT_BAND_OK;
+}
+
+TFT_BAND_RETURN_CODE_t tftBandDrawPixel(int16_t x, int16_t y, uint16_t color)
+{
+	return tftBandFillRect(x, y, 1, 1, color);
+}
+
+TFT_BAND_RETURN_CODE_t tftBandDrawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+{
+	return tftBandFillRect(x, y, w, 1, color);
+}
+
+TFT_BAND_RETURN_CODE_t tftBandDrawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+{
+	return tftBandFillRect(x, y, 1, h, color);
+}
+
+/**
+ * @function tftBandDrawRect
+ * records the outline of a rectangle as four lines
+ */
+TFT_BAND_RETURN_CODE_t tftBandDrawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+	if (bandNum + 4 > TFT_BAND_LIST_MAX)
+	{
+		return TFT_BAND_LIST_FULL;
+	}
+	tftBandDrawFastHLine(x, y, w, color);
+	tftBandDrawFastHLine(x, y + h - 1, w, color);
+	tftBandDrawFastVLine(x, y + 1, h - 2, color);
+	tftBandDrawFastVLine(x + w - 1, y + 1, h - 2, color);
+	return TFT_BAND_OK;
+}
+
+/**
+ * @function tftBandDrawLine
+ * records a line between (x0, y0) and (x1, y1), rasterized with Bresenham
+ */
+TFT_BAND_RETURN_CODE_t tftBandDrawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
+{
+	BAND_CMD_t *cmd = bandAdd(BAND_LINE, color);
+
+	if (NULL == cmd)
+	{
+		return TFT_BAND_LIST_FULL;
+	}
+	// top down, so the rasterizer can stop below the band
+	if (y1 < y0)
+	{
+		cmd->x0 = x1; cmd->y0 = y1;
+		cmd->x1 = x0; cmd->y1 = y0;
+	}
+	else
+	{
+		cmd->x0 = x0; cmd->y0 = y0;
+		cmd->x1 = x1; cmd->y1 = y1;
+	}
+	return TFT_BAND_OK;
+}
+
+static TFT_BAND_RETURN_CODE_t bandAddCircle(uint8_t type, int16_t x, int16_t y, int16_t radius, uint16_t color)
+{
+	BAND_CMD_t *cmd = bandAdd(type, color);
+
+	if (NULL == cmd)
+	{
+		return TFT_BAND_LIST_FULL;
+	}
+	cmd->x0 = x;
+	cmd->y0 = y;
+	cmd->x1 = radius;
+	return TFT_BAND_OK;
+}
+
+TFT_BAND_RETURN_CODE_t tftBandDrawCircle(int16_t x, int16_t y, int16_t radius, uint16_t color)
+{
+	return bandAddCircle(BAND_CIRCLE, x, y, radius, color);
+}
+
+TFT_BAND_RETURN_CODE_t tftBandFillCircle(int16_t x, int16_t y, int16_t radius, uint16_t color)
+{
+	return bandAddCircle(BAND_DISC, x, y, radius, color);
+}
+
+static TFT_BAND_RETURN_CODE_t bandAddText(uint8_t type, const char *st, int16_t x, int16_t y, const uint8_t *font, uint16_t fg, uint16_t bg)
+{
+	uint16_t len = strlen(st) + 1;
+	BAND_CMD_t *cmd;
+
+	if (bandPoolUsed + len > TFT_BAND_TEXT_POOL)
+	{
+		return TFT_BAND_POOL_FULL;
+	}
+	cmd = bandAdd(type, fg);
+	if (NULL == cmd)
+	{
+		return TFT_BAND_LIST_FULL;
+	}
+	memcpy(&bandPool[bandPoolUsed], st, len);
+	cmd->data = &bandPool[bandPoolUsed];
+	bandPoolUsed += len;
+	cmd->font = font;
+	cmd->bg   = bg;
+	cmd->x0   = x;
+	cmd->y0   = y;
+	return TFT_BAND_OK;
+}
+
+/**
+ * @function tftBandPrint
+ * records a text with background color, the string is copied; no line wrap
+ *
+ * @param st   : text
+ * @param x, y : top left corner of the first character
+ * @param font : SmallFont, BigFont or SevenSegNumFont
+ */
+TFT_BAND_RETURN_CODE_t tftBandPrint(const char *st, int16_t x, int16_t y, const uint8_t *font, uint16_t fg, uint16_t bg)
+{
+	return bandAddText(BAND_TEXT, st, x, y, font, fg, bg);
+}
+
+/**
+ * @function tftBandPrintTransparent
+ * as tftBandPrint(), only the set pixels of the characters are drawn
+ */
+TFT_BAND_RETURN_CODE_t tftBandPrintTransparent(const char *st, int16_t x, int16_t y, const uint8_t *font, uint16_t fg)
+{
+	return bandAddText(BAND_TEXT_TRANSP, st, x, y, font, fg, fg);
+}
+
+/**
+ * @function tftBandDrawBitmap
+ * records a RGB565 bitmap of sx * sy pixels, the data is referenced and has to stay valid
+ * until tftBandRender()
+ */
+TFT_BAND_RETURN_CODE_t tftBandDrawBitmap(int16_t x, int16_t y, int16_t sx, int16_t sy, const uint16_t *data)
+{
+	BAND_CMD_t *cmd = bandAdd(BAND_BITMAP, 0);
+
+	if (NULL == cmd)
+	{
+		return TFT_BAND_LIST_FULL;
+	}
+	cmd->x0   = x;
+	cmd->y0   = y;
+	cmd->x1   = sx;
+	cmd->y1   = sy;
+	cmd->data = data;
+	return TFT_BAND_OK;
+}
+
+
+/*
+ * Rasterizer: everything ends in horizontal spans clipped to the band
+ */
+static void bandSpan(int16_t y, int16_t xa, int16_t xb, uint16_t color)
+{
+	uint16_t *dst;
+
+	if ((y < bandY0) || (y > bandY1))
+	{
+		return;
+	}
+	if (xa < 0)
+	{
+		xa = 0;
+	}
+	if (xb >= bandW)
+	{
+		xb = bandW - 1;
+	}
+	dst = &bandPix[(y - bandY0) * bandW];
+	while (xa <= xb)
+	{
+		dst[xa++] = color;
+	}
+}
+
+static inline void bandPixel(int16_t x, int16_t y, uint16_t color)
+{
+	if ((x >= 0) && (x < bandW) && (y >= bandY0) && (y <= bandY1))
+	{
+		bandPix[(y - bandY0) * bandW + x] = color;
+	}
+}
+
+static void bandRect(const BAND_CMD_t *cmd)
+{
+	int16_t y  = (cmd->y0 > bandY0) ? cmd->y0 : bandY0;
+	int16_t ye = (cmd->y1 < bandY1) ? cmd->y1 : bandY1;
+
+	for (; y <= ye; y++)
+	{
+		bandSpan(y, cmd->x0, cmd->x1, cmd->color);
+	}
+}
+
+static void bandLine(const BAND_CMD_t *cmd)
+{
+	int16_t x = cmd->x0, y = cmd->y0;
+	int16_t dx = abs(cmd->x1 - cmd->x0), sx = (cmd->x0 < cmd->x1) ? 1 : -1;
+	int16_t dy = -(cmd->y1 - cmd->y0);
+	int16_t err = dx + dy, e2;
+
+	if ((cmd->y1 < bandY0) || (cmd->y0 > bandY1))
+	{
+		return;
+	}
+	for (;;)
+	{
+		bandPixel(x, y, cmd->color);
+		if (((x == cmd->x1) && (y == cmd->y1)) || (y > bandY1))
+		{
+			break;
+		}
+		e2 = 2 * err;
+		if (e2 >= dy)
+		{
+			err += dy;
+			x += sx;
+		}
+		if (e2 <= dx)
+		{
+			err += dx;
+			y++;
+		}
+	}
+}
+
+// same points as tftDrawCircle()
+static void bandCircle(const BAND_CMD_t *cmd)
+{
+	int16_t x = cmd->x0, y = cmd->y0, r = cmd->x1;
+	int16_t f = 1 - r, ddF_x = 1, ddF_y = -2 * r;
+	int16_t x1 = 0, y1 = r;
+	uint16_t c = cmd->color;
+
+	if ((y + r < bandY0) || (y - r > bandY1))
+	{
+		return;
+	}
+	bandPixel(x, y + r, c);
+	bandPixel(x, y - r, c);
+	bandPixel(x + r, y, c);
+	bandPixel(x - r, y, c);
+	while (x1 < y1)
+	{
+		if (f >= 0)
+		{
+			y1--;
+			ddF_y += 2;
+			f += ddF_y;
+		}
+		x1++;
+		ddF_x += 2;
+		f += ddF_x;
+
+		bandPixel(x + x1, y + y1, c);
+		bandPixel(x - x1, y + y1, c);
+		bandPixel(x + x1, y - y1, c);
+		bandPixel(x - x1, y - y1, c);
+		bandPixel(x + y1, y + x1, c);
+		bandPixel(x - y1, y + x1, c);
+		bandPixel(x + y1, y - x1, c);
+		bandPixel(x - y1, y - x1, c);
+	}
+}
+
+static int16_t bandIsqrt(int32_t v)
+{
+	int32_t r = 0, bit = 1L << 30;
+
+	while (bit > v)
+	{
+		bit >>= 2;
+	}
+	while (bit != 0)
+	{
+		if (v >= r + bit)
+		{
+			v -= r + bit;
+			r = (r >> 1) + bit;
+		}
+		else
+		{
+			r >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (int16_t) r;
+}
+
+// same spans as tftFillCircle(): row dy covers x - d ... x + d - 1 with d^2 + dy^2 <= r^2
+static void bandDisc(const BAND_CMD_t *cmd)
+{
+	int16_t r  = cmd->x1;
+	int16_t y  = (cmd->y0 - r > bandY0) ? cmd->y0 - r : bandY0;
+	int16_t ye = (cmd->y0 + r < bandY1) ? cmd->y0 + r : bandY1;
+	int16_t d;
+
+	for (; y <= ye; y++)
+	{
+		d = bandIsqrt((int32_t) r * r - (int32_t) (y - cmd->y0) * (y - cmd->y0));
+		bandSpan(y, cmd->x0 - d, cmd->x0 + d - 1, cmd->color);
+	}
+}
+
+static void bandText(const BAND_CMD_t *cmd)
+{
+	const uint8_t *font = cmd->font;
+	const uint8_t *glyph;
+	const char *st;
+	uint8_t xs = font[0], ys = font[1], fz = xs / 8;
+	int16_t y  = (cmd->y0 > bandY0) ? cmd->y0 : bandY0;
+	int16_t ye = (cmd->y0 + ys - 1 < bandY1) ? cmd->y0 + ys - 1 : bandY1;
+	int16_t x, i;
+	uint8_t z, bits;
+
+	for (; y <= ye; y++)
+	{
+		x = cmd->x0;
+		for (st = cmd->data; *st != '\0'; st++, x += xs)
+		{
+			if (((uint8_t) *st < font[2]) || ((uint8_t) *st >= font[2] + font[3]))
+			{
+				continue;
+			}
+			glyph = &font[4 + ((uint8_t) *st - font[2]) * fz * ys + (y - cmd->y0) * fz];
+			for (z = 0; z < fz; z++)
+			{
+				bits = glyph[z];
+				for (i = 0; i < 8; i++)
+				{
+					if (bits & (0x80 >> i))
+					{
+						bandPixel(x + z * 8 + i, y, cmd->color);
+					}
+					else if (BAND_TEXT == cmd->type)
+					{
+						bandPixel(x + z * 8 + i, y, cmd->bg);
+					}
+				}
+			}
+		}
+	}
+}
+
+static void bandBitmap(const BAND_CMD_t *cmd)
+{
+	const uint16_t *src;
+	int16_t y  = (cmd->y0 > bandY0) ? cmd->y0 : bandY0;
+	int16_t ye = (cmd->y0 + cmd->y1 - 1 < bandY1) ? cmd->y0 + cmd->y1 - 1 : bandY1;
+	int16_t xa = (cmd->x0 > 0) ? cmd->x0 : 0;
+	int16_t xb = (cmd->x0 + cmd->x1 < bandW) ? cmd->x0 + cmd->x1 : bandW;
+
+	if (xa >= xb)
+	{
+		return;
+	}
+	for (; y <= ye; y++)
+	{
+		src = (const uint16_t *) cmd->data + (y - cmd->y0) * cmd->x1 + (xa - cmd->x0);
+		memcpy(&bandPix[(y - bandY0) * bandW + xa], src, (xb - xa) * sizeof(uint16_t));
+	}
+}
+
+/**
+ * @function tftBandRender
+ * draws the recorded frame on the whole screen; the display list stays valid, so the same
+ * frame can be rendered again
+ */
+void tftBandRender(void)
+{
+	int16_t height = tftGetHeight();
+	uint16_t i, n, lines;
+	uint8_t buf = 0;
+
+	bandW = tftGetWidth();
+	tftSetAddrWindow(0, 0, bandW - 1, height - 1);
+	tftStreamBegin();
+	for (bandY0 = 0; bandY0 < height; bandY0 += TFT_BAND_LINES)
+	{
+		lines  = (height - bandY0 < TFT_BAND_LINES) ? height - bandY0 : TFT_BAND_LINES;
+		bandY1 = bandY0 + lines - 1;
+		bandPix = bandBuf[buf];
+		n = lines * bandW;
+
+		for (i = 0; i < n; i++)
+		{
+			bandPix[i] = bandBackground;
+		}
+		for (i = 0; i < bandNum; i++)
+		{
+			switch (bandList[i].type)
+			{
+				case BAND_RECT:			bandRect(&bandList[i]);		break;
+				case BAND_LINE:			bandLine(&bandList[i]);		break;
+				case BAND_CIRCLE:		bandCircle(&bandList[i]);	break;
+				case BAND_DISC:			bandDisc(&bandList[i]);		break;
+				case BAND_TEXT:
+				case BAND_TEXT_TRANSP:	bandText(&bandList[i]);		break;
+				case BAND_BITMAP:		bandBitmap(&bandList[i]);	break;
+				default:				break;
+			}
+		}
+		tftStreamPush(bandPix, n);		// returns at once, the other buffer is drawn meanwhile
+		buf ^= 1;
+	}
+	tftStreamEnd();
+}
@@ -0,0 +1,324 @@
+/*
+ * tftImage.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: T Flaemig
+ *
+ *  Streaming decoder of the compressed image formats in tftImage.h. The decoder state is
+ *  kept between the line buffers, so every format is decoded in one pass without random
+ *  access to the image data.
+ */
+#include <stddef.h>
+#include <string.h>
+#include <tftImage.h>
+
+#define IMG_LINE_BUF		(ST7735_TFTHEIGHT)	// longest line in any rotation
+#define IMG_QOI_HEADER		(14)				// "qoif", width, height, channels, colorspace
+
+typedef struct
+{
+	const uint8_t	*src;
+	const uint8_t	*pal;			// palette, RGB565 little endian
+	uint8_t			format;
+	uint8_t			bpp;
+	uint8_t			bits;			// PAL: bits left in cur
+	uint8_t			cur;
+	uint8_t			run;			// RLE, QOI: pixels left of the current run
+	bool			repeat;			// RLE: run of one color, else literal pixels
+	uint16_t		color;			// RLE: color of the run
+#ifdef TFT_IMAGE_QOI
+	uint8_t			px[4];			// QOI: previous pixel RGBA
+	uint8_t			index[64][4];	// QOI: recently seen pixels
+#endif
+} IMG_DEC_t;
+
+// ping-pong: one buffer is decoded while the other is sent
+static uint16_t imgLine[2][IMG_LINE_BUF];
+
+
+static inline uint16_t imgGet16(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+static void imgRaw(IMG_DEC_t *d, uint16_t *dst, uint16_t num)
+{
+	while (num--)
+	{
+		*dst++ = imgGet16(d->src);
+		d->src += 2;
+	}
+}
+
+// RGB565 or, with TFT_IMG_PAL_RLE, one byte palette index
+static inline uint16_t imgRleNext(IMG_DEC_t *d)
+{
+	uint16_t color;
+
+	if (d->format == TFT_IMG_PAL_RLE)
+	{
+		return imgGet16(&d->pal[2 * *d->src++]);
+	}
+	color = imgGet16(d->src);
+	d->src += 2;
+	return color;
+}
+
+static void imgRle(IMG_DEC_t *d, uint16_t *dst, uint16_t num)
+{
+	uint8_t c, n;
+
+	while (num > 0)
+	{
+		if (d->run == 0)
+		{
+			c = *d->src++;
+			d->run = (c & 0x7F) + 1;
+			d->repeat = (c & 0x80) != 0;
+			if (d->repeat)
+			{
+				d->color = imgRleNext(d);
+			}
+		}
+		n = (d->run < num) ? d->run : num;
+		d->run -= n;
+		num -= n;
+		if (d->repeat)
+		{
+			while (n--)
+			{
+				*dst++ = d->color;
+			}
+		}
+		else
+		{
+			while (n--)
+			{
+				*dst++ = imgRleNext(d);
+			}
+		}
+	}
+}
+
+static void imgPal(IMG_DEC_t *d, uint16_t *dst, uint16_t num)
+{
+	uint8_t mask = (1 << d->bpp) - 1;
+
+	while (num--)
+	{
+		if (d->bits == 0)
+		{
+			d->cur  = *d->src++;
+			d->bits = 8;
+		}
+		d->bits -= d->bpp;
+		*dst++ = imgGet16(&d->pal[2 * ((d->cur >> d->bits) & mask)]);
+	}
+}
+
+#ifdef TFT_IMAGE_QOI
+/*
+ * QOI decoder (https://qoiformat.org), alpha is decoded but not used.
+ * The encoder rounds the colors to RGB565 before, so the conversion back is exact.
+ */
+#define QOI_OP_RGB		(0xFE)
+#define QOI_OP_RGBA		(0xFF)
+#define QOI_OP_INDEX	(0x00)
+#define QOI_OP_DIFF		(0x40)
+#define QOI_OP_LUMA		(0x80)
+#define QOI_OP_RUN		(0xC0)
+#define QOI_MASK		(0xC0)
+
+static void imgQoi(IMG_DEC_t *d, uint16_t *dst, uint16_t num)
+{
+	uint8_t *px = d->px;
+	uint8_t b1, b2;
+	int8_t vg;
+
+	while (num--)
+	{
+		if (d->run > 0)
+		{
+			d->run--;
+		}
+		else
+		{
+			b1 = *d->src++;
+			if (b1 == QOI_OP_RGB)
+			{
+				memcpy(px, d->src, 3);
+				d->src += 3;
+			}
+			else if (b1 == QOI_OP_RGBA)
+			{
+				memcpy(px, d->src, 4);
+				d->src += 4;
+			}
+			else if ((b1 & QOI_MASK) == QOI_OP_INDEX)
+			{
+				memcpy(px, d->index[b1], 4);
+			}
+			else if ((b1 & QOI_MASK) == QOI_OP_DIFF)
+			{
+				px[0] += ((b1 >> 4) & 0x03) - 2;
+				px[1] += ((b1 >> 2) & 0x03) - 2;
+				px[2] += ( b1       & 0x03) - 2;
+			}
+			else if ((b1 & QOI_MASK) == QOI_OP_LUMA)
+			{
+				b2 = *d->src++;
+				vg = (b1 & 0x3F) - 32;
+				px[0] += vg - 8 + ((b2 >> 4) & 0x0F);
+				px[1] += vg;
+				px[2] += vg - 8 + (b2 & 0x0F);
+			}
+			else
+			{
+				d->run = b1 & 0x3F;
+			}
+			memcpy(d->index[(px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) & 0x3F], px, 4);
+		}
+		*dst++ = ((px[0] & 0xF8) << 8) | ((px[1] & 0xFC) << 3) | (px[2] >> 3);
+	}
+}
+#endif /* TFT_IMAGE_QOI */
+
+static void imgDecode(IMG_DEC_t *d, uint16_t *dst, uint16_t num)
+{
+	switch (d->format)
+	{
+		case TFT_IMG_RLE:
+		case TFT_IMG_PAL_RLE:
+			imgRle(d, dst, num);
+			break;
+		case TFT_IMG_PAL:
+			imgPal(d, dst, num);
+			break;
+#ifdef TFT_IMAGE_QOI
+		case TFT_IMG_QOI:
+			imgQoi(d, dst, num);
+			break;
+#endif
+		default:
+			imgRaw(d, dst, num);
+			break;
+	}
+}
+
+/**
+ * @function tftImageSize
+ * checks the header, w and h may be NULL
+ */
+TFT_IMG_RETURN_CODE_t tftImageSize(const uint8_t *img, uint16_t *w, uint16_t *h)
+{
+	if ((img[0] != 'T') || (img[1] != 'I'))
+	{
+		return TFT_IMG_BAD_FORMAT;
+	}
+	switch (img[2])
+	{
+		case TFT_IMG_RAW:
+		case TFT_IMG_RLE:
+		case TFT_IMG_PAL_RLE:
+			break;
+		case TFT_IMG_PAL:
+			if ((img[3] != 1) && (img[3] != 2) && (img[3] != 4) && (img[3] != 8))
+			{
+				return TFT_IMG_BAD_FORMAT;
+			}
+			break;
+#ifdef TFT_IMAGE_QOI
+		case TFT_IMG_QOI:
+			if (memcmp(&img[TFT_IMG_HEADER + 2 * imgGet16(&img[8])], "qoif", 4) != 0)
+			{
+				return TFT_IMG_BAD_FORMAT;
+			}
+			break;
+#endif
+		default:
+			return TFT_IMG_BAD_FORMAT;
+	}
+	if (w != NULL)
+	{
+		*w = imgGet16(&img[4]);
+	}
+	if (h != NULL)
+	{
+		*h = imgGet16(&img[6]);
+	}
+	return TFT_IMG_OK;
+}
+
+/**
+ * @function st7735DrawImage
+ * draws the image with the top left corner at x, y in one address window
+ * as many complete rows as fit into a line buffer are decoded and sent with one DMA transfer,
+ * in LANDSCAPE the rows are mirrored like in tftDrawBitmap()
+ */
+TFT_IMG_RETURN_CODE_t st7735DrawImage(ST7735_t *tft, int16_t x, int16_t y, const uint8_t *img)
+{
+	TFT_IMG_RETURN_CODE_t ret;
+	IMG_DEC_t dec;
+	uint16_t w, h, r, rows, n, a, b, t;
+	uint16_t *line;
+	uint8_t buf = 0;
+	bool mirror = !(tft->orientation == PORTRAIT || tft->orientation == PORTRAIT_FLIP);
+
+	ret = tftImageSize(img, &w, &h);
+	if (ret != TFT_IMG_OK)
+	{
+		return ret;
+	}
+	if ((w == 0) || (h == 0) || (x < 0) || (y < 0) || (x + w > tft->width) || (y + h > tft->height))
+	{
+		return TFT_IMG_BAD_SIZE;
+	}
+
+	memset(&dec, 0, sizeof(dec));
+	dec.format = img[2];
+	dec.bpp    = img[3];
+	dec.pal    = &img[TFT_IMG_HEADER];
+	dec.src    = &img[TFT_IMG_HEADER + 2 * imgGet16(&img[8])];
+#ifdef TFT_IMAGE_QOI
+	dec.px[3]  = 255;
+	if (dec.format == TFT_IMG_QOI)
+	{
+		dec.src += IMG_QOI_HEADER;
+	}
+#endif
+
+	rows = IMG_LINE_BUF / w;
+	st7735SetAddrWindow(tft, x, y, x + w - 1, y + h - 1);
+	st7735StreamBegin(tft);
+	for (r = 0; r < h; r += n)
+	{
+		n = (rows < h - r) ? rows : h - r;
+		line = imgLine[buf];
+		imgDecode(&dec, line, n * w);
+		if (mirror)
+		{
+			for (a = 0; a < n * w; a += w)
+			{
+				for (b = 0; b < w / 2; b++)
+				{
+					t = line[a + b];
+					line[a + b] = line[a + w - 1 - b];
+					line[a + w - 1 - b] = t;
+				}
+			}
+		}
+		st7735StreamPush(tft, line, n * w);
+		buf ^= 1;
+	}
+	st7735StreamEnd(tft);
+	return TFT_IMG_OK;
+}
+
+/**
+ * @function tftDrawImage
+ * st7735DrawImage() on the default display
+ */
+TFT_IMG_RETURN_CODE_t tftDrawImage(int16_t x, int16_t y, const uint8_t *img)
+{
+	return st7735DrawImage(tftGetDisplay(), x, y, img);
+}
@@ -0,0 +1,453 @@
+/*
+ * tftQueue.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: T Flaemig
+ *
+ *  Deferred display commands.
+ *  Every command keeps its bounding box and its number of pixels. tftQueueDrain() estimates
+ *  the duration of the next command as overhead + pixels * cyclesPerPixel and stops before
+ *  the budget would be exceeded. cyclesPerPixel is learned from the measured durations
+ *  (DWT cycle counter), it starts with the SPI time of one RGB565 pixel at CLK_DIV_16.
+ *  Filled rectangles and the screen fill are drawn in bands of rows: the rows which fit into
+ *  the rest of the budget are drawn, the remaining rows stay queued for the next drain.
+ */
+#include <stddef.h>
+#include <string.h>
+#include <mcalRCC.h>
+#include <tftQueue.h>
+
+// time source, can be replaced for host builds
+#ifndef TFT_QUEUE_NOW
+#define TFT_QUEUE_NOW()			(DWT->CYCCNT)
+#define TFT_QUEUE_CLOCK_ON()	do { CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; \
+									 DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk; } while (0)
+#else
+#define TFT_QUEUE_CLOCK_ON()
+#endif
+
+#define QUEUE_OVERHEAD			(2000)		// cycles per command: address window and calls
+#define QUEUE_CPP_START			(16 * 16)	// cycles per pixel: 16 bit at PCLK / 16
+
+typedef enum
+{
+	QUEUE_SCREEN,					// a, b, c, d = 0, 0, width, height
+	QUEUE_RECT,						// a, b, c, d = x, y, w, h
+	QUEUE_HLINE,
+	QUEUE_VLINE,
+	QUEUE_LINE,						// a, b, c, d = x1, y1, x2, y2
+	QUEUE_FRAME,
+	QUEUE_CIRCLE,					// a, b, c = x, y, radius
+	QUEUE_DISC,
+	QUEUE_TEXT						// a, b = x, y
+} QUEUE_TYPE_t;
+
+typedef struct
+{
+	uint8_t			type;
+	uint16_t		color;
+	uint16_t		bg;
+	int16_t			a, b, c, d;
+	int16_t			x0, y0, x1, y1;	// bounding box, inclusive
+	uint32_t		pixels;
+	const uint8_t	*font;
+	char			text[TFT_QUEUE_TEXT + 1];
+} QUEUE_CMD_t;
+
+static QUEUE_CMD_t			queue[TFT_QUEUE_LEN];
+static uint8_t				queueHead = 0;		// next free entry
+static uint8_t				queueNum = 0;
+static uint32_t				queueCyclesPerUs = 84;
+static TFT_QUEUE_STATS_t	queueStats;
+
+
+static inline QUEUE_CMD_t *queueAt(uint8_t age)	// 0 = oldest pending
+{
+	return &queue[(queueHead + TFT_QUEUE_LEN - queueNum + age) % TFT_QUEUE_LEN];
+}
+
+static bool queueOverlap(const QUEUE_CMD_t *p, const QUEUE_CMD_t *q)
+{
+	return (p->x0 <= q->x1) && (q->x0 <= p->x1) && (p->y0 <= q->y1) && (q->y0 <= p->y1);
+}
+
+/*
+ * the new text q covers all pixels of the pending text p: fixed width font, so a longer text
+ * at x >= 0 contains the old one, a centered or right aligned text only one of the same length.
+ * Transparent text would leave the old glyphs visible.
+ */
+static bool queueTextCovers(const QUEUE_CMD_t *p, const QUEUE_CMD_t *q)
+{
+	size_t lenP = strlen(p->text), lenQ = strlen(q->text);
+
+	if (tftGetDisplay()->transparent)
+	{
+		return false;
+	}
+	return (q->a < 0) ? (lenQ == lenP) : (lenQ >= lenP);
+}
+
+/*
+ * p is pending, q is new: q may replace p if it draws at least all pixels of p,
+ * so the box of q is the union of both boxes for the overlap test in queuePut()
+ */
+static bool queueSameKey(const QUEUE_CMD_t *p, const QUEUE_CMD_t *q)
+{
+	if (p->type != q->type)
+	{
+		return false;
+	}
+	switch (p->type)
+	{
+		case QUEUE_SCREEN:	return true;
+		case QUEUE_RECT:	return (p->a == q->a) && (p->b == q->b) && (p->c == q->c) && (p->d == q->d);
+		case QUEUE_TEXT:	return (p->a == q->a) && (p->b == q->b) && (p->font == q->font) && queueTextCovers(p, q);
+		default:			return false;
+	}
+}
+
+/*
+ * appends cmd or replaces a pending command with the same key,
+ * the search stops at the first newer command overlapping the region
+ */
+static TFT_QUEUE_RETURN_CODE_t queuePut(const QUEUE_CMD_t *cmd)
+{
+	QUEUE_CMD_t *e;
+	int16_t age;
+
+	for (age = queueNum - 1; age >= 0; age--)
+	{
+		e = queueAt(age);
+		if (queueSameKey(e, cmd))
+		{
+			*e = *cmd;
+			queueStats.coalesced++;
+			return TFT_QUEUE_OK;
+		}
+		if (queueOverlap(e, cmd))
+		{
+			break;
+		}
+	}
+	if (queueNum >= TFT_QUEUE_LEN)
+	{
+		queueStats.dropped++;
+		return TFT_QUEUE_FULL;
+	}
+	queue[queueHead] = *cmd;
+	queueHead = (queueHead + 1) % TFT_QUEUE_LEN;
+	queueNum++;
+	queueStats.queued++;
+	return TFT_QUEUE_OK;
+}
+
+static void queueBox(QUEUE_CMD_t *cmd, int16_t x0, int16_t y0, int16_t x1, int16_t y1)
+{
+	cmd->x0 = (x0 < x1) ? x0 : x1;
+	cmd->x1 = (x0 < x1) ? x1 : x0;
+	cmd->y0 = (y0 < y1) ? y0 : y1;
+	cmd->y1 = (y0 < y1) ? y1 : y0;
+}
+
+static TFT_QUEUE_RETURN_CODE_t queueRect(uint8_t type, int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+	QUEUE_CMD_t cmd;
+
+	if ((w <= 0) || (h <= 0))
+	{
+		return TFT_QUEUE_OK;
+	}
+	cmd.type   = type;
+	cmd.color  = color;
+	cmd.a      = x;
+	cmd.b      = y;
+	cmd.c      = w;
+	cmd.d      = h;
+	cmd.pixels = (uint32_t) w * h;
+	queueBox(&cmd, x, y, x + w - 1, y + h - 1);
+	return queuePut(&cmd);
+}
+
+static void queueExec(QUEUE_CMD_t *e)
+{
+	switch (e->type)
+	{
+		case QUEUE_SCREEN:	tftFillScreen(e->color);								break;
+		case QUEUE_RECT:	tftFillRect(e->a, e->b, e->c, e->d, e->color);			break;
+		case QUEUE_HLINE:	tftDrawFastHLine(e->a, e->b, e->c, e->color);			break;
+		case QUEUE_VLINE:	tftDrawFastVLine(e->a, e->b, e->d, e->color);			break;
+		case QUEUE_LINE:	tftDrawFastLine(e->a, e->b, e->c, e->d, e->color);		break;
+		case QUEUE_FRAME:	tftDrawRect(e->a, e->b, e->c, e->d, e->color);			break;
+		case QUEUE_CIRCLE:	tftDrawCircle(e->a, e->b, e->c, e->color);				break;
+		case QUEUE_DISC:	tftFillCircle(e->a, e->b, e->c, e->color);				break;
+		case QUEUE_TEXT:
+		{
+			ST7735_t *tft = tftGetDisplay();
+			TFT_FONT_t font = tft->font;			// the caller's settings stay untouched
+			uint16_t fg = tft->fg, bg = tft->bg;
+
+			tftSetFont((uint8_t *) e->font);
+			tftSetColor(e->color, e->bg);
+			tftPrint(e->text, e->a, e->b, 0);
+			tft->font = font;
+			tft->fg   = fg;
+			tft->bg   = bg;
+			break;
+		}
+		default:																	break;
+	}
+}
+
+/**
+ * @function tftQueueInit
+ * clears the queue and the statistics, starts the DWT cycle counter
+ */
+void tftQueueInit(void)
+{
+	TFT_QUEUE_CLOCK_ON();
+	queueCyclesPerUs = rccGetHclkFreq() / 1000000;
+	if (0 == queueCyclesPerUs)
+	{
+		queueCyclesPerUs = 1;
+	}
+	queueHead   = 0;
+	queueNum    = 0;
+	memset(&queueStats, 0, sizeof(queueStats));
+	queueStats.cyclesPerPixel = QUEUE_CPP_START;
+}
+
+TFT_QUEUE_RETURN_CODE_t tftQueueFillScreen(uint16_t color)
+{
+	QUEUE_CMD_t cmd;
+
+	cmd.type   = QUEUE_SCREEN;
+	cmd.color  = color;
+	cmd.a      = 0;
+	cmd.b      = 0;
+	cmd.c      = tftGetWidth();
+	cmd.d      = tftGetHeight();
+	cmd.pixels = (uint32_t) tftGetWidth() * tftGetHeight();
+	queueBox(&cmd, 0, 0, tftGetWidth() - 1, tftGetHeight() - 1);
+	queueNum = 0;						// everything pending is overwritten anyway
+	return queuePut(&cmd);
+}
+
+TFT_QUEUE_RETURN_CODE_t tftQueueFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+	return queueRect(QUEUE_RECT, x, y, w, h, color);
+}
+
+TFT_QUEUE_RETURN_CODE_t tftQueueDrawPixel(int16_t x, int16_t y, uint16_t color)
+{
+	return queueRect(QUEUE_RECT, x, y, 1, 1, color);
+}
+
+TFT_QUEUE_RETURN_CODE_t tftQueueDrawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+{
+	return queueRect(QUEUE_HLINE, x, y, w, 1, color);
+}
+
+TFT_QUEUE_RETURN_CODE_t tftQueueDrawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+{
+	return queueRect(QUEUE_VLINE, x, y, 1, h, color);
+}
+
+static TFT_QUEUE_RETURN_CODE_t queueLine(uint8_t type, uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint16_t color)
+{
+	QUEUE_CMD_t cmd;
+	uint16_t dx = (x2 > x1) ? x2 - x1 : x1 - x2;
+	uint16_t dy = (y2 > y1) ? y2 - y1 : y1 - y2;
+
+	cmd.type   = type;
+	cmd.color  = color;
+	cmd.a      = x1;
+	cmd.b      = y1;
+	cmd.c      = x2;
+	cmd.d      = y2;
+	cmd.pixels = (QUEUE_LINE == type) ? ((dx > dy) ? dx : dy) + 1 : 2 * (dx + dy);
+	queueBox(&cmd, x1, y1, x2, y2);
+	return queuePut(&cmd);
+}
+
+TFT_QUEUE_RETURN_CODE_t tftQueueDrawLine(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint16_t color)
+{
+	return queueLine(QUEUE_LINE, x1, y1, x2, y2, color);
+}
+
+TFT_QUEUE_RETURN_CODE_t tftQueueDrawRect(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint16_t color)
+{
+	return queueLine(QUEUE_FRAME, x1, y1, x2, y2, color);
+}
+
+static TFT_QUEUE_RETURN_CODE_t queueCircle(uint8_t type, int16_t x, int16_t y, int16_t radius, uint16_t color)
+{
+	QUEUE_CMD_t cmd;
+
+	if (radius < 0)
+	{
+		return TFT_QUEUE_OK;
+	}
+	cmd.type   = type;
+	cmd.color  = color;
+	cmd.a      = x;
+	cmd.b      = y;
+	cmd.c      = radius;
+	cmd.pixels = (QUEUE_DISC == type) ? (uint32_t) 4 * radius * radius : (uint32_t) 7 * radius;
+	queueBox(&cmd, x - radius, y - radius, x + radius, y + radius);
+	return queuePut(&cmd);
+}
+
+TFT_QUEUE_RETURN_CODE_t tftQueueDrawCircle(int16_t x, int16_t y, int16_t radius, uint16_t color)
+{
+	return queueCircle(QUEUE_CIRCLE, x, y, radius, color);
+}
+
+TFT_QUEUE_RETURN_CODE_t tftQueueFillCircle(int16_t x, int16_t y, int16_t radius, uint16_t color)
+{
+	return queueCircle(QUEUE_DISC, x, y, radius, color);
+}
+
+/**
+ * @function tftQueuePrint
+ * records a text (copied) with its font and colors, x = CENTER or RIGHT as in tftPrint()
+ * a pending text at the same position in the same font is replaced
+ * font and colors of the default display are restored after the text is drawn
+ */
+TFT_QUEUE_RETURN_CODE_t tftQueuePrint(const char *st, int16_t x, int16_t y, const uint8_t *font, uint16_t fg, uint16_t bg)
+{
+	QUEUE_CMD_t cmd;
+	size_t len = strlen(st);
+
+	if (len > TFT_QUEUE_TEXT)
+	{
+		return TFT_QUEUE_TEXT_LONG;
+	}
+	cmd.type   = QUEUE_TEXT;
+	cmd.color  = fg;
+	cmd.bg     = bg;
+	cmd.a      = x;
+	cmd.b      = y;
+	cmd.font   = font;
+	cmd.pixels = (uint32_t) len * font[0] * font[1];
+	memcpy(cmd.text, st, len + 1);
+	if (x < 0)
+	{
+		queueBox(&cmd, 0, y, tftGetWidth() - 1, y + font[1] - 1);		// CENTER, RIGHT: whole line
+	}
+	else
+	{
+		queueBox(&cmd, x, y, x + len * font[0] - 1, y + font[1] - 1);
+	}
+	return queuePut(&cmd);
+}
+
+// learns the cost per pixel from larger commands, 1/8 weight
+static void queueLearn(uint32_t pixels, uint32_t used)
+{
+	uint32_t cpp;
+
+	if (pixels >= 16)
+	{
+		cpp = (used > QUEUE_OVERHEAD) ? (used - QUEUE_OVERHEAD) / pixels : 1;
+		queueStats.cyclesPerPixel = (7 * queueStats.cyclesPerPixel + cpp + 7) / 8;
+	}
+}
+
+/*
+ * draws the first rows of a pending fill which fit into left cycles, at least one row
+ * if force is set; the rest stays queued as a rectangle (e->d = 0: nothing left)
+ */
+static void queueBand(QUEUE_CMD_t *e, uint32_t left, bool force)
+{
+	uint32_t rowCycles = (uint32_t) e->c * queueStats.cyclesPerPixel;
+	uint32_t rows = (left > QUEUE_OVERHEAD) ? (left - QUEUE_OVERHEAD) / rowCycles : 0;
+	uint32_t t0;
+
+	if (0 == rows)
+	{
+		if (!force)
+		{
+			return;
+		}
+		rows = 1;
+		queueStats.forced++;
+	}
+	if (rows > (uint32_t) e->d)
+	{
+		rows = e->d;
+	}
+	t0 = TFT_QUEUE_NOW();
+	tftFillRect(e->a, e->b, e->c, (int16_t) rows, e->color);
+	queueLearn(rows * e->c, TFT_QUEUE_NOW() - t0);
+	e->type    = QUEUE_RECT;
+	e->b      += rows;
+	e->d      -= rows;
+	e->y0      = e->b;
+	e->pixels  = (uint32_t) e->c * e->d;
+	queueStats.bands++;
+}
+
+/**
+ * @function tftQueueDrain
+ * executes pending commands in order as long as the estimated duration fits into the budget
+ * a fill which does not fit is drawn partly in bands of rows, the rest in the next drains
+ * other commands longer than the whole budget can never fit: they are executed as the first
+ * command of a drain
+ *
+ * @param budgetUs : time slice in microseconds
+ * @return number of completed commands
+ */
+uint8_t tftQueueDrain(uint32_t budgetUs)
+{
+	QUEUE_CMD_t *e;
+	uint32_t start = TFT_QUEUE_NOW();
+	uint32_t budget = budgetUs * queueCyclesPerUs;
+	uint32_t t0, est, elapsed, left;
+	uint8_t done = 0;
+	bool progress = false;
+
+	while (queueNum > 0)
+	{
+		e       = queueAt(0);
+		est     = QUEUE_OVERHEAD + e->pixels * queueStats.cyclesPerPixel;
+		elapsed = TFT_QUEUE_NOW() - start;
+		left    = (elapsed < budget) ? budget - elapsed : 0;
+		if ((est > left) && ((QUEUE_SCREEN == e->type) || (QUEUE_RECT == e->type)))
+		{
+			queueBand(e, left, !progress);
+			if (e->d > 0)
+			{
+				break;								// rest in the next drain
+			}
+		}
+		else
+		{
+			if (est > left)
+			{
+				if (progress || (est <= budget))
+				{
+					break;							// fits into the next drain
+				}
+				queueStats.forced++;
+			}
+			t0 = TFT_QUEUE_NOW();
+			queueExec(e);
+			queueLearn(e->pixels, TFT_QUEUE_NOW() - t0);
+		}
+		queueNum--;
+		queueStats.executed++;
+		done++;
+		progress = true;
+	}
+	return done;
+}
+
+uint8_t tftQueuePending(void)
+{
+	return queueNum;
+}
+
+void tftQueueGetStats(TFT_QUEUE_STATS_t *stats)
+{
+	*stats = queueStats;
+}
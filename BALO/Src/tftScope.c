@@ -0,0 +1,202 @@
+/*
+ * tftScope.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: T Flaemig
+ *
+ *  Strip chart with the hardware scroll of the ST7735.
+ *  A column is rasterized into scopeCol (background, grid, one vertical span per channel
+ *  from min to max of its samples, extended to the previous column so the trace stays
+ *  connected) and sent as one address window + one DMA burst. Cost per column: one window,
+ *  size pixels and the VSCRSADD command, independent of the plot width.
+ */
+#include <stddef.h>
+#include <tftScope.h>
+
+static uint16_t scopeCol[ST7735_TFTHEIGHT];
+
+
+static uint8_t scopeAcross(void)
+{
+	return (tftGetWidth() > tftGetHeight()) ? tftGetHeight() : tftGetWidth();
+}
+
+// pixel index across the time axis of a value, hi is at 0
+static int16_t scopePix(const TFT_SCOPE_t *scope, int16_t v)
+{
+	if (v > scope->hi) v = scope->hi;
+	if (v < scope->lo) v = scope->lo;
+	return (int16_t) (((int32_t) (scope->hi - v) * (scope->size - 1)) / (scope->hi - scope->lo));
+}
+
+static void scopeColumn(TFT_SCOPE_t *scope)
+{
+	TFT_SCOPE_CH_t *c;
+	uint16_t i, k;
+	int16_t a, b;
+
+	for (i = 0; i < scope->size; i++)
+	{
+		scopeCol[i] = scope->bg;
+	}
+#if TFT_SCOPE_GRID_T > 0
+	if (0 == (scope->column % TFT_SCOPE_GRID_T))
+	{
+		for (i = 0; i < scope->size; i += 2)
+		{
+			scopeCol[i] = scope->grid;
+		}
+	}
+#endif
+#if TFT_SCOPE_GRID_Y > 0
+	if (0 == (scope->column & 1))
+	{
+		for (k = 0; k <= TFT_SCOPE_GRID_Y; k++)
+		{
+			scopeCol[(uint32_t) (scope->size - 1) * k / TFT_SCOPE_GRID_Y] = scope->grid;
+		}
+	}
+#endif
+	for (k = 0; k < TFT_SCOPE_CHANNELS; k++)
+	{
+		c = &scope->ch[k];
+		if (!c->active)
+		{
+			continue;
+		}
+		a = c->max;
+		b = c->min;
+		if (c->valid)
+		{
+			if (b > c->prevMax) b = c->prevMax;		// rising: connect from below
+			if (a < c->prevMin) a = c->prevMin;		// falling: connect from above
+		}
+		c->prevMin = c->min;
+		c->prevMax = c->max;
+		c->valid   = true;
+		for (i = scopePix(scope, a); i <= scopePix(scope, b); i++)
+		{
+			scopeCol[i] = c->color;
+		}
+	}
+
+	tftScrollLineWindow(scope->line, scope->pos, scope->pos + scope->size - 1);
+	tftStreamBegin();
+	tftStreamPush(scopeCol, scope->size);
+	tftStreamEnd();
+
+	// the written line (the oldest one) becomes the last line of the screen
+	if (++scope->line >= tftScrollLines())
+	{
+		scope->line = 0;
+	}
+	tftScrollTo(scope->line);
+	scope->column++;
+}
+
+/**
+ * @function tftScopeInit
+ * clears the plot area, defines the whole screen as scroll area and sets the position to 0
+ *
+ * @param pos, size : pixels across the time axis (y and height in LANDSCAPE)
+ * @param lo, hi    : value range of the plot
+ * @param decim     : samples per column, > 1 shows the min/max envelope
+ * @param bg, grid  : colors
+ */
+TFT_SCOPE_RETURN_CODE_t tftScopeInit(TFT_SCOPE_t *scope, uint8_t pos, uint8_t size, int16_t lo, int16_t hi,
+									 uint16_t decim, uint16_t bg, uint16_t grid)
+{
+	uint8_t k;
+
+	if ((hi <= lo) || (size < 2) || (pos + size > scopeAcross()))
+	{
+		return TFT_SCOPE_RANGE;
+	}
+	scope->pos    = pos;
+	scope->size   = size;
+	scope->lo     = lo;
+	scope->hi     = hi;
+	scope->decim  = (decim > 0) ? decim : 1;
+	scope->count  = 0;
+	scope->line   = 0;
+	scope->column = 0;
+	scope->bg     = bg;
+	scope->grid   = grid;
+	for (k = 0; k < TFT_SCOPE_CHANNELS; k++)
+	{
+		scope->ch[k].active = false;
+	}
+
+	tftScrollDefine(0, tftScrollLines(), 0);
+	tftScrollTo(0);
+	if (tftGetWidth() > tftGetHeight())
+	{
+		tftFillRect(0, pos, tftGetWidth(), size, bg);
+	}
+	else
+	{
+		tftFillRect(pos, 0, size, tftGetHeight(), bg);
+	}
+	return TFT_SCOPE_OK;
+}
+
+/**
+ * @function tftScopeSetChannel
+ * activates channel ch with its trace color
+ */
+TFT_SCOPE_RETURN_CODE_t tftScopeSetChannel(TFT_SCOPE_t *scope, uint8_t ch, uint16_t color)
+{
+	if (ch >= TFT_SCOPE_CHANNELS)
+	{
+		return TFT_SCOPE_CHANNEL;
+	}
+	scope->ch[ch].color  = color;
+	scope->ch[ch].active = true;
+	scope->ch[ch].valid  = false;
+	return TFT_SCOPE_OK;
+}
+
+/**
+ * @function tftScopeAddSample
+ * adds one sample per channel, every decim samples a new column is drawn
+ *
+ * @param values : TFT_SCOPE_CHANNELS values, inactive channels are ignored
+ * @return true if a column was drawn
+ */
+bool tftScopeAddSample(TFT_SCOPE_t *scope, const int16_t *values)
+{
+	TFT_SCOPE_CH_t *c;
+	uint8_t k;
+
+	for (k = 0; k < TFT_SCOPE_CHANNELS; k++)
+	{
+		c = &scope->ch[k];
+		if (0 == scope->count)
+		{
+			c->min = values[k];
+			c->max = values[k];
+		}
+		else
+		{
+			if (values[k] < c->min) c->min = values[k];
+			if (values[k] > c->max) c->max = values[k];
+		}
+	}
+	if (++scope->count < scope->decim)
+	{
+		return false;
+	}
+	scope->count = 0;
+	scopeColumn(scope);
+	return true;
+}
+
+/**
+ * @function tftScopeStop
+ * resets the scroll position, the screen content has to be redrawn afterwards
+ */
+void tftScopeStop(TFT_SCOPE_t *scope)
+{
+	scope->count = 0;
+	tftScrollTo(0);
+}
@@ -0,0 +1,372 @@
+/*
+ * tftWidget.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: T Flaemig
+ *
+ *  Retained widgets with delta rendering on top of ST7735.c.
+ *  Texts are compared character by character, only changed characters are printed (one
+ *  address window each with the glyph blitter). Characters missing in the font, e.g. the
+ *  space in SevenSegNumFont, are drawn as background.
+ */
+#include <stddef.h>
+#include <string.h>
+#include <tftWidget.h>
+
+#define WIDGET_WINDOW_BYTES		(11)		// CASET + 4, RASET + 4, RAMWR (upper bound, see ST7735_t)
+
+static TFT_WIDGET_COST_t widgetCost;
+
+
+static uint32_t widgetAdd(uint32_t pixels, uint32_t windows)
+{
+	uint32_t bytes = 2 * pixels + WIDGET_WINDOW_BYTES * windows;
+
+	widgetCost.pixels  += pixels;
+	widgetCost.windows += windows;
+	widgetCost.bytes   += bytes;
+	return bytes;
+}
+
+static uint32_t widgetFill(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+	if ((w <= 0) || (h <= 0))
+	{
+		return 0;
+	}
+	tftFillRect(x, y, w, h, color);
+	return widgetAdd((uint32_t) w * h, 1);
+}
+
+// font and colors have to be set
+static uint32_t widgetChar(const uint8_t *font, char c, int16_t x, int16_t y, uint16_t bg)
+{
+	if (((uint8_t) c < font[2]) || ((uint8_t) c >= font[2] + font[3]))
+	{
+		return widgetFill(x, y, font[0], font[1], bg);
+	}
+	tftPrintChar((uint8_t) c, x, y);
+	return widgetAdd((uint32_t) font[0] * font[1], 1);
+}
+
+/*
+ * draws st padded with spaces to len characters, only where it differs from old
+ * (old == NULL: all characters)
+ */
+static uint32_t widgetText(const uint8_t *font, int16_t x, int16_t y, uint16_t fg, uint16_t bg,
+						   uint8_t len, const char *st, char *old)
+{
+	uint32_t bytes = 0;
+	bool end = false;
+	uint8_t i;
+	char c;
+
+	tftSetFont((uint8_t *) font);
+	tftSetColor(fg, bg);
+	for (i = 0; i < len; i++)
+	{
+		if (!end && (st[i] == '\0'))
+		{
+			end = true;
+		}
+		c = end ? ' ' : st[i];
+		if ((NULL == old) || (old[i] != c))
+		{
+			bytes += widgetChar(font, c, x + i * font[0], y, bg);
+			if (NULL != old)
+			{
+				old[i] = c;
+			}
+		}
+	}
+	return bytes;
+}
+
+/**
+ * @function tftLabelInit
+ * text field of len characters at x, y (not drawn before the first tftLabelSet)
+ */
+void tftLabelInit(TFT_LABEL_t *lbl, int16_t x, int16_t y, const uint8_t *font, uint16_t fg, uint16_t bg, uint8_t len)
+{
+	lbl->x     = x;
+	lbl->y     = y;
+	lbl->font  = font;
+	lbl->fg    = fg;
+	lbl->bg    = bg;
+	lbl->len   = (len > TFT_WIDGET_TEXT) ? TFT_WIDGET_TEXT : len;
+	lbl->valid = false;
+	lbl->text[lbl->len] = '\0';
+}
+
+/**
+ * @function tftLabelSet
+ * shows text, padded with spaces or cut to the field width, only changed characters are drawn
+ *
+ * @return bus bytes of this update
+ */
+uint32_t tftLabelSet(TFT_LABEL_t *lbl, const char *text)
+{
+	if (!lbl->valid)
+	{
+		memset(lbl->text, 0, lbl->len);			// no character matches
+		lbl->valid = true;
+	}
+	return widgetText(lbl->font, lbl->x, lbl->y, lbl->fg, lbl->bg, lbl->len, text, lbl->text);
+}
+
+/**
+ * @function tftNumberInit
+ * right aligned fixed point number with len characters, decimals digits after the point
+ */
+void tftNumberInit(TFT_NUMBER_t *num, int16_t x, int16_t y, const uint8_t *font, uint16_t fg, uint16_t bg,
+				   uint8_t len, uint8_t decimals)
+{
+	tftLabelInit(&num->label, x, y, font, fg, bg, len);
+	num->decimals = decimals;
+}
+
+/**
+ * @function tftNumberSet
+ * shows value / 10^decimals, e.g. 1234 with 2 decimals as "12.34", '#' if it does not fit
+ * only the digits that differ from the shown number are drawn
+ *
+ * @return bus bytes of this update
+ */
+uint32_t tftNumberSet(TFT_NUMBER_t *num, int32_t value)
+{
+	char st[TFT_WIDGET_TEXT + 1];
+	uint8_t len = num->label.len;
+	uint32_t v = (value < 0) ? -(uint32_t) value : (uint32_t) value;
+	int16_t i = len;
+	uint8_t digits = 0;
+	bool point = false;
+
+	st[len] = '\0';
+	while (i > 0)
+	{
+		if ((num->decimals > 0) && (digits == num->decimals) && !point)
+		{
+			st[--i] = '.';
+			point = true;
+			continue;
+		}
+		st[--i] = '0' + (v % 10);
+		v /= 10;
+		digits++;
+		if ((0 == v) && (digits > num->decimals))
+		{
+			break;
+		}
+	}
+	if ((v > 0) || (digits <= num->decimals) || ((value < 0) && (0 == i)))
+	{
+		memset(st, '#', len);					// does not fit
+		i = 0;
+	}
+	else if (value < 0)
+	{
+		st[--i] = '-';
+	}
+	while (i > 0)
+	{
+		st[--i] = ' ';
+	}
+	return tftLabelSet(&num->label, st);
+}
+
+/**
+ * @function tftBarInit
+ * horizontal bar graph with a frame, value range min ... max
+ */
+void tftBarInit(TFT_BAR_t *bar, int16_t x, int16_t y, int16_t w, int16_t h, int32_t min, int32_t max,
+				uint16_t fg, uint16_t bg, uint16_t frame)
+{
+	bar->x     = x;
+	bar->y     = y;
+	bar->w     = w;
+	bar->h     = h;
+	bar->min   = min;
+	bar->max   = (max > min) ? max : min + 1;
+	bar->fg    = fg;
+	bar->bg    = bg;
+	bar->frame = frame;
+	bar->fill  = -1;
+}
+
+/**
+ * @function tftBarSet
+ * only the pixel columns between the old and the new end of the bar are drawn
+ *
+ * @return bus bytes of this update
+ */
+uint32_t tftBarSet(TFT_BAR_t *bar, int32_t value)
+{
+	int16_t inner = bar->w - 2;
+	int16_t fill;
+	uint32_t bytes = 0;
+
+	if (value < bar->min) value = bar->min;
+	if (value > bar->max) value = bar->max;
+	fill = (int16_t) (((int64_t) (value - bar->min) * inner) / (bar->max - bar->min));
+
+	if (bar->fill < 0)
+	{
+		bytes += widgetFill(bar->x, bar->y, bar->w, 1, bar->frame);
+		bytes += widgetFill(bar->x, bar->y + bar->h - 1, bar->w, 1, bar->frame);
+		bytes += widgetFill(bar->x, bar->y + 1, 1, bar->h - 2, bar->frame);
+		bytes += widgetFill(bar->x + bar->w - 1, bar->y + 1, 1, bar->h - 2, bar->frame);
+		bytes += widgetFill(bar->x + 1, bar->y + 1, fill, bar->h - 2, bar->fg);
+		bytes += widgetFill(bar->x + 1 + fill, bar->y + 1, inner - fill, bar->h - 2, bar->bg);
+	}
+	else if (fill > bar->fill)
+	{
+		bytes += widgetFill(bar->x + 1 + bar->fill, bar->y + 1, fill - bar->fill, bar->h - 2, bar->fg);
+	}
+	else if (fill < bar->fill)
+	{
+		bytes += widgetFill(bar->x + 1 + fill, bar->y + 1, bar->fill - fill, bar->h - 2, bar->bg);
+	}
+	bar->fill = fill;
+	return bytes;
+}
+
+/**
+ * @function tftMenuInit
+ * grid of num cells in cols columns, chars characters per cell, items are not copied
+ */
+void tftMenuInit(TFT_MENU_t *menu, int16_t x, int16_t y, const char * const *items, uint8_t num, uint8_t cols,
+				 uint8_t chars, const uint8_t *font, uint16_t fg, uint16_t bg, uint16_t selFg, uint16_t selBg)
+{
+	menu->x     = x;
+	menu->y     = y;
+	menu->items = items;
+	menu->num   = num;
+	menu->cols  = (cols > 0) ? cols : 1;
+	menu->chars = chars;
+	menu->font  = font;
+	menu->fg    = fg;
+	menu->bg    = bg;
+	menu->selFg = selFg;
+	menu->selBg = selBg;
+	menu->sel   = -1;
+}
+
+static uint32_t menuCell(const TFT_MENU_t *menu, uint8_t i, bool selected)
+{
+	int16_t x = menu->x + (i % menu->cols) * (menu->chars * menu->font[0] + TFT_MENU_GAP);
+	int16_t y = menu->y + (i / menu->cols) * (menu->font[1] + TFT_MENU_GAP);
+
+	return widgetText(menu->font, x, y, selected ? menu->selFg : menu->fg, selected ? menu->selBg : menu->bg,
+					  menu->chars, menu->items[i], NULL);
+}
+
+/**
+ * @function tftMenuSelect
+ * highlights cell sel (-1: none), only the previous and the new selected cell are drawn
+ *
+ * @return bus bytes of this update
+ */
+uint32_t tftMenuSelect(TFT_MENU_t *menu, int16_t sel)
+{
+	uint32_t bytes = 0;
+	uint8_t i;
+
+	if (sel >= menu->num)
+	{
+		sel = -1;
+	}
+	if (menu->sel == -1)
+	{
+		for (i = 0; i < menu->num; i++)
+		{
+			bytes += menuCell(menu, i, i == sel);
+		}
+	}
+	else if (sel != menu->sel)
+	{
+		if (menu->sel >= 0)
+		{
+			bytes += menuCell(menu, menu->sel, false);
+		}
+		if (sel >= 0)
+		{
+			bytes += menuCell(menu, sel, true);
+		}
+	}
+	// -2: drawn without selection, -1 is reserved for "not drawn"
+	menu->sel = (sel >= 0) ? sel : -2;
+	return bytes;
+}
+
+/**
+ * @function tftIconInit
+ * status icon with one image per state
+ */
+void tftIconInit(TFT_ICON_t *icon, int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t * const *images,
+				 uint8_t states)
+{
+	icon->x      = x;
+	icon->y      = y;
+	icon->w      = w;
+	icon->h      = h;
+	icon->images = images;
+	icon->states = states;
+	icon->state  = -1;
+}
+
+/**
+ * @function tftIconSet
+ * shows the image of state, per row only the span between the first and the last pixel
+ * differing from the shown image is sent
+ *
+ * @return bus bytes of this update
+ */
+uint32_t tftIconSet(TFT_ICON_t *icon, uint8_t state)
+{
+	const uint16_t *img, *old;
+	uint32_t bytes = 0;
+	int16_t r, a, b;
+
+	if ((state >= icon->states) || (state == icon->state))
+	{
+		return 0;
+	}
+	img = icon->images[state];
+	if (icon->state < 0)
+	{
+		tftSetAddrWindow(icon->x, icon->y, icon->x + icon->w - 1, icon->y + icon->h - 1);
+		tftStreamBegin();
+		tftStreamPush(img, (uint16_t) (icon->w * icon->h));
+		tftStreamEnd();
+		icon->state = state;
+		return widgetAdd((uint32_t) icon->w * icon->h, 1);
+	}
+	old = icon->images[icon->state];
+	for (r = 0; r < icon->h; r++, img += icon->w, old += icon->w)
+	{
+		for (a = 0; (a < icon->w) && (img[a] == old[a]); a++);
+		if (a == icon->w)
+		{
+			continue;
+		}
+		for (b = icon->w - 1; img[b] == old[b]; b--);
+		tftSetAddrWindow(icon->x + a, icon->y + r, icon->x + b, icon->y + r);
+		tftStreamBegin();
+		tftStreamPush(&img[a], b - a + 1);
+		tftStreamEnd();
+		bytes += widgetAdd(b - a + 1, 1);
+	}
+	icon->state = state;
+	return bytes;
+}
+
+// total cost of all widget updates since tftWidgetResetCost()
+void tftWidgetGetCost(TFT_WIDGET_COST_t *cost)
+{
+	*cost = widgetCost;
+}
+
+void tftWidgetResetCost(void)
+{
+	memset(&widgetCost, 0, sizeof(widgetCost));
+}
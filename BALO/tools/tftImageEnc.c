@@ -0,0 +1,433 @@
+/*
+ * tftImageEnc.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: T Flaemig
+ *
+ *  PC tool: converts a binary PPM image (P6, e.g. exported by GIMP) into a C array in the
+ *  format of BALO/Inc/tftImage.h for tftDrawImage().
+ *
+ *  build:  gcc -O2 -o tftImageEnc tftImageEnc.c
+ *  usage:  tftImageEnc [-f raw|rle|pal|palrle|qoi] [-n name] image.ppm > image.c
+ *
+ *  Without -f the smallest of raw, rle, pal and palrle is chosen, qoi needs TFT_IMAGE_QOI
+ *  on the target and is only used with -f qoi. The palette formats need 256 or less
+ *  different RGB565 colors, there is no color reduction.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define TFT_IMG_RAW			0
+#define TFT_IMG_RLE			1
+#define TFT_IMG_PAL			2
+#define TFT_IMG_PAL_RLE		3
+#define TFT_IMG_QOI			4
+
+typedef struct
+{
+	uint8_t		*data;
+	size_t		len;
+	size_t		size;
+} BUF_t;
+
+static const char *formatName[] = { "raw", "rle", "pal", "palrle", "qoi" };
+
+static uint16_t width, height;
+static uint16_t *pix;				// RGB565
+static uint16_t palette[256];
+static uint16_t colors;				// 0: more than 256
+
+
+static void put8(BUF_t *b, uint8_t v)
+{
+	if (b->len == b->size)
+	{
+		b->size = b->size ? 2 * b->size : 1024;
+		b->data = realloc(b->data, b->size);
+		if (b->data == NULL)
+		{
+			fprintf(stderr, "out of memory\n");
+			exit(1);
+		}
+	}
+	b->data[b->len++] = v;
+}
+
+static void put16(BUF_t *b, uint16_t v)
+{
+	put8(b, v & 0xFF);
+	put8(b, v >> 8);
+}
+
+static void put32be(BUF_t *b, uint32_t v)
+{
+	put8(b, v >> 24);
+	put8(b, v >> 16);
+	put8(b, v >> 8);
+	put8(b, v);
+}
+
+static int readNumber(FILE *f)
+{
+	int c, n = 0;
+
+	do
+	{
+		c = fgetc(f);
+		if (c == '#')
+		{
+			while ((c != '\n') && (c != EOF))
+			{
+				c = fgetc(f);
+			}
+		}
+	} while ((c == ' ') || (c == '\t') || (c == '\r') || (c == '\n'));
+	while ((c >= '0') && (c <= '9'))
+	{
+		n = 10 * n + c - '0';
+		c = fgetc(f);
+	}
+	return n;
+}
+
+static bool readPpm(const char *name)
+{
+	FILE *f = fopen(name, "rb");
+	uint8_t rgb[3];
+	uint32_t i;
+	int max;
+
+	if ((f == NULL) || (fgetc(f) != 'P') || (fgetc(f) != '6'))
+	{
+		fprintf(stderr, "%s: no binary PPM (P6)\n", name);
+		return false;
+	}
+	width  = readNumber(f);
+	height = readNumber(f);
+	max    = readNumber(f);				// one whitespace follows, already read
+	if ((width == 0) || (height == 0) || (max != 255))
+	{
+		fprintf(stderr, "%s: size 0 or not 8 bit per color\n", name);
+		return false;
+	}
+	pix = malloc((size_t) width * height * sizeof(uint16_t));
+	for (i = 0; i < (uint32_t) width * height; i++)
+	{
+		if (fread(rgb, 1, 3, f) != 3)
+		{
+			fprintf(stderr, "%s: file too short\n", name);
+			return false;
+		}
+		pix[i] = ((rgb[0] & 0xF8) << 8) | ((rgb[1] & 0xFC) << 3) | (rgb[2] >> 3);
+	}
+	fclose(f);
+	return true;
+}
+
+static int paletteIndex(uint16_t color)
+{
+	int i;
+
+	for (i = 0; i < colors; i++)
+	{
+		if (palette[i] == color)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+static void makePalette(void)
+{
+	uint32_t i;
+
+	colors = 0;
+	for (i = 0; i < (uint32_t) width * height; i++)
+	{
+		if (paletteIndex(pix[i]) < 0)
+		{
+			if (colors == 256)
+			{
+				colors = 0;
+				return;
+			}
+			palette[colors++] = pix[i];
+		}
+	}
+}
+
+static void putHeader(BUF_t *b, uint8_t format, uint8_t bpp, uint16_t numColors)
+{
+	uint16_t i;
+
+	put8(b, 'T');
+	put8(b, 'I');
+	put8(b, format);
+	put8(b, bpp);
+	put16(b, width);
+	put16(b, height);
+	put16(b, numColors);
+	for (i = 0; i < numColors; i++)
+	{
+		put16(b, palette[i]);
+	}
+}
+
+static void putValue(BUF_t *b, uint16_t v, bool index)
+{
+	if (index)
+	{
+		put8(b, v);
+	}
+	else
+	{
+		put16(b, v);
+	}
+}
+
+/* packets of max. 128 pixels: runs of min pixels or more are one repeat packet, all other
+ * pixels are collected in literal packets
+ */
+static void encodeRle(BUF_t *b, const uint16_t *val, uint32_t num, bool index)
+{
+	uint32_t i = 0, lit, run, k;
+	uint32_t min = index ? 3 : 2;
+
+	while (i < num)
+	{
+		for (run = 1; (i + run < num) && (run < 128) && (val[i + run] == val[i]); run++);
+		if (run >= min)
+		{
+			put8(b, 0x80 | (run - 1));
+			putValue(b, val[i], index);
+			i += run;
+			continue;
+		}
+		// literal up to the next run
+		for (lit = 1; (i + lit < num) && (lit < 128); lit++)
+		{
+			for (run = 1; (i + lit + run < num) && (run < min) && (val[i + lit + run] == val[i + lit]); run++);
+			if (run >= min)
+			{
+				break;
+			}
+		}
+		put8(b, lit - 1);
+		for (k = 0; k < lit; k++)
+		{
+			putValue(b, val[i + k], index);
+		}
+		i += lit;
+	}
+}
+
+static void encodePal(BUF_t *b)
+{
+	uint32_t i, num = (uint32_t) width * height;
+	uint8_t bpp = (colors <= 2) ? 1 : (colors <= 4) ? 2 : (colors <= 16) ? 4 : 8;
+	uint8_t cur = 0, bits = 0;
+
+	putHeader(b, TFT_IMG_PAL, bpp, colors);
+	for (i = 0; i < num; i++)
+	{
+		cur = (cur << bpp) | paletteIndex(pix[i]);
+		bits += bpp;
+		if (bits == 8)
+		{
+			put8(b, cur);
+			cur  = 0;
+			bits = 0;
+		}
+	}
+	if (bits > 0)
+	{
+		put8(b, cur << (8 - bits));
+	}
+}
+
+// QOI with 3 channels (https://qoiformat.org), the RGB565 colors expanded to 8 bit, alpha 255
+static void encodeQoi(BUF_t *b)
+{
+	uint8_t index[64][4];
+	uint8_t px[4], prev[4] = { 0, 0, 0, 255 };
+	uint32_t i, num = (uint32_t) width * height;
+	uint8_t run = 0, h;
+	int8_t vr, vg, vb, vgr, vgb;
+
+	memset(index, 0, sizeof(index));
+	putHeader(b, TFT_IMG_QOI, 0, 0);
+	put8(b, 'q'); put8(b, 'o'); put8(b, 'i'); put8(b, 'f');
+	put32be(b, width);
+	put32be(b, height);
+	put8(b, 3);
+	put8(b, 0);
+	for (i = 0; i < num; i++)
+	{
+		px[0] = ((pix[i] >> 8) & 0xF8) | (pix[i] >> 13);
+		px[1] = ((pix[i] >> 3) & 0xFC) | ((pix[i] >> 9) & 0x03);
+		px[2] = ((pix[i] << 3) & 0xF8) | ((pix[i] >> 2) & 0x07);
+		px[3] = 255;
+		if (memcmp(px, prev, 4) == 0)
+		{
+			run++;
+			if ((run == 62) || (i == num - 1))
+			{
+				put8(b, 0xC0 | (run - 1));
+				run = 0;
+			}
+			continue;
+		}
+		if (run > 0)
+		{
+			put8(b, 0xC0 | (run - 1));
+			run = 0;
+		}
+		h = (px[0] * 3 + px[1] * 5 + px[2] * 7 + 255 * 11) & 0x3F;
+		if (memcmp(index[h], px, 4) == 0)
+		{
+			put8(b, h);
+		}
+		else
+		{
+			memcpy(index[h], px, 4);
+			vr = px[0] - prev[0];
+			vg = px[1] - prev[1];
+			vb = px[2] - prev[2];
+			vgr = vr - vg;
+			vgb = vb - vg;
+			if ((vr > -3) && (vr < 2) && (vg > -3) && (vg < 2) && (vb > -3) && (vb < 2))
+			{
+				put8(b, 0x40 | ((vr + 2) << 4) | ((vg + 2) << 2) | (vb + 2));
+			}
+			else if ((vgr > -9) && (vgr < 8) && (vg > -33) && (vg < 32) && (vgb > -9) && (vgb < 8))
+			{
+				put8(b, 0x80 | (vg + 32));
+				put8(b, ((vgr + 8) << 4) | (vgb + 8));
+			}
+			else
+			{
+				put8(b, 0xFE);
+				put8(b, px[0]);
+				put8(b, px[1]);
+				put8(b, px[2]);
+			}
+		}
+		memcpy(prev, px, 4);
+	}
+	for (i = 0; i < 7; i++)
+	{
+		put8(b, 0);
+	}
+	put8(b, 1);
+}
+
+static void encode(BUF_t *b, int format)
+{
+	uint32_t i, num = (uint32_t) width * height;
+	uint16_t *idx;
+
+	b->len = 0;
+	switch (format)
+	{
+		case TFT_IMG_RAW:
+			putHeader(b, TFT_IMG_RAW, 0, 0);
+			for (i = 0; i < num; i++)
+			{
+				put16(b, pix[i]);
+			}
+			break;
+		case TFT_IMG_RLE:
+			putHeader(b, TFT_IMG_RLE, 0, 0);
+			encodeRle(b, pix, num, false);
+			break;
+		case TFT_IMG_PAL:
+			encodePal(b);
+			break;
+		case TFT_IMG_PAL_RLE:
+			putHeader(b, TFT_IMG_PAL_RLE, 0, colors);
+			idx = malloc(num * sizeof(uint16_t));
+			for (i = 0; i < num; i++)
+			{
+				idx[i] = paletteIndex(pix[i]);
+			}
+			encodeRle(b, idx, num, true);
+			free(idx);
+			break;
+		default:
+			encodeQoi(b);
+			break;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	const char *name = "image", *file = NULL;
+	int format = -1, f, i;
+	BUF_t best = { 0 }, b = { 0 };
+
+	for (i = 1; i < argc; i++)
+	{
+		if ((strcmp(argv[i], "-n") == 0) && (i + 1 < argc))
+		{
+			name = argv[++i];
+		}
+		else if ((strcmp(argv[i], "-f") == 0) && (i + 1 < argc))
+		{
+			i++;
+			for (f = TFT_IMG_QOI; (f >= 0) && (strcmp(argv[i], formatName[f]) != 0); f--);
+			if (f < 0)
+			{
+				fprintf(stderr, "unknown format %s\n", argv[i]);
+				return 1;
+			}
+			format = f;
+		}
+		else
+		{
+			file = argv[i];
+		}
+	}
+	if ((file == NULL) || !readPpm(file))
+	{
+		fprintf(stderr, "usage: tftImageEnc [-f raw|rle|pal|palrle|qoi] [-n name] image.ppm > image.c\n");
+		return 1;
+	}
+	makePalette();
+	if (((format == TFT_IMG_PAL) || (format == TFT_IMG_PAL_RLE)) && (colors == 0))
+	{
+		fprintf(stderr, "more than 256 colors, no palette format possible\n");
+		return 1;
+	}
+
+	for (f = TFT_IMG_RAW; f <= TFT_IMG_QOI; f++)
+	{
+		if (((format >= 0) && (f != format)) || ((format < 0) && (f == TFT_IMG_QOI)) ||
+			(((f == TFT_IMG_PAL) || (f == TFT_IMG_PAL_RLE)) && (colors == 0)))
+		{
+			continue;
+		}
+		encode(&b, f);
+		fprintf(stderr, "%-6s %7zu bytes\n", formatName[f], b.len);
+		if ((best.len == 0) || (b.len < best.len))
+		{
+			BUF_t t = best;
+			best = b;
+			b = t;
+		}
+	}
+
+	fprintf(stderr, "%s: %ux%u, %u colors, %s, %zu bytes (RGB565 %u)\n", name, width, height,
+			colors, formatName[best.data[2]], best.len, 2u * width * height);
+	printf("// %ux%u %s, created by tftImageEnc from %s\n", width, height, formatName[best.data[2]], file);
+	printf("const uint8_t %s[%zu] =\n{", name, best.len);
+	for (i = 0; i < (int) best.len; i++)
+	{
+		printf("%s0x%02X,", (i % 16) ? " " : "\n\t", best.data[i]);
+	}
+	printf("\n};\n");
+	return 0;
+}
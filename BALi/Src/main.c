@@ -280,8 +280,19 @@ void rotControl(int16_t* setPos, float* targetPos, float phi, int16_t motPosL, i
 #define DevTOF1  0b1000
 
 
+static uint8_t i2c1Present[I2C_SCAN_MAP_SIZE], i2c2Present[I2C_SCAN_MAP_SIZE];	// Presence bitmaps of the single pass scan
+
+/* returns i2cAddr if the slave has been found on the bus by the scan, otherwise 0 */
+static uint8_t i2cScanFound(I2C_TypeDef *i2c, uint8_t i2cAddr)
+{
+	uint8_t *map = (i2c == I2C1) ? i2c1Present : i2c2Present;
+
+	return (I2C_SCAN_PRESENT(map, i2cAddr)) ? i2cAddr : 0;
+}
+
 int CheckAndInitI2cSlaves(uint8_t* DevMask, Stepper_t* pStepL, Stepper_t* pStepR, MPU6050_t* pMPU1,TOFSensor_t* pTOF1)
 {
+	static const uint8_t scanList[] = { i2cAddr_motL, i2cAddr_motR, i2cAddr_MPU6050, i2cAddr_TOF1 };
 	I2C_TypeDef *i2c = I2C1, *i2c2 = I2C2;
 	static I2C_TypeDef *i2cMPU = I2C1;
 	static I2C_TypeDef *i2cSTEP = I2C1;
@@ -299,14 +310,21 @@ int CheckAndInitI2cSlaves(uint8_t* DevMask, Stepper_t* pStepL, Stepper_t* pStepR
 		return (CycleRun);
 	}
 
+	if ((CycleRun == -4) || (CycleRun == -3) || (( *DevMask & DevStepR) == 0))
+	{	// all known slaves on both buses in a single pass, a few 100us; fresh in every cycle with a lookup below,
+		// so a slave plugged in later is found
+		i2cScanBus(i2c,  scanList, sizeof(scanList), i2c1Present);
+		i2cScanBus(i2c2, scanList, sizeof(scanList), i2c2Present);
+	}
+
 	if ((( *DevMask & DevStepL) == 0)&& (CycleRun == -4))
 	{
 		i2c_Addr = i2cAddr_motL;
-		foundAddr = i2cFindSlaveAddr(i2cSTEP, i2c_Addr);
+		foundAddr = i2cScanFound(i2cSTEP, i2c_Addr);
 		if (foundAddr == 0)
 		{
 			i2cSTEP = I2C2;
-			foundAddr = i2cFindSlaveAddr(i2cSTEP, i2c_Addr);
+			foundAddr = i2cScanFound(i2cSTEP, i2c_Addr);
 		}
 		if (foundAddr == i2c_Addr)
 		{
@@ -324,7 +342,7 @@ int CheckAndInitI2cSlaves(uint8_t* DevMask, Stepper_t* pStepL, Stepper_t* pStepR
 	}
 	if (( *DevMask & DevStepR) == 0)
 	{
-		foundAddr = i2cFindSlaveAddr(i2cSTEP, i2cAddr_motR);
+		foundAddr = i2cScanFound(i2cSTEP, i2cAddr_motR);
 		if (foundAddr != 0)
 		{
 			//  StepRenable = true;
@@ -333,7 +351,8 @@ int CheckAndInitI2cSlaves(uint8_t* DevMask, Stepper_t* pStepL, Stepper_t* pStepR
 			StepperInit(pStepR, i2cSTEP, i2cAddr_motR,StepPaValue[0], StepPaValue[1], StepPaValue[2],StepPaValue[3],stepMode,(uint8_t)stepRotDir, StepPaValue[4], 0);
 			stepper.pwmFrequency.set(pStepR, 0);
 			*DevMask |= DevStepR;
-			i2cSetClkSpd(i2cSTEP,  I2C_CLOCK_200); //speed up I2CBusclock max Stepper 400kHz<- doesn't worked
+			i2cSetSlaveSpeed(i2cSTEP, i2cAddr_motL, 200000); // Stepper max 200kHz (400kHz doesn't worked),
+			i2cSetSlaveSpeed(i2cSTEP, i2cAddr_motR, 200000); // other slaves on the bus keep their own speed
 		}
 		else
 		{ pStepR->i2cAddress.value = 0; }			// if StepperRight not exist set pointer to NULL
@@ -385,11 +404,11 @@ int CheckAndInitI2cSlaves(uint8_t* DevMask, Stepper_t* pStepL, Stepper_t* pStepR
 	// MPU6050 check and Init with 3 runs
 	if (CycleRun == -3)
 	{	// detected and first initrun
-		foundAddr = i2cFindSlaveAddr(i2cMPU, i2cAddr_MPU6050);
+		foundAddr = i2cScanFound(i2cMPU, i2cAddr_MPU6050);
 		if (foundAddr == 0)
 		{
 			i2cMPU = I2C2;
-			foundAddr = i2cFindSlaveAddr(i2cMPU, i2cAddr_MPU6050);
+			foundAddr = i2cScanFound(i2cMPU, i2cAddr_MPU6050);
 		}
 		if (foundAddr != 0)
 		{
@@ -746,7 +765,8 @@ int main(void)
 			systickSetTicktime(&DispTaskTimer, DispTaskTimeSet);   // Reset Disp timer
 		if (( DevPrMask & DevTOF1) != 0)
 		{
-			if (TOF_read_distance_task(&TOF1))
+			// queued: the I2C transfers of the stepper/IMU loop are served first
+			if (TOF_read_distance_queued(&TOF1, I2C_PRIO_TELEMETRY))
 			//if (TOF_start_up_task(&TOF1))
 			{
 				visualisationTOF(&TOF1);
@@ -865,7 +885,7 @@ void dispMPUBat(MPU6050_t* pMPU1, analogCh_t* pADChn)
 {
 	//ADC_TypeDef   *adc= ADC1;
 	char strT[20];
-	float Temp = mpuGetTemp(pMPU1);
+	float Temp = mpuPollTemp(pMPU1, I2C_PRIO_UI);		// value of the previous call, no wait for the bus
 	BatStat_t BatStatus;
 	BatStatus = getBatVolt(pADChn);
 
@@ -0,0 +1,130 @@
+/**
+ * core_cm4.h (host build of the I2C emulator)
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: T Flaemig
+ *
+ *  stm32f401xe.h includes "core_cm4.h". In the host build I2CEmu/Inc is searched first, so this
+ *  file replaces cmsis_compiler.h / cmsis_gcc.h (ARM inline assembly) by host versions of the
+ *  intrinsics used by MCAL and then includes the original CMSIS core_cm4.h for the register
+ *  definitions (SCB, NVIC, DWT, CoreDebug ...). PRIMASK is emulated by emuCore.c.
+ */
+
+#ifndef EMU_CORE_CM4_H_
+#define EMU_CORE_CM4_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define __CMSIS_COMPILER_H                                      // Skip CMSIS/Include/cmsis_compiler.h
+
+#define __ASM                       __asm
+#define __INLINE                    inline
+#define __STATIC_INLINE             static inline
+#define __STATIC_FORCEINLINE        __attribute__((always_inline)) static inline
+#define __NO_RETURN                 __attribute__((__noreturn__))
+#define __USED                      __attribute__((used))
+#define __WEAK                      __attribute__((weak))
+#define __PACKED                    __attribute__((packed, aligned(1)))
+#define __PACKED_STRUCT             struct __attribute__((packed, aligned(1)))
+#define __PACKED_UNION              union __attribute__((packed, aligned(1)))
+#define __ALIGNED(x)                __attribute__((aligned(x)))
+#define __RESTRICT                  __restrict
+#define __COMPILER_BARRIER()        __asm volatile("" ::: "memory")
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern volatile uint32_t emuPrimask;                            // Emulated PRIMASK, see emuCore.c
+extern void              emuPollIrq(void);                      // Takes pending interrupts if enabled
+extern volatile bool     emuInIsr;                              // An interrupt handler is running
+
+static inline void __enable_irq(void)
+{
+    emuPrimask = 0;
+    emuPollIrq();
+}
+
+static inline void __disable_irq(void)
+{
+    emuPrimask = 1;
+    __COMPILER_BARRIER();
+}
+
+static inline uint32_t __get_PRIMASK(void)
+{
+    return emuPrimask;
+}
+
+static inline void __set_PRIMASK(uint32_t priMask)
+{
+    emuPrimask = priMask & 1;
+    emuPollIrq();
+}
+
+/**
+ * Handler mode: the exception number is not emulated, any interrupt returns 16 (IRQ0)
+ */
+static inline uint32_t __get_IPSR(void)
+{
+    return emuInIsr ? 16 : 0;
+}
+
+#define __NOP()                     __asm volatile("nop")
+#define __WFI()                     emuPollIrq()
+#define __WFE()                     emuPollIrq()
+#define __SEV()                     ((void) 0)
+#define __ISB()                     __sync_synchronize()
+#define __DSB()                     __sync_synchronize()
+#define __DMB()                     __sync_synchronize()
+
+static inline uint32_t __REV(uint32_t value)
+{
+    return __builtin_bswap32(value);
+}
+
+static inline uint32_t __RBIT(uint32_t value)
+{
+    uint32_t result = 0;
+    uint8_t  i;
+
+    for (i = 0; i < 32; i++)
+    {
+        result = (result << 1) | (value & 1);
+        value >>= 1;
+    }
+    return result;
+}
+
+static inline uint8_t __CLZ(uint32_t value)
+{
+    return (0 == value) ? 32 : (uint8_t) __builtin_clz(value);
+}
+
+/**
+ * Exclusive access: interrupts are only taken at peripheral accesses and by __set_PRIMASK(), so
+ * nothing can interrupt an LDREX/STREX pair w/o register access in between.
+ */
+static inline uint32_t __LDREXW(volatile uint32_t *addr)
+{
+    return *addr;
+}
+
+static inline uint32_t __STREXW(uint32_t value, volatile uint32_t *addr)
+{
+    *addr = value;
+    return 0;
+}
+
+static inline void __CLREX(void)
+{
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#include "../../CMSIS/Include/core_cm4.h"
+
+#endif /* EMU_CORE_CM4_H_ */
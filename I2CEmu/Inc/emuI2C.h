@@ -0,0 +1,69 @@
+/**
+ * emuI2C.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: T Flaemig
+ *
+ *  Model of one STM32F4 I2C component in master mode, used by emuCore.c. The model has its own
+ *  register set; emuCore.c copies it into the register image before every access and reports
+ *  reads and writes afterwards. All times are in picoseconds of virtual time.
+ */
+
+#ifndef EMUI2C_H_
+#define EMUI2C_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <i2cEmu.h>
+
+#define EMU_I2C_IRQ_EV              (0x01)
+#define EMU_I2C_IRQ_ER              (0x02)
+
+typedef enum
+{
+    EMU_I2C_IDLE                = 0,    // Bus free
+    EMU_I2C_START,                      // (Repeated) START condition on the bus
+    EMU_I2C_SB,                         // SB = 1, waiting for the address in DR
+    EMU_I2C_ADDR,                       // Address byte on the bus
+    EMU_I2C_ADDR_WAIT,                  // ADDR = 1, SCL stretched until SR1 + SR2 have been read
+    EMU_I2C_TX,                         // Data byte to the slave on the bus
+    EMU_I2C_TX_WAIT,                    // Shifter empty, SCL stretched until DR is written (TXE, BTF)
+    EMU_I2C_RX,                         // Data byte from the slave on the bus
+    EMU_I2C_RX_WAIT,                    // DR and shifter full (BTF), SCL stretched until DR is read
+    EMU_I2C_HOLD,                       // After NACK: SCL stretched until START or STOP
+    EMU_I2C_STOP                        // STOP condition on the bus
+} EMU_I2C_PHASE_t;
+
+typedef struct
+{
+    // Register set
+    uint32_t        cr1, cr2, oar1, oar2, sr1, sr2, ccr, trise, fltr;
+    uint8_t         dr;                 // Received byte (read view of DR)
+
+    // Bus state
+    EMU_I2C_PHASE_t phase;
+    uint64_t        tEvent;             // End of the current START, byte or STOP
+    uint64_t        tBusy;              // Begin of the first START after STOP
+    uint8_t         shift;              // Shift register
+    bool            shiftFull;          // RX: byte in the shift register, waiting for DR
+    uint8_t         txData;             // TX: DR written while the shifter is busy
+    bool            txFull;
+    bool            read;               // Direction of the current address
+    bool            sr1Read;            // ADDR: SR1 has been read, SR2 read clears ADDR
+    bool            posAck;             // POS = 1: (N)ACK of the byte on the bus
+    bool            lastAck;            // (N)ACK of the last received byte
+
+    EMU_SLAVE_t    *slaves;
+    EMU_SLAVE_t    *active;             // Addressed slave
+    EMU_STATS_t     stats;
+} EMU_I2C_t;
+
+
+extern void     emuI2CReset(EMU_I2C_t *bus, uint64_t now);
+extern void     emuI2CAdvance(EMU_I2C_t *bus, uint64_t now);
+extern void     emuI2CRead(EMU_I2C_t *bus, uint32_t offset, uint64_t now);
+extern void     emuI2CWrite(EMU_I2C_t *bus, uint32_t offset, uint32_t value, uint64_t now);
+extern void     emuI2CImage(const EMU_I2C_t *bus, volatile I2C_TypeDef *regs);
+extern uint8_t  emuI2CIrq(const EMU_I2C_t *bus);
+
+#endif /* EMUI2C_H_ */
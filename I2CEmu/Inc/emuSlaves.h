@@ -0,0 +1,50 @@
+/**
+ * emuSlaves.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: T Flaemig
+ *
+ *  Slave models of the I2C emulator:
+ *  - Register file with auto-increment (first byte after START(W) is the register address),
+ *    preset for the MPU6050
+ *  - AMIS-30624 stepper driver: command protocol with GetFullStatus1/2, SetMotorParam,
+ *    SetPosition and ResetPosition
+ */
+
+#ifndef EMUSLAVES_H_
+#define EMUSLAVES_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <i2cEmu.h>
+
+typedef struct EMU_REGFILE EMU_REGFILE_t;
+
+struct EMU_REGFILE
+{
+    EMU_SLAVE_t   slave;                                    // Must be the first member
+    uint8_t       regs[256];
+    uint8_t       ptr;                                      // Register address, auto-increment
+    bool          ptrValid;                                 // Register address of this write received
+    void        (*onWrite)(EMU_REGFILE_t *rf, uint8_t reg, uint8_t value);
+    uint32_t      writes;                                   // Statistics: data bytes written
+};
+
+typedef struct
+{
+    EMU_SLAVE_t   slave;                                    // Must be the first member
+    uint8_t       cmd[8];                                   // Command of the current write
+    uint8_t       cmdLen;
+    uint8_t       resp[8];                                  // Answer to the last Get command
+    uint8_t       respIdx;
+    uint8_t       iRun, iHold, vMax, vMin;
+    int16_t       actPos, tagPos;
+    uint32_t      commands;                                 // Statistics: commands executed
+} EMU_AMIS_t;
+
+
+extern void emuRegFileInit(EMU_REGFILE_t *rf, uint8_t addr);
+extern void emuMpu6050Init(EMU_REGFILE_t *rf, uint8_t addr);
+extern void emuAmisInit(EMU_AMIS_t *amis, uint8_t addr);
+
+#endif /* EMUSLAVES_H_ */
@@ -0,0 +1,83 @@
+/**
+ * i2cEmu.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: T Flaemig
+ *
+ *  Host-side (x86-64 Linux) register level emulator of the STM32F4 I2C peripheral.
+ *
+ *  The peripheral and core address ranges are mapped at their real addresses, so I2C1 ... I2C3,
+ *  RCC, DWT and NVIC of the CMSIS headers are used unchanged and MCAL/BALO run unmodified.
+ *  The pages of I2C1 ... I2C3, DWT and NVIC are protected: every access traps, advances the
+ *  virtual time, updates the register image and runs the bus state machine. Event and error
+ *  interrupts are taken after the access which raised them, like on the Cortex-M4.
+ *
+ *  Virtual time: every trapped access costs EMU_ACCESS_CYCLES HCLK cycles, the bus runs with
+ *  the SCL period of CR2 FREQ / CCR. Code between two accesses takes no time. DWT->CYCCNT shows
+ *  the virtual time in HCLK cycles.
+ *
+ *  Not emulated: DMA (the 64 bit host buffer addresses don't fit into M0AR, use useDma = false),
+ *  slave mode, SMBus/PEC, 10 bit addressing, clock stretching by slaves, multi-master arbitration.
+ */
+
+#ifndef I2CEMU_H_
+#define I2CEMU_H_
+
+#include <stm32f4xx.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef EMU_ACCESS_CYCLES
+#define EMU_ACCESS_CYCLES           (8)         // HCLK cycles of a peripheral access incl. the code around it
+#endif
+#define EMU_NUM_I2C                 (3)
+
+typedef struct EMU_SLAVE EMU_SLAVE_t;
+
+/**
+ * @brief Slave model, addressed by its 7 bit address
+ *
+ * Every callback may be NULL: start and write acknowledge, read returns 0xFF.
+ */
+struct EMU_SLAVE
+{
+    uint8_t       addr;                                     // 7Bit slave address
+    bool        (*start)(EMU_SLAVE_t *slave, bool read);    // Address matched, false: NACK
+    bool        (*write)(EMU_SLAVE_t *slave, uint8_t data); // Byte from the master, false: NACK
+    uint8_t     (*read)(EMU_SLAVE_t *slave);                // Next byte to the master
+    void        (*stop)(EMU_SLAVE_t *slave);                // STOP condition
+    void         *user;                                     // Free for use by the model
+    EMU_SLAVE_t  *next;                                     // Managed by emuAttachSlave()
+};
+
+/**
+ * @brief Bus statistics of one I2C component
+ */
+typedef struct
+{
+    uint32_t    starts;                 // START and repeated START conditions
+    uint32_t    stops;
+    uint32_t    bytes;                  // Address and data bytes on the bus
+    uint32_t    naks;                   // Address or data byte not acknowledged by a slave
+    uint32_t    irqs;                   // Event and error interrupts taken
+    uint64_t    busyNs;                 // Time between START and the end of the STOP
+} EMU_STATS_t;
+
+
+extern void               emuInit(uint32_t hclk);
+extern uint64_t           emuNowNs(void);
+extern void               emuSetAccessCycles(uint32_t cycles);
+extern void               emuAttachSlave(I2C_TypeDef *i2c, EMU_SLAVE_t *slave);
+extern const EMU_STATS_t *emuGetStats(I2C_TypeDef *i2c);
+extern void               emuResetStats(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* I2CEMU_H_ */
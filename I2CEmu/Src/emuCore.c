@@ -0,0 +1,446 @@
+/**
+ * emuCore.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: T Flaemig
+ *
+ *  Memory map, access traps, virtual time and interrupts of the I2C emulator (x86-64 Linux).
+ *
+ *  The peripheral range 0x40000000 and the private peripheral bus 0xE0000000 are mapped as RAM.
+ *  Registers w/o model (RCC, GPIO, DMA, SCB ...) simply keep the written values. The pages of
+ *  I2C1 ... I2C3, DWT and NVIC are protected:
+ *
+ *  SIGSEGV : advance the virtual time, write the register image of the page, unprotect the page
+ *            and single-step the faulting instruction (trap flag)
+ *  SIGTRAP : protect the page again, apply the side effects of the read or write (a read-modify-
+ *            write instruction is detected by the changed register value) and take the interrupts
+ *            which are pending now.
+ *
+ *  An interrupt is taken by letting the signal return into emuIrqTrampoline instead of the next
+ *  instruction. The trampoline saves the caller saved registers, calls the handlers and returns
+ *  to the interrupted code, so the handlers run in normal thread context like on the Cortex-M4.
+ */
+#define _GNU_SOURCE
+#include <signal.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <emuI2C.h>
+
+#if !defined(__x86_64__) || !defined(__linux__)
+#error "The I2C emulator needs x86-64 Linux"
+#endif
+
+#define EMU_PERIPH_BASE         (PERIPH_BASE)
+#define EMU_PERIPH_SIZE         (0x00030000UL)              // APB1, APB2 and AHB1 up to DMA2
+#define EMU_PPB_BASE            (0xE0000000UL)
+#define EMU_PPB_SIZE            (0x00100000UL)
+#define EMU_PAGE_SIZE           (0x1000UL)
+#define EMU_PAGE(addr)          ((uintptr_t) (addr) & ~(EMU_PAGE_SIZE - 1))
+
+#define EMU_I2C_PAGE            EMU_PAGE(I2C1_BASE)         // I2C1 ... I2C3
+#define EMU_DWT_PAGE            EMU_PAGE(DWT_BASE)
+#define EMU_NVIC_PAGE           EMU_PAGE(NVIC_BASE)
+
+#define EMU_EFLAGS_TF           (0x100)
+#define EMU_PF_WRITE            (0x02)                      // Page fault error code: write access
+#define EMU_IRQ_STORM           (100000)                    // Max. handler calls in one go
+
+volatile uint32_t emuPrimask;
+uint32_t          SystemCoreClock;                          // system_stm32f4xx.c is not linked
+
+static EMU_I2C_t  emuBus[EMU_NUM_I2C];
+static uint32_t   emuHclk;
+static uint32_t   emuAccessCycles = EMU_ACCESS_CYCLES;
+static uint64_t   emuTime;                                  // Virtual time in ps
+static uint32_t   emuCycOffset;                             // DWT->CYCCNT = cycles + offset
+static uint32_t   emuIser[8];                               // NVIC enable bits
+volatile bool     emuInIsr;                                 // __get_IPSR() of core_cm4.h
+
+static uintptr_t  emuTrapAddr;                              // Access which is single-stepped
+static bool       emuTrapWrite;
+static uint32_t   emuTrapOld;
+
+extern void I2C1_EV_IRQHandler(void);                       // mcalI2C.c
+extern void I2C1_ER_IRQHandler(void);
+extern void I2C2_EV_IRQHandler(void);
+extern void I2C2_ER_IRQHandler(void);
+extern void I2C3_EV_IRQHandler(void);
+extern void I2C3_ER_IRQHandler(void);
+
+typedef void (*EMU_HANDLER_t)(void);
+
+static const struct
+{
+    IRQn_Type     irq;
+    uint8_t       bus;
+    uint8_t       mask;
+    EMU_HANDLER_t handler;
+} emuVector[] =                                             // Order of the exception numbers
+{
+    { I2C1_EV_IRQn, 0, EMU_I2C_IRQ_EV, I2C1_EV_IRQHandler },
+    { I2C1_ER_IRQn, 0, EMU_I2C_IRQ_ER, I2C1_ER_IRQHandler },
+    { I2C2_EV_IRQn, 1, EMU_I2C_IRQ_EV, I2C2_EV_IRQHandler },
+    { I2C2_ER_IRQn, 1, EMU_I2C_IRQ_ER, I2C2_ER_IRQHandler },
+    { I2C3_EV_IRQn, 2, EMU_I2C_IRQ_EV, I2C3_EV_IRQHandler },
+    { I2C3_ER_IRQn, 2, EMU_I2C_IRQ_ER, I2C3_ER_IRQHandler },
+};
+
+extern void emuIrqTrampoline(void);
+void        emuIrqEntry(void);
+
+/**
+ * Entered instead of the instruction after the trapped access. The return address has been pushed
+ * below the red zone of the interrupted function, which is skipped by "ret $128".
+ */
+__asm__(
+    "   .text\n"
+    "   .globl  emuIrqTrampoline\n"
+    "   .type   emuIrqTrampoline, @function\n"
+    "emuIrqTrampoline:\n"
+    "   pushfq\n"
+    "   pushq   %rax\n"
+    "   pushq   %rcx\n"
+    "   pushq   %rdx\n"
+    "   pushq   %rsi\n"
+    "   pushq   %rdi\n"
+    "   pushq   %r8\n"
+    "   pushq   %r9\n"
+    "   pushq   %r10\n"
+    "   pushq   %r11\n"
+    "   pushq   %rbp\n"
+    "   movq    %rsp, %rbp\n"
+    "   subq    $512, %rsp\n"
+    "   andq    $-64, %rsp\n"
+    "   fxsave64 (%rsp)\n"
+    "   call    emuIrqEntry\n"
+    "   fxrstor64 (%rsp)\n"
+    "   movq    %rbp, %rsp\n"
+    "   popq    %rbp\n"
+    "   popq    %r11\n"
+    "   popq    %r10\n"
+    "   popq    %r9\n"
+    "   popq    %r8\n"
+    "   popq    %rdi\n"
+    "   popq    %rsi\n"
+    "   popq    %rdx\n"
+    "   popq    %rcx\n"
+    "   popq    %rax\n"
+    "   popfq\n"
+    "   ret     $128\n"
+    "   .size   emuIrqTrampoline, .-emuIrqTrampoline\n"
+);
+
+static EMU_I2C_t *emuGetBus(uintptr_t reg, uint32_t *offset)
+{
+    if ((reg < I2C1_BASE) || (reg >= (I2C3_BASE + 0x400)))
+    {
+        return NULL;
+    }
+    *offset = reg & 0x3FF;
+    return &emuBus[(reg - I2C1_BASE) >> 10];
+}
+
+static uint32_t emuCycles(void)
+{
+    return (uint32_t) (((unsigned __int128) emuTime * emuHclk) / 1000000000000ULL);
+}
+
+static void emuProtect(uintptr_t page, bool protect)
+{
+    mprotect((void *) page, EMU_PAGE_SIZE, protect ? PROT_NONE : (PROT_READ | PROT_WRITE));
+}
+
+/**
+ * Index of the pending interrupt with the lowest number, -1 if none
+ */
+static int emuPendingIrq(void)
+{
+    uint8_t i;
+
+    for (i = 0; i < (sizeof(emuVector) / sizeof(emuVector[0])); i++)
+    {
+        if ((emuIser[emuVector[i].irq >> 5] & (1UL << (emuVector[i].irq & 0x1F))) &&
+            (emuI2CIrq(&emuBus[emuVector[i].bus]) & emuVector[i].mask))
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Runs the handlers until no interrupt is pending (tail chaining). Called with emuInIsr set.
+ */
+void emuIrqEntry(void)
+{
+    uint32_t calls = 0;
+    int      irq;
+
+    while ((irq = emuPendingIrq()) >= 0)
+    {
+        if (++calls > EMU_IRQ_STORM)
+        {
+            fprintf(stderr, "emu: interrupt %d is not cleared by its handler\n", emuVector[irq].irq);
+            abort();
+        }
+        emuBus[emuVector[irq].bus].stats.irqs++;
+        emuVector[irq].handler();
+    }
+    emuInIsr = false;
+}
+
+/**
+ * Takes the pending interrupts if PRIMASK allows it. Called by __enable_irq() / __set_PRIMASK().
+ */
+void emuPollIrq(void)
+{
+    if (!emuInIsr && !emuPrimask && (emuPendingIrq() >= 0))
+    {
+        emuInIsr = true;
+        emuIrqEntry();
+    }
+}
+
+/**
+ * Before the access: time, bus events and register image of the page
+ */
+static void emuAccessBegin(uintptr_t page, uintptr_t reg)
+{
+    uint8_t i;
+
+    emuTime += (uint64_t) emuAccessCycles * 1000000000000ULL / emuHclk;
+    for (i = 0; i < EMU_NUM_I2C; i++)
+    {
+        emuI2CAdvance(&emuBus[i], emuTime);
+    }
+
+    if (EMU_I2C_PAGE == page)
+    {
+        emuI2CImage(&emuBus[0], (volatile I2C_TypeDef *) I2C1_BASE);
+        emuI2CImage(&emuBus[1], (volatile I2C_TypeDef *) I2C2_BASE);
+        emuI2CImage(&emuBus[2], (volatile I2C_TypeDef *) I2C3_BASE);
+    }
+    else if (EMU_DWT_PAGE == page)
+    {
+        DWT->CYCCNT = emuCycles() + emuCycOffset;
+    }
+    else
+    {
+        for (i = 0; i < 8; i++)
+        {
+            NVIC->ISER[i] = emuIser[i];
+            NVIC->ICER[i] = emuIser[i];
+        }
+    }
+    emuTrapOld = *(volatile uint32_t *) reg;
+}
+
+/**
+ * After the access: side effects
+ */
+static void emuAccessEnd(uintptr_t page, uintptr_t reg, bool write)
+{
+    uint32_t   value = *(volatile uint32_t *) reg;
+    bool       read  = !write;
+    uint32_t   offset;
+    EMU_I2C_t *bus;
+
+    write = write || (value != emuTrapOld);                 // e.g. "orl $1, (%rax)" faults as read
+
+    if (EMU_I2C_PAGE == page)
+    {
+        bus = emuGetBus(reg, &offset);
+        if (NULL == bus)
+        {
+            return;
+        }
+        if (read)
+        {
+            emuI2CRead(bus, offset, emuTime);
+        }
+        if (write)
+        {
+            emuI2CWrite(bus, offset, value, emuTime);
+        }
+    }
+    else if (EMU_DWT_PAGE == page)
+    {
+        if (write && (reg == (uintptr_t) &DWT->CYCCNT))
+        {
+            emuCycOffset = value - emuCycles();
+        }
+    }
+    else if (write)
+    {
+        offset = reg - NVIC_BASE;
+        if (offset < sizeof(NVIC->ISER))
+        {
+            emuIser[offset >> 2] |= value;
+        }
+        else if ((offset >= offsetof(NVIC_Type, ICER)) && (offset < (offsetof(NVIC_Type, ICER) + sizeof(NVIC->ICER))))
+        {
+            emuIser[(offset - offsetof(NVIC_Type, ICER)) >> 2] &= ~value;
+        }
+    }
+}
+
+static void emuSegvHandler(int sig, siginfo_t *info, void *context)
+{
+    ucontext_t *uc   = (ucontext_t *) context;
+    uintptr_t   addr = (uintptr_t) info->si_addr;
+    uintptr_t   page = EMU_PAGE(addr);
+
+    (void) sig;
+    if ((0 != emuTrapAddr) || ((EMU_I2C_PAGE != page) && (EMU_DWT_PAGE != page) && (EMU_NVIC_PAGE != page)))
+    {
+        fprintf(stderr, "emu: segmentation fault at %p\n", (void *) addr);
+        signal(SIGSEGV, SIG_DFL);                           // Crash at the same instruction again
+        return;
+    }
+    emuTrapAddr  = addr;
+    emuTrapWrite = (uc->uc_mcontext.gregs[REG_ERR] & EMU_PF_WRITE) != 0;
+    emuProtect(page, false);
+    emuAccessBegin(page, addr & ~3UL);
+    uc->uc_mcontext.gregs[REG_EFL] |= EMU_EFLAGS_TF;
+}
+
+static void emuTrapHandler(int sig, siginfo_t *info, void *context)
+{
+    ucontext_t *uc   = (ucontext_t *) context;
+    uintptr_t   addr = emuTrapAddr;
+    uint64_t   *sp;
+
+    (void) sig;
+    (void) info;
+    if (0 == addr)
+    {
+        signal(SIGTRAP, SIG_DFL);
+        raise(SIGTRAP);
+        return;
+    }
+    uc->uc_mcontext.gregs[REG_EFL] &= ~EMU_EFLAGS_TF;
+    emuAccessEnd(EMU_PAGE(addr), addr & ~3UL, emuTrapWrite);
+    emuProtect(EMU_PAGE(addr), true);
+    emuTrapAddr = 0;
+
+    if (!emuInIsr && !emuPrimask && (emuPendingIrq() >= 0))
+    {
+        emuInIsr = true;
+        sp  = (uint64_t *) (uc->uc_mcontext.gregs[REG_RSP] - 128);  // Skip the red zone
+        *--sp = (uint64_t) uc->uc_mcontext.gregs[REG_RIP];
+        uc->uc_mcontext.gregs[REG_RSP] = (greg_t) sp;
+        uc->uc_mcontext.gregs[REG_RIP] = (greg_t) emuIrqTrampoline;
+    }
+}
+
+static void emuMap(uintptr_t base, size_t size)
+{
+    if (mmap((void *) base, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0)
+        != (void *) base)
+    {
+        perror("emu: mmap");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * Maps the register blocks and installs the traps. Clock tree after reset of the preset:
+ * HSI -> PLL -> SYSCLK = HCLK = hclk, PCLK1 = HCLK / 2 above 42 MHz, PCLK2 = HCLK.
+ *
+ * @param hclk : 25 ... 84 MHz, whole MHz
+ */
+void emuInit(uint32_t hclk)
+{
+    struct sigaction sa;
+    uint8_t          i;
+
+    emuMap(EMU_PERIPH_BASE, EMU_PERIPH_SIZE);
+    emuMap(EMU_PPB_BASE, EMU_PPB_SIZE);
+
+    emuHclk = hclk;
+    SystemCoreClock = hclk;
+    RCC->CR      = RCC_CR_HSION | RCC_CR_HSIRDY | RCC_CR_PLLON | RCC_CR_PLLRDY;
+    RCC->PLLCFGR = (16 << RCC_PLLCFGR_PLLM_Pos) |                   // 16 MHz HSI / 16 = 1 MHz
+                   ((2 * (hclk / 1000000)) << RCC_PLLCFGR_PLLN_Pos); // VCO = 2 * HCLK, PLLP = 2
+    RCC->CFGR    = RCC_CFGR_SW_PLL | RCC_CFGR_SWS_PLL | ((hclk > 42000000) ? RCC_CFGR_PPRE1_DIV2 : 0);
+    GPIOA->IDR   = 0xFFFF;                                          // Pull-ups: SCL and SDA released
+    GPIOB->IDR   = 0xFFFF;
+    GPIOC->IDR   = 0xFFFF;
+
+    memset(emuBus, 0, sizeof(emuBus));
+    for (i = 0; i < EMU_NUM_I2C; i++)
+    {
+        emuI2CReset(&emuBus[i], 0);
+    }
+    memset(emuIser, 0, sizeof(emuIser));
+    emuTime      = 0;
+    emuCycOffset = 0;
+    emuPrimask   = 0;
+    emuInIsr     = false;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_flags     = SA_SIGINFO;
+    sa.sa_sigaction = emuSegvHandler;
+    sigaction(SIGSEGV, &sa, NULL);
+    sa.sa_sigaction = emuTrapHandler;
+    sigaction(SIGTRAP, &sa, NULL);
+
+    emuProtect(EMU_I2C_PAGE, true);
+    emuProtect(EMU_DWT_PAGE, true);
+    emuProtect(EMU_NVIC_PAGE, true);
+}
+
+/**
+ * Virtual time since emuInit() in ns
+ */
+uint64_t emuNowNs(void)
+{
+    return emuTime / 1000;
+}
+
+/**
+ * HCLK cycles which are added to the virtual time by every trapped access
+ */
+void emuSetAccessCycles(uint32_t cycles)
+{
+    emuAccessCycles = cycles;
+}
+
+/**
+ * Connects a slave model to the bus. Several slaves may be attached to one bus.
+ */
+void emuAttachSlave(I2C_TypeDef *i2c, EMU_SLAVE_t *slave)
+{
+    uint32_t   offset;
+    EMU_I2C_t *bus = emuGetBus((uintptr_t) i2c, &offset);
+
+    if ((NULL == bus) || (NULL == slave))
+    {
+        return;
+    }
+    slave->next = bus->slaves;
+    bus->slaves = slave;
+}
+
+const EMU_STATS_t *emuGetStats(I2C_TypeDef *i2c)
+{
+    uint32_t   offset;
+    EMU_I2C_t *bus = emuGetBus((uintptr_t) i2c, &offset);
+
+    return (NULL == bus) ? NULL : &bus->stats;
+}
+
+void emuResetStats(void)
+{
+    uint8_t i;
+
+    for (i = 0; i < EMU_NUM_I2C; i++)
+    {
+        memset(&emuBus[i].stats, 0, sizeof(emuBus[i].stats));
+        emuBus[i].tBusy = emuTime;                          // Running transaction counts from now on
+    }
+}
@@ -0,0 +1,517 @@
+/**
+ * emuI2C.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: T Flaemig
+ *
+ *  Master mode state machine of the STM32F4 I2C component (RM0368, chapter 18.3.3):
+ *
+ *  START    : 1 SCL period, then SB. SB is cleared by writing the address into DR.
+ *  Address  : 9 SCL periods, then ADDR (ACK) or AF (NACK). ADDR is cleared by reading SR1 and SR2.
+ *  Transmit : DR is moved into the shifter if it is empty (TXE stays 1), otherwise TXE = 0 until
+ *             the running byte is finished. 9 SCL periods per byte. Shifter and DR empty: BTF.
+ *  Receive  : 9 SCL periods per byte incl. the (N)ACK of the master (CR1 ACK, with POS the ACK value
+ *             of the previous byte). The byte goes into DR (RXNE); if DR is still full it stays in
+ *             the shifter (BTF) and SCL is stretched until DR is read.
+ *  START / STOP requests are executed at the end of the current byte or immediately if SCL is
+ *  stretched. The end of the STOP clears CR1 STOP, MSL and BUSY.
+ *
+ *  SCL period: standard mode 2 * CCR * Tpclk, fast mode 3 * CCR * Tpclk (DUTY = 0) or
+ *  25 * CCR * Tpclk (DUTY = 1), Tpclk from CR2 FREQ. Rise times are not taken into account.
+ */
+#include <stddef.h>
+#include <emuI2C.h>
+
+#define EMU_I2C_SR1_ERRORS      (I2C_SR1_BERR | I2C_SR1_ARLO | I2C_SR1_AF | I2C_SR1_OVR | I2C_SR1_PECERR | \
+                                 I2C_SR1_TIMEOUT | I2C_SR1_SMBALERT)                     // rc_w0 bits
+#define EMU_I2C_SR1_EVENTS      (I2C_SR1_SB | I2C_SR1_ADDR | I2C_SR1_ADD10 | I2C_SR1_STOPF | I2C_SR1_BTF)
+
+
+static uint64_t emuI2CBitPs(const EMU_I2C_t *bus)
+{
+    uint32_t freq = bus->cr2 & I2C_CR2_FREQ_Msk;            // PCLK1 in MHz
+    uint32_t ccr  = bus->ccr & I2C_CCR_CCR_Msk;
+    uint32_t mult;
+
+    if (freq < 2)
+    {
+        freq = 2;
+    }
+    if (0 == ccr)
+    {
+        ccr = 1;
+    }
+    if (!(bus->ccr & I2C_CCR_FS))
+    {
+        mult = 2;
+    }
+    else
+    {
+        mult = (bus->ccr & I2C_CCR_DUTY) ? 25 : 3;
+    }
+    return (uint64_t) mult * ccr * 1000000ULL / freq;
+}
+
+static EMU_SLAVE_t *emuI2CFindSlave(const EMU_I2C_t *bus, uint8_t addr)
+{
+    EMU_SLAVE_t *slave;
+
+    for (slave = bus->slaves; NULL != slave; slave = slave->next)
+    {
+        if (slave->addr == addr)
+        {
+            return slave;
+        }
+    }
+    return NULL;
+}
+
+static void emuI2CStartCondition(EMU_I2C_t *bus, uint64_t t)
+{
+    if (EMU_I2C_IDLE == bus->phase)
+    {
+        bus->tBusy = t;
+    }
+    bus->sr1   &= ~(I2C_SR1_TXE | I2C_SR1_BTF);
+    bus->txFull = false;
+    bus->phase  = EMU_I2C_START;
+    bus->tEvent = t + emuI2CBitPs(bus);
+    bus->stats.starts++;
+}
+
+static void emuI2CStopCondition(EMU_I2C_t *bus, uint64_t t)
+{
+    bus->sr1   &= ~(I2C_SR1_SB | I2C_SR1_TXE | I2C_SR1_BTF);
+    bus->txFull = false;
+    bus->phase  = EMU_I2C_STOP;
+    bus->tEvent = t + emuI2CBitPs(bus);
+}
+
+/**
+ * Executes a pending STOP or START request at a byte boundary.
+ *
+ * @return true if a condition has been started
+ */
+static bool emuI2CRequests(EMU_I2C_t *bus, uint64_t t)
+{
+    if (bus->cr1 & I2C_CR1_STOP)
+    {
+        emuI2CStopCondition(bus, t);
+        return true;
+    }
+    if (bus->cr1 & I2C_CR1_START)
+    {
+        emuI2CStartCondition(bus, t);
+        return true;
+    }
+    return false;
+}
+
+static void emuI2CStartByte(EMU_I2C_t *bus, EMU_I2C_PHASE_t phase, uint64_t t)
+{
+    bus->phase  = phase;
+    bus->tEvent = t + 9 * emuI2CBitPs(bus);
+    bus->stats.bytes++;
+}
+
+/**
+ * End of a received byte which is in DR now: next byte, condition or wait for START / STOP.
+ */
+static void emuI2CRxNext(EMU_I2C_t *bus, uint64_t t)
+{
+    if (emuI2CRequests(bus, t))
+    {
+        return;
+    }
+    if (bus->lastAck)
+    {
+        emuI2CStartByte(bus, EMU_I2C_RX, t);
+    }
+    else
+    {
+        bus->phase = EMU_I2C_HOLD;                          // Slave has released SDA
+    }
+}
+
+static void emuI2CNack(EMU_I2C_t *bus, uint64_t t)
+{
+    bus->sr1 |= I2C_SR1_AF;
+    bus->stats.naks++;
+    bus->phase = EMU_I2C_HOLD;
+    emuI2CRequests(bus, t);
+}
+
+static void emuI2CEvent(EMU_I2C_t *bus)
+{
+    uint64_t t = bus->tEvent;
+    uint8_t  data;
+    bool     ack;
+
+    switch (bus->phase)
+    {
+        case EMU_I2C_START:
+            bus->cr1 &= ~I2C_CR1_START;
+            bus->sr1 |= I2C_SR1_SB;
+            bus->sr2 |= I2C_SR2_MSL | I2C_SR2_BUSY;
+            bus->sr2 &= ~I2C_SR2_TRA;
+            bus->phase = EMU_I2C_SB;
+            if (bus->cr1 & I2C_CR1_STOP)
+            {
+                emuI2CStopCondition(bus, t);
+            }
+            break;
+
+        case EMU_I2C_ADDR:
+            bus->read   = (bus->shift & 0x01);
+            bus->active = emuI2CFindSlave(bus, bus->shift >> 1);
+            ack = (NULL != bus->active) && ((NULL == bus->active->start) || bus->active->start(bus->active, bus->read));
+            if (!ack)
+            {
+                bus->active = NULL;
+                emuI2CNack(bus, t);
+                break;
+            }
+            bus->sr1    |= I2C_SR1_ADDR;
+            bus->sr1Read = false;
+            if (!bus->read)
+            {
+                bus->sr2 |= I2C_SR2_TRA;
+            }
+            bus->phase = EMU_I2C_ADDR_WAIT;
+            break;
+
+        case EMU_I2C_TX:
+            ack = (NULL == bus->active->write) || bus->active->write(bus->active, bus->shift);
+            if (!ack)
+            {
+                emuI2CNack(bus, t);
+            }
+            else if (emuI2CRequests(bus, t))
+            {
+                ;
+            }
+            else if (bus->txFull)
+            {
+                bus->shift  = bus->txData;
+                bus->txFull = false;
+                bus->sr1   |= I2C_SR1_TXE;
+                emuI2CStartByte(bus, EMU_I2C_TX, t);
+            }
+            else
+            {
+                bus->sr1  |= I2C_SR1_BTF;
+                bus->phase = EMU_I2C_TX_WAIT;
+            }
+            break;
+
+        case EMU_I2C_RX:
+            data = (NULL == bus->active->read) ? 0xFF : bus->active->read(bus->active);
+            bus->lastAck = (bus->cr1 & I2C_CR1_POS) ? bus->posAck : ((bus->cr1 & I2C_CR1_ACK) != 0);
+            bus->posAck  = ((bus->cr1 & I2C_CR1_ACK) != 0);  // POS: ACK controls the next byte
+            if (!(bus->sr1 & I2C_SR1_RXNE))
+            {
+                bus->dr   = data;
+                bus->sr1 |= I2C_SR1_RXNE;
+                emuI2CRxNext(bus, t);
+            }
+            else
+            {
+                bus->shift     = data;
+                bus->shiftFull = true;
+                bus->sr1      |= I2C_SR1_BTF;
+                bus->phase     = EMU_I2C_RX_WAIT;
+            }
+            break;
+
+        case EMU_I2C_STOP:
+            bus->cr1 &= ~I2C_CR1_STOP;
+            bus->sr2 &= ~(I2C_SR2_MSL | I2C_SR2_BUSY | I2C_SR2_TRA);
+            if ((NULL != bus->active) && (NULL != bus->active->stop))
+            {
+                bus->active->stop(bus->active);
+            }
+            bus->active = NULL;
+            bus->phase  = EMU_I2C_IDLE;
+            bus->stats.stops++;
+            bus->stats.busyNs += (t - bus->tBusy) / 1000;
+            if (bus->cr1 & I2C_CR1_START)
+            {
+                emuI2CStartCondition(bus, t);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+/**
+ * Clears the component like PE = 0: bus released, flags cleared, configuration kept.
+ */
+static void emuI2CDisable(EMU_I2C_t *bus, uint64_t now)
+{
+    if (EMU_I2C_IDLE != bus->phase)
+    {
+        if ((NULL != bus->active) && (NULL != bus->active->stop))
+        {
+            bus->active->stop(bus->active);
+        }
+        bus->stats.busyNs += (now - bus->tBusy) / 1000;
+    }
+    bus->cr1      &= ~(I2C_CR1_START | I2C_CR1_STOP);
+    bus->sr1       = 0;
+    bus->sr2       = 0;
+    bus->phase     = EMU_I2C_IDLE;
+    bus->shiftFull = false;
+    bus->txFull    = false;
+    bus->active    = NULL;
+}
+
+static void emuI2CStopRequest(EMU_I2C_t *bus, uint64_t now)
+{
+    switch (bus->phase)
+    {
+        case EMU_I2C_IDLE:
+            bus->cr1 &= ~I2C_CR1_STOP;                      // Nothing to stop
+            break;
+
+        case EMU_I2C_SB:
+        case EMU_I2C_TX_WAIT:
+        case EMU_I2C_RX_WAIT:
+        case EMU_I2C_HOLD:
+            emuI2CStopCondition(bus, now);
+            break;
+
+        default:                                            // At the end of the current byte
+            break;
+    }
+}
+
+static void emuI2CStartRequest(EMU_I2C_t *bus, uint64_t now)
+{
+    switch (bus->phase)
+    {
+        case EMU_I2C_IDLE:
+        case EMU_I2C_SB:
+        case EMU_I2C_TX_WAIT:
+        case EMU_I2C_RX_WAIT:
+        case EMU_I2C_HOLD:
+            emuI2CStartCondition(bus, now);
+            break;
+
+        default:                                            // At the end of the current byte / STOP
+            break;
+    }
+}
+
+static void emuI2CAddrCleared(EMU_I2C_t *bus, uint64_t now)
+{
+    bus->sr1 &= ~I2C_SR1_ADDR;
+    if (!bus->read)
+    {
+        bus->sr1  |= I2C_SR1_TXE;
+        bus->phase = EMU_I2C_TX_WAIT;
+        emuI2CRequests(bus, now);
+    }
+    else
+    {
+        bus->posAck = true;                                 // POS: first byte is acknowledged
+        emuI2CStartByte(bus, EMU_I2C_RX, now);
+    }
+}
+
+/**
+ * Resets all registers like SWRST. The statistics are kept.
+ */
+void emuI2CReset(EMU_I2C_t *bus, uint64_t now)
+{
+    emuI2CDisable(bus, now);
+    bus->cr1   = 0;
+    bus->cr2   = 0;
+    bus->oar1  = 0;
+    bus->oar2  = 0;
+    bus->ccr   = 0;
+    bus->trise = 0x0002;
+    bus->fltr  = 0;
+    bus->dr    = 0;
+}
+
+/**
+ * Processes all bus events up to now.
+ */
+void emuI2CAdvance(EMU_I2C_t *bus, uint64_t now)
+{
+    while (((EMU_I2C_START == bus->phase) || (EMU_I2C_ADDR == bus->phase) || (EMU_I2C_TX == bus->phase) ||
+            (EMU_I2C_RX == bus->phase) || (EMU_I2C_STOP == bus->phase)) && (bus->tEvent <= now))
+    {
+        emuI2CEvent(bus);
+    }
+}
+
+/**
+ * Side effects of a read access to the register at offset. The CPU has already got the value.
+ */
+void emuI2CRead(EMU_I2C_t *bus, uint32_t offset, uint64_t now)
+{
+    switch (offset)
+    {
+        case offsetof(I2C_TypeDef, SR1):
+            if (bus->sr1 & I2C_SR1_ADDR)
+            {
+                bus->sr1Read = true;
+            }
+            break;
+
+        case offsetof(I2C_TypeDef, SR2):
+            if ((bus->sr1 & I2C_SR1_ADDR) && bus->sr1Read)
+            {
+                emuI2CAddrCleared(bus, now);
+            }
+            break;
+
+        case offsetof(I2C_TypeDef, DR):
+            if (!(bus->sr1 & I2C_SR1_RXNE))
+            {
+                break;
+            }
+            if (!bus->shiftFull)
+            {
+                bus->sr1 &= ~I2C_SR1_RXNE;
+                break;
+            }
+            bus->dr        = bus->shift;                    // RXNE stays set
+            bus->shiftFull = false;
+            bus->sr1      &= ~I2C_SR1_BTF;
+            if (EMU_I2C_RX_WAIT == bus->phase)
+            {
+                emuI2CRxNext(bus, now);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+/**
+ * Write access to the register at offset.
+ */
+void emuI2CWrite(EMU_I2C_t *bus, uint32_t offset, uint32_t value, uint64_t now)
+{
+    uint32_t old;
+
+    switch (offset)
+    {
+        case offsetof(I2C_TypeDef, CR1):
+            old = bus->cr1;
+            if (value & I2C_CR1_SWRST)
+            {
+                emuI2CReset(bus, now);
+                bus->cr1 = I2C_CR1_SWRST;
+                break;
+            }
+            bus->cr1 = value & 0xBFFF;
+            if (!(bus->cr1 & I2C_CR1_PE))
+            {
+                emuI2CDisable(bus, now);
+                break;
+            }
+            if ((value & I2C_CR1_STOP) && !(old & I2C_CR1_STOP))
+            {
+                emuI2CStopRequest(bus, now);
+            }
+            if ((value & I2C_CR1_START) && !(old & I2C_CR1_START))
+            {
+                emuI2CStartRequest(bus, now);
+            }
+            break;
+
+        case offsetof(I2C_TypeDef, CR2):
+            bus->cr2 = value & 0x1F3F;
+            break;
+
+        case offsetof(I2C_TypeDef, OAR1):
+            bus->oar1 = value & 0xC3FF;
+            break;
+
+        case offsetof(I2C_TypeDef, OAR2):
+            bus->oar2 = value & 0x00FF;
+            break;
+
+        case offsetof(I2C_TypeDef, DR):
+            if (EMU_I2C_SB == bus->phase)
+            {
+                bus->sr1  &= ~I2C_SR1_SB;
+                bus->shift = (uint8_t) value;
+                emuI2CStartByte(bus, EMU_I2C_ADDR, now);
+            }
+            else if (EMU_I2C_TX_WAIT == bus->phase)
+            {
+                bus->shift = (uint8_t) value;               // DR -> shifter, TXE stays set
+                bus->sr1  &= ~I2C_SR1_BTF;
+                emuI2CStartByte(bus, EMU_I2C_TX, now);
+            }
+            else if ((EMU_I2C_TX == bus->phase) && !bus->txFull)
+            {
+                bus->txData = (uint8_t) value;
+                bus->txFull = true;
+                bus->sr1   &= ~I2C_SR1_TXE;
+            }
+            break;
+
+        case offsetof(I2C_TypeDef, SR1):
+            bus->sr1 &= value | ~EMU_I2C_SR1_ERRORS;
+            break;
+
+        case offsetof(I2C_TypeDef, CCR):
+            bus->ccr = value & 0xCFFF;
+            break;
+
+        case offsetof(I2C_TypeDef, TRISE):
+            bus->trise = value & 0x003F;
+            break;
+
+        case offsetof(I2C_TypeDef, FLTR):
+            bus->fltr = value & 0x001F;
+            break;
+
+        default:                                            // SR2 is read only
+            break;
+    }
+}
+
+/**
+ * Copies the register set into the register image which is seen by the CPU.
+ */
+void emuI2CImage(const EMU_I2C_t *bus, volatile I2C_TypeDef *regs)
+{
+    regs->CR1   = bus->cr1;
+    regs->CR2   = bus->cr2;
+    regs->OAR1  = bus->oar1;
+    regs->OAR2  = bus->oar2;
+    regs->DR    = bus->dr;
+    regs->SR1   = bus->sr1;
+    regs->SR2   = bus->sr2;
+    regs->CCR   = bus->ccr;
+    regs->TRISE = bus->trise;
+    regs->FLTR  = bus->fltr;
+}
+
+/**
+ * @return EMU_I2C_IRQ_EV and / or EMU_I2C_IRQ_ER if the interrupt request is active
+ */
+uint8_t emuI2CIrq(const EMU_I2C_t *bus)
+{
+    uint8_t irq = 0;
+
+    if ((bus->cr2 & I2C_CR2_ITEVTEN) &&
+        ((bus->sr1 & EMU_I2C_SR1_EVENTS) || ((bus->cr2 & I2C_CR2_ITBUFEN) && (bus->sr1 & (I2C_SR1_TXE | I2C_SR1_RXNE)))))
+    {
+        irq |= EMU_I2C_IRQ_EV;
+    }
+    if ((bus->cr2 & I2C_CR2_ITERREN) && (bus->sr1 & EMU_I2C_SR1_ERRORS))
+    {
+        irq |= EMU_I2C_IRQ_ER;
+    }
+    return irq;
+}
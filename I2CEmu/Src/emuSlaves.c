@@ -0,0 +1,220 @@
+/**
+ * emuSlaves.c
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: T Flaemig
+ *
+ *  Slave models of the I2C emulator. The callbacks are called from the bus model, i.e. from the
+ *  signal handler of the access trap: no output, no allocation.
+ */
+#include <stddef.h>
+#include <string.h>
+#include <emuSlaves.h>
+
+/**
+ * Register file
+ */
+static bool emuRegFileStart(EMU_SLAVE_t *slave, bool read)
+{
+    EMU_REGFILE_t *rf = (EMU_REGFILE_t *) slave;
+
+    if (!read)
+    {
+        rf->ptrValid = false;                               // First byte is the register address
+    }
+    return true;
+}
+
+static bool emuRegFileWrite(EMU_SLAVE_t *slave, uint8_t data)
+{
+    EMU_REGFILE_t *rf = (EMU_REGFILE_t *) slave;
+
+    if (!rf->ptrValid)
+    {
+        rf->ptr      = data;
+        rf->ptrValid = true;
+        return true;
+    }
+    rf->regs[rf->ptr] = data;
+    rf->writes++;
+    if (NULL != rf->onWrite)
+    {
+        rf->onWrite(rf, rf->ptr, data);
+    }
+    rf->ptr++;
+    return true;
+}
+
+static uint8_t emuRegFileRead(EMU_SLAVE_t *slave)
+{
+    EMU_REGFILE_t *rf = (EMU_REGFILE_t *) slave;
+
+    return rf->regs[rf->ptr++];
+}
+
+void emuRegFileInit(EMU_REGFILE_t *rf, uint8_t addr)
+{
+    memset(rf, 0, sizeof(*rf));
+    rf->slave.addr  = addr;
+    rf->slave.start = emuRegFileStart;
+    rf->slave.write = emuRegFileWrite;
+    rf->slave.read  = emuRegFileRead;
+}
+
+/**
+ * MPU6050: lying flat (Z = +1 g), 25 °C, small gyro offsets
+ */
+#define EMU_MPU_ACCEL_XOUT_H        (0x3B)
+#define EMU_MPU_PWR_MGMT_1          (0x6B)
+#define EMU_MPU_WHO_AM_I            (0x75)
+#define EMU_MPU_DEVICE_RESET        (0x80)
+
+static const uint8_t emuMpuData[14] =
+{
+    0x00, 0x40,  0x00, 0x20,  0x40, 0x00,                   // Accel X, Y, Z
+    0xF0, 0xB0,                                             // Temp: -3920 / 340 + 36.53 = 25 °C
+    0x00, 0x10,  0xFF, 0xF0,  0x00, 0x08                    // Gyro X, Y, Z
+};
+
+static void emuMpuReset(EMU_REGFILE_t *rf)
+{
+    memset(rf->regs, 0, sizeof(rf->regs));
+    memcpy(&rf->regs[EMU_MPU_ACCEL_XOUT_H], emuMpuData, sizeof(emuMpuData));
+    rf->regs[EMU_MPU_PWR_MGMT_1] = 0x40;                   // SLEEP
+    rf->regs[EMU_MPU_WHO_AM_I]   = 0x68;
+}
+
+static void emuMpuWrite(EMU_REGFILE_t *rf, uint8_t reg, uint8_t value)
+{
+    if ((EMU_MPU_PWR_MGMT_1 == reg) && (value & EMU_MPU_DEVICE_RESET))
+    {
+        emuMpuReset(rf);
+    }
+}
+
+void emuMpu6050Init(EMU_REGFILE_t *rf, uint8_t addr)
+{
+    emuRegFileInit(rf, addr);
+    rf->onWrite = emuMpuWrite;
+    emuMpuReset(rf);
+}
+
+/**
+ * AMIS-30624: commands are executed at the STOP, Get commands already with the command byte
+ * (the answer is read after a repeated START).
+ */
+#define EMU_AMIS_GET_FULL_STATUS1   (0x81)
+#define EMU_AMIS_GET_FULL_STATUS2   (0xFC)
+#define EMU_AMIS_RESET_POSITION     (0x86)
+#define EMU_AMIS_SET_MOTOR_PARAM    (0x89)
+#define EMU_AMIS_SET_POSITION       (0x8B)
+
+static void emuAmisStatus(EMU_AMIS_t *amis, uint8_t cmd)
+{
+    memset(amis->resp, 0xFF, sizeof(amis->resp));
+    amis->resp[0] = (uint8_t) (amis->slave.addr << 1);
+    if (EMU_AMIS_GET_FULL_STATUS1 == cmd)
+    {
+        amis->resp[1] = (uint8_t) ((amis->iRun << 4) | amis->iHold);
+        amis->resp[2] = (uint8_t) ((amis->vMax << 4) | amis->vMin);
+    }
+    else
+    {
+        amis->resp[1] = (uint8_t) ((uint16_t) amis->actPos >> 8);
+        amis->resp[2] = (uint8_t) amis->actPos;
+        amis->resp[3] = (uint8_t) ((uint16_t) amis->tagPos >> 8);
+        amis->resp[4] = (uint8_t) amis->tagPos;
+    }
+    amis->respIdx = 0;
+}
+
+static bool emuAmisStart(EMU_SLAVE_t *slave, bool read)
+{
+    EMU_AMIS_t *amis = (EMU_AMIS_t *) slave;
+
+    if (!read)
+    {
+        amis->cmdLen = 0;
+    }
+    return true;
+}
+
+static bool emuAmisWrite(EMU_SLAVE_t *slave, uint8_t data)
+{
+    EMU_AMIS_t *amis = (EMU_AMIS_t *) slave;
+
+    if (amis->cmdLen < sizeof(amis->cmd))
+    {
+        amis->cmd[amis->cmdLen++] = data;
+    }
+    if ((1 == amis->cmdLen) && ((EMU_AMIS_GET_FULL_STATUS1 == data) || (EMU_AMIS_GET_FULL_STATUS2 == data)))
+    {
+        emuAmisStatus(amis, data);
+        amis->commands++;
+    }
+    return true;
+}
+
+static uint8_t emuAmisRead(EMU_SLAVE_t *slave)
+{
+    EMU_AMIS_t *amis = (EMU_AMIS_t *) slave;
+
+    return (amis->respIdx < sizeof(amis->resp)) ? amis->resp[amis->respIdx++] : 0xFF;
+}
+
+static void emuAmisStop(EMU_SLAVE_t *slave)
+{
+    EMU_AMIS_t *amis = (EMU_AMIS_t *) slave;
+
+    if (0 == amis->cmdLen)
+    {
+        return;
+    }
+    switch (amis->cmd[0])
+    {
+        case EMU_AMIS_RESET_POSITION:
+            amis->actPos = 0;
+            amis->tagPos = 0;
+            amis->commands++;
+            break;
+
+        case EMU_AMIS_SET_POSITION:
+            if (amis->cmdLen >= 5)
+            {
+                amis->tagPos = (int16_t) ((amis->cmd[3] << 8) | amis->cmd[4]);
+                amis->actPos = amis->tagPos;                // The motor is infinitely fast
+                amis->commands++;
+            }
+            break;
+
+        case EMU_AMIS_SET_MOTOR_PARAM:
+            if (amis->cmdLen >= 5)
+            {
+                amis->iRun  = amis->cmd[3] >> 4;
+                amis->iHold = amis->cmd[3] & 0x0F;
+                amis->vMax  = amis->cmd[4] >> 4;
+                amis->vMin  = amis->cmd[4] & 0x0F;
+                amis->commands++;
+            }
+            break;
+
+        case EMU_AMIS_GET_FULL_STATUS1:
+        case EMU_AMIS_GET_FULL_STATUS2:
+            break;
+
+        default:                                            // Accepted w/o effect
+            amis->commands++;
+            break;
+    }
+    amis->cmdLen = 0;
+}
+
+void emuAmisInit(EMU_AMIS_t *amis, uint8_t addr)
+{
+    memset(amis, 0, sizeof(*amis));
+    amis->slave.addr  = addr;
+    amis->slave.start = emuAmisStart;
+    amis->slave.write = emuAmisWrite;
+    amis->slave.read  = emuAmisRead;
+    amis->slave.stop  = emuAmisStop;
+}
@@ -0,0 +1,290 @@
+/**
+ * main.c (I2C emulator)
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: T Flaemig
+ *
+ *  Runs MCAL and BALO drivers unmodified against the emulated I2C1 with an MPU6050 at 0x68 and
+ *  two AMIS-30624 at 0x60 / 0x61, checks the results and prints START conditions, bus bytes,
+ *  interrupts and virtual time per driver call.
+ *
+ *  Usage: i2cEmu [SCL rate in kHz, default 400]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mcalI2C.h>
+#include <mcalI2CTrace.h>
+#include <i2cMPU.h>
+#include <i2cAMIS.h>
+#include <i2cSched.h>
+#include <i2cEmu.h>
+#include <emuSlaves.h>
+
+static EMU_REGFILE_t emuMpu;
+static EMU_AMIS_t    emuMotL, emuMotR;
+
+static uint64_t      benchT0;
+static EMU_STATS_t   benchS0;
+static int           benchErrors;
+
+static void benchBegin(void)
+{
+    benchT0 = emuNowNs();
+    benchS0 = *emuGetStats(I2C1);
+}
+
+static void benchEnd(const char *name, bool ok)
+{
+    const EMU_STATS_t *s = emuGetStats(I2C1);
+
+    printf("%-28s %-4s %6u %6u %6u %5u %10.1f %10.1f\n", name, ok ? "ok" : "FAIL",
+           s->starts - benchS0.starts, s->bytes - benchS0.bytes, s->naks - benchS0.naks, s->irqs - benchS0.irqs,
+           (emuNowNs() - benchT0) / 1000.0, (s->busyNs - benchS0.busyNs) / 1000.0);
+    if (!ok)
+    {
+        benchErrors++;
+    }
+}
+
+#define BENCH(name, call, check)    do { benchBegin(); call; benchEnd(name, (check)); } while (0)
+
+/*
+ * Every probe of a scan has to show up in the trace ring: returns true if the ring holds
+ * exactly numProbes entries of which numNacks were not acknowledged.
+ */
+static bool traceProbesRecorded(uint8_t numProbes, uint8_t numNacks)
+{
+    I2C_TRACE_ENTRY_t e;
+    uint8_t           n = 0, nacks = 0;
+
+    while (i2cTraceRead(&e))
+    {
+        n++;
+        if (I2C_NACK == e.result)
+        {
+            nacks++;
+        }
+    }
+    return (numProbes == n) && (numNacks == nacks);
+}
+
+/*
+ * Transfers chained from the completion interrupt: the first callback submits the second one
+ * and queues two more with a lower priority, which have to run in FIFO order. The main loop only reads DWT->CYCCNT (no
+ * i2cCheckTimeout()), so every follow-up has to be started by the interrupt handler.
+ */
+#define CHAIN_LEN                   (4)
+
+static const uint8_t chainReg = 0x75;                       // WHO_AM_I of the MPU6050
+static uint8_t        chainRx[CHAIN_LEN];
+static I2C_TRANSFER_t chainXfer[CHAIN_LEN];
+static uint8_t        chainOrder[CHAIN_LEN];
+static volatile uint8_t chainDone;
+
+static void chainCallback(I2C_TRANSFER_t *xfer)
+{
+    chainOrder[chainDone++] = (uint8_t) (xfer - chainXfer);
+    if (xfer == &chainXfer[0])
+    {
+        i2cSubmitTransfer(I2C1, &chainXfer[1]);         // Keeps the bus
+        i2cQueueTransfer(I2C1, &chainXfer[2], I2C_PRIO_TELEMETRY);
+        i2cQueueTransfer(I2C1, &chainXfer[3], I2C_PRIO_TELEMETRY);
+    }
+}
+
+/*
+ * Blocking call from a completion callback: the I2C interrupt can't be taken, the driver polls
+ */
+static uint8_t           isrWho;
+static I2C_RETURN_CODE_t isrRc;
+
+static void isrBlockingCallback(I2C_TRANSFER_t *xfer)
+{
+    (void) xfer;
+    isrRc = i2cReadByteFromSlaveReg(I2C1, 0x68, 0x75, &isrWho);
+}
+
+static bool isrBlockingRun(void)
+{
+    uint64_t tEnd = emuNowNs() + 5000000;
+
+    memset(&chainXfer[0], 0, sizeof(chainXfer[0]));
+    chainXfer[0].saddr    = 0x68;
+    chainXfer[0].txBuf    = &chainReg;
+    chainXfer[0].txLen    = 1;
+    chainXfer[0].callback = isrBlockingCallback;
+    isrWho = 0;
+    isrRc  = I2C_BUSY;
+    if (I2C_OK != i2cSubmitTransfer(I2C1, &chainXfer[0]))
+    {
+        return false;
+    }
+    while ((I2C_BUSY == isrRc) && (emuNowNs() < tEnd))
+    {
+        (void) DWT->CYCCNT;
+    }
+    while ((I2C1->SR2 & I2C_SR2_BUSY) && (emuNowNs() < tEnd))
+    {
+        ;
+    }
+    return (I2C_OK == isrRc) && (0x68 == isrWho);
+}
+
+/*
+ * Cycle scheduler: two MPU6050 jobs chained by the interrupt, a disabled job for the stepper
+ * at 0x61 whose bus time has to follow its speed profile, and a job on I2C3 which is rejected.
+ */
+static uint8_t       schedReg[2] = { 0x75, 0x3B };          // WHO_AM_I, ACCEL_XOUT_H
+static uint8_t       schedWho, schedAccel[6];
+static I2C_SEGMENT_t schedWhoSeg[2] = {
+    { 0x68, I2C_SEG_WRITE, I2C_SEG_DEFAULT, 1, &schedReg[0] }, { 0x68, I2C_SEG_READ, I2C_SEG_DEFAULT, 1, &schedWho } };
+static I2C_SEGMENT_t schedAccelSeg[2] = {
+    { 0x68, I2C_SEG_WRITE, I2C_SEG_DEFAULT, 1, &schedReg[1] }, { 0x68, I2C_SEG_READ, I2C_SEG_DEFAULT, 6, schedAccel } };
+static I2C_SEGMENT_t schedStepSeg[2] = {
+    { 0x61, I2C_SEG_WRITE, I2C_SEG_DEFAULT, 1, &schedReg[0] }, { 0x61, I2C_SEG_READ, I2C_SEG_DEFAULT, 1, &schedWho } };
+
+static bool schedRun(void)
+{
+    int8_t   step;
+    uint32_t tStep;
+
+    i2cSchedInit();
+    if ((i2cSchedAddJob(I2C3, I2C_SCHED_BUS1, schedWhoSeg, 2, false) >= 0) ||
+        (0 != i2cSchedAddJob(I2C1, I2C_SCHED_BUS1, schedWhoSeg, 2, false)) ||
+        (1 != i2cSchedAddJob(I2C1, I2C_SCHED_BUS1, schedAccelSeg, 2, false)))
+    {
+        return false;
+    }
+    step  = i2cSchedAddJob(I2C1, I2C_SCHED_BUS1, schedStepSeg, 2, false);
+    tStep = i2cSchedBusTimeUs(I2C1);
+    i2cSchedEnableJob(step, false);
+    tStep -= i2cSchedBusTimeUs(I2C1);
+    if (tStep != (39 * 1000000UL + i2cGetSlaveSpeed(I2C1, 0x61) - 1) / i2cGetSlaveSpeed(I2C1, 0x61))
+    {
+        return false;                                       // 39 bits at the speed of the profile
+    }
+
+    schedWho = 0;
+    if ((I2C_OK != i2cSchedStartCycle()) || (I2C_OK != i2cSchedWaitCycle()))
+    {
+        return false;
+    }
+    while (I2C1->SR2 & I2C_SR2_BUSY)
+    {
+        ;
+    }
+    return (0x68 == schedWho) && (0x40 == schedAccel[4]) && (I2C_OK == i2cSchedJobResult(1));
+}
+
+static bool chainRun(void)
+{
+    uint64_t tEnd = emuNowNs() + 5000000;                   // 5 ms
+    uint8_t  i;
+
+    chainDone = 0;
+    for (i = 0; i < CHAIN_LEN; i++)
+    {
+        memset(&chainXfer[i], 0, sizeof(chainXfer[i]));
+        chainXfer[i].saddr    = 0x68;
+        chainXfer[i].txBuf    = &chainReg;
+        chainXfer[i].txLen    = 1;
+        chainXfer[i].rxBuf    = &chainRx[i];
+        chainXfer[i].rxLen    = 1;
+        chainXfer[i].callback = chainCallback;
+        chainRx[i] = 0;
+    }
+    if (I2C_OK != i2cSubmitTransfer(I2C1, &chainXfer[0]))
+    {
+        return false;
+    }
+    while ((chainDone < CHAIN_LEN) && (emuNowNs() < tEnd))
+    {
+        (void) DWT->CYCCNT;                                 // Lets time pass and takes the interrupts
+    }
+    while ((I2C1->SR2 & I2C_SR2_BUSY) && (emuNowNs() < tEnd))
+    {
+        ;                                                   // STOP of the last one, for the bus time
+    }
+    for (i = 0; i < CHAIN_LEN; i++)
+    {
+        if ((i >= chainDone) || (chainOrder[i] != i) || (0x68 != chainRx[i]) || (I2C_OK != chainXfer[i].result))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    static const uint8_t scanList[] = { 0x61, 0x60, 0x68, 0x29 };
+    static MPU6050_t     mpu;
+    static Stepper_t     stepL, stepR;
+    uint8_t              present[I2C_SCAN_MAP_SIZE];
+    uint8_t              who = 0;
+    uint32_t             sclKHz = (argc > 1) ? (uint32_t) atoi(argv[1]) : 400;
+    I2C_RETURN_CODE_t    rc = I2C_OK;
+    int8_t               mpuRc = -1;
+    int16_t              pitch, pos = 0;
+    float                temp = 0;
+    uint8_t              i;
+    bool                 ok;
+
+    emuInit(84000000);
+    emuMpu6050Init(&emuMpu, 0x68);
+    emuAmisInit(&emuMotL, 0x61);
+    emuAmisInit(&emuMotR, 0x60);
+    emuAttachSlave(I2C1, &emuMpu.slave);
+    emuAttachSlave(I2C1, &emuMotL.slave);
+    emuAttachSlave(I2C1, &emuMotR.slave);
+
+    printf("I2C1 emulated, HCLK 84 MHz, PCLK1 42 MHz, SCL %u kHz\n\n", sclKHz);
+    printf("%-28s %-4s %6s %6s %6s %5s %10s %10s\n", "call", "", "starts", "bytes", "naks", "irqs", "time [us]", "bus [us]");
+
+    i2cSelectI2C(I2C1);
+    BENCH("i2cInitI2C", rc = i2cInitI2C(I2C1, I2C_DUTY_CYCLE_2, 17, I2C_CLOCK_400), I2C_OK == rc);
+    BENCH("i2cSetSclFreq", rc = i2cSetSclFreq(I2C1, sclKHz * 1000), I2C_OK == rc);
+
+    i2cTraceEnable(true);
+    i2cTraceReset();
+    BENCH("i2cScanBus (4 addresses)", rc = i2cScanBus(I2C1, scanList, sizeof(scanList), present),
+          (I2C_OK == rc) && I2C_SCAN_PRESENT(present, 0x68) && I2C_SCAN_PRESENT(present, 0x61) &&
+          !I2C_SCAN_PRESENT(present, 0x29) && traceProbesRecorded(sizeof(scanList), 1));
+    i2cTraceEnable(false);
+    BENCH("i2cScanBus (full)", rc = i2cScanBus(I2C1, NULL, 0, present),
+          (I2C_OK == rc) && I2C_SCAN_PRESENT(present, 0x60) && !I2C_SCAN_PRESENT(present, 0x50));
+    BENCH("i2cReadByteFromSlaveReg", rc = i2cReadByteFromSlaveReg(I2C1, 0x68, 0x75, &who), (I2C_OK == rc) && (0x68 == who));
+    BENCH("i2cSendByte (NACK)", rc = i2cSendByte(I2C1, 0x50, 0x00), I2C_NACK == rc);
+    BENCH("chained from the ISR (4)", ok = chainRun(), ok);
+    who = 0;
+    __disable_irq();
+    BENCH("i2cReadByte... (PRIMASK set)", rc = i2cReadByteFromSlaveReg(I2C1, 0x68, 0x75, &who), (I2C_OK == rc) && (0x68 == who));
+    __enable_irq();
+    BENCH("i2cReadByte... (in the ISR)", ok = isrBlockingRun(), ok);
+
+    for (i = 0; (i < 4) && (0 != mpuRc); i++)
+    {
+        BENCH("mpuInit", mpuRc = mpuInit(&mpu, I2C1, i2cAddr_MPU6050, FSCALE_250, ACCEL_2g, LPBW_184, NO_RESTART), true);
+    }
+    BENCH("mpuInit (unchanged)", mpuRc = mpuInit(&mpu, I2C1, i2cAddr_MPU6050, FSCALE_250, ACCEL_2g, LPBW_184, NO_RESTART),
+          true);
+    BENCH("mpuGetAccel", mpuGetAccel(&mpu), (mpu.accel_raw[2] == 0x4000));
+    BENCH("mpuGetGyro", mpuGetGyro(&mpu), (mpu.gyro_raw[1] == -16));
+    BENCH("mpuGetPitch", pitch = mpuGetPitch(&mpu), true);
+    BENCH("mpuGetTemp", temp = mpuGetTemp(&mpu), (temp > 24.5) && (temp < 25.5));
+
+    BENCH("StepperInit (left)", StepperInit(&stepL, I2C1, 0x61, 10, 1, 2, 8, 3, 1, 2, 0),
+          (10 == emuMotL.iRun) && (8 == emuMotL.vMax));
+    BENCH("StepperInit (right)", StepperInit(&stepR, I2C1, 0x60, 10, 1, 2, 8, 3, 0, 2, 0), (1 == emuMotR.iHold));
+    BENCH("i2cSetSlaveSpeed", rc = i2cSetSlaveSpeed(I2C1, 0x61, 200000), I2C_OK == rc);
+    BENCH("StepperSetPos", StepperSetPos(&stepL, -1234), (-1234 == emuMotL.tagPos));
+    BENCH("StepperGetPos (200 kHz)", pos = StepperGetPos(&stepL), (-1234 == pos));
+    BENCH("StepperGetPos (default)", pos = StepperGetPos(&stepR), (0 == pos));
+    BENCH("i2cSched cycle (2 jobs)", ok = schedRun(), ok);
+
+    printf("\npitch %d, temperature %.2f, WHO_AM_I 0x%02X, %u MPU register writes\n", pitch, temp, who, emuMpu.writes);
+    printf("%s\n", (0 == benchErrors) ? "all checks passed" : "CHECKS FAILED");
+
+    return (0 == benchErrors) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
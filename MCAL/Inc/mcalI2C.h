@@ -9,6 +9,11 @@
 #ifndef MCALI2C_H_
 #define MCALI2C_H_
 
+#include <stm32f4xx.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <mcalGPIO.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -33,9 +38,35 @@ typedef enum
     I2C_INVALID_DUTY_CYCLE       = -61,
     I2C_INVALID_CLOCK_SPEED      = -62,
     I2C_INVALID_PERIPHERAL_CLOCK = -63,
-    I2C_INVALID_RISE_TIME
+    I2C_INVALID_RISE_TIME        = -64,
+    I2C_BUSY                     = -65,
+    I2C_INVALID_TRANSFER         = -66,
+    I2C_TRANSFER_ERROR           = -67,
+    I2C_DMA_ERROR                = -68,
+    I2C_TIMEOUT                  = -69,
+    I2C_NACK                     = -70,     // AF: Slave did not acknowledge
+    I2C_BUS_ERROR                = -71,     // BERR or bus still busy after recovery
+    I2C_ARBITRATION_LOST         = -72,     // ARLO
+    I2C_PROFILE_FULL             = -73      // No free speed profile
 } I2C_RETURN_CODE_t;
 
+/**
+ * Limits of i2cSetSclFreq() and number of slave speed profiles per I2C component
+ */
+#define I2C_SCL_MIN_HZ                  (10000UL)
+#define I2C_SCL_MAX_HZ                  (1000000UL)
+#ifndef I2C_MAX_SPEED_PROFILES
+#define I2C_MAX_SPEED_PROFILES          (8)
+#endif
+
+/**
+ * Presence bitmap of i2cScanBus(): bit (addr & 7) of byte (addr >> 3)
+ */
+#define I2C_SCAN_FIRST_ADDR             (0x08)      // 0x00 ... 0x07 and 0x78 ... 0x7F are reserved
+#define I2C_SCAN_LAST_ADDR              (0x77)
+#define I2C_SCAN_MAP_SIZE               (16)
+#define I2C_SCAN_PRESENT(map, addr)     ((((map)[(addr) >> 3]) >> ((addr) & 0x07)) & 0x01)
+
 /**
  * @brief I2C enumerations
  */
@@ -54,6 +85,89 @@ typedef enum
     IC2_DUTY_CYCLE_16_9
 } I2C_DUTY_CYCLE_t;
 
+/**
+ * @brief State of an asynchronous I2C transfer
+ */
+typedef enum
+{
+    I2C_XFER_IDLE               = 0,    // Descriptor not yet submitted
+    I2C_XFER_BUSY,                      // Transfer is processed by the interrupt handlers
+    I2C_XFER_DONE,                      // Transfer finished, see result
+    I2C_XFER_QUEUED                     // Waiting in a priority queue, see i2cQueueTransfer()
+} I2C_XFER_STATE_t;
+
+/**
+ * @brief Priority of a queued transfer, I2C_PRIO_CONTROL is served first
+ *
+ * The bus is handed over at transaction boundaries only: a transfer which has been started
+ * is never interrupted, but all queued transfers of a higher priority are started before
+ * the next one of a lower priority.
+ */
+typedef enum
+{
+    I2C_PRIO_CONTROL            = 0,    // Control loop, e.g. IMU and stepper (blocking functions)
+    I2C_PRIO_TELEMETRY,                 // Background sensor polling, e.g. TOF
+    I2C_PRIO_UI,                        // Display values, e.g. temperature
+    I2C_NUM_PRIO
+} I2C_PRIO_t;
+
+/**
+ * @brief Segment of a scatter-gather transfer
+ */
+typedef enum
+{
+    I2C_SEG_WRITE               = 0,
+    I2C_SEG_READ
+} I2C_SEG_DIR_t;
+
+typedef enum
+{
+    I2C_SEG_DEFAULT             = 0,    // (Repeated) START + slave address before the segment
+    I2C_SEG_NOSTART             = 1     // Write only: continue the preceding write to the same slave
+} I2C_SEG_FLAGS_t;
+
+typedef struct
+{
+    uint8_t                     saddr;      // 7Bit slave address
+    I2C_SEG_DIR_t               dir;
+    uint8_t                     flags;      // I2C_SEG_FLAGS_t
+    uint16_t                    len;        // Read segments need len >= 1
+    uint8_t                    *buf;
+} I2C_SEGMENT_t;
+
+typedef struct I2C_TRANSFER I2C_TRANSFER_t;
+
+/**
+ * Completion callback. It is called from the I2C interrupt handler, so keep it short!
+ */
+typedef void (*I2C_CALLBACK_t)(I2C_TRANSFER_t *xfer);
+
+/**
+ * @brief Descriptor of an asynchronous I2C transfer
+ *
+ * txLen bytes of txBuf are written to the slave first. If rxLen > 0 a (repeated) START
+ * follows and rxLen bytes are read into rxBuf. If numSegments > 0 the segment list is
+ * executed instead (saddr, txBuf and rxBuf are ignored). The descriptor and the segments
+ * must stay valid until state is no longer I2C_XFER_BUSY.
+ */
+struct I2C_TRANSFER
+{
+    uint8_t                     saddr;      // 7Bit slave address
+    const uint8_t              *txBuf;      // e.g. register address followed by data
+    uint16_t                    txLen;
+    uint8_t                    *rxBuf;
+    uint16_t                    rxLen;
+    const I2C_SEGMENT_t        *segments;   // Optional segment list
+    uint8_t                     numSegments;
+    bool                        useDma;     // Segments with >= 2 bytes are transferred by DMA1
+    I2C_CALLBACK_t              callback;   // May be NULL
+    void                       *user;       // Free for use by the caller
+    volatile I2C_XFER_STATE_t   state;
+    volatile I2C_RETURN_CODE_t  result;
+    I2C_TRANSFER_t             *next;       // Queue link, managed by the driver
+    I2C_PRIO_t                  prio;       // Set by i2cQueueTransfer()
+};
+
 /**
  * @}
  */
@@ -74,6 +188,10 @@ extern I2C_RETURN_CODE_t i2cSelectI2C(I2C_TypeDef *i2c);
 extern I2C_RETURN_CODE_t i2cDeselectI2C(I2C_TypeDef *i2c);
 
 extern I2C_RETURN_CODE_t i2cSetClkSpd(I2C_TypeDef *i2c, I2C_CLOCKSPEED_t spd);
+extern I2C_RETURN_CODE_t i2cSetSclFreq(I2C_TypeDef *i2c, uint32_t hz);
+extern I2C_RETURN_CODE_t i2cSetSlaveSpeed(I2C_TypeDef *i2c, uint8_t saddr, uint32_t hz);
+extern uint32_t          i2cGetSclFreq(I2C_TypeDef *i2c);
+extern uint32_t          i2cGetSlaveSpeed(I2C_TypeDef *i2c, uint8_t saddr);
 extern I2C_RETURN_CODE_t i2cEnableDevice(I2C_TypeDef *i2c);
 extern I2C_RETURN_CODE_t i2cDisableDevice(I2C_TypeDef *i2c);
 extern I2C_RETURN_CODE_t i2cSetPeripheralClockFreq(I2C_TypeDef *i2c, uint8_t pclk);
@@ -91,9 +209,34 @@ extern I2C_RETURN_CODE_t i2cReadByte(I2C_TypeDef *i2c, uint8_t saddr, uint8_t *d
 extern I2C_RETURN_CODE_t i2cReadByteFromSlaveReg(I2C_TypeDef *i2c, uint8_t saddr, uint8_t regAddr, uint8_t *data);
 extern I2C_RETURN_CODE_t i2cBurstRead(I2C_TypeDef *i2c, uint8_t saddr, uint8_t *data, uint8_t num);
 extern I2C_RETURN_CODE_t i2cBurstRegRead(I2C_TypeDef *i2c, uint8_t saddr, uint8_t regAddr, uint8_t *data, uint8_t num);
+extern I2C_RETURN_CODE_t i2cWriteRead(I2C_TypeDef *i2c, uint8_t saddr, const uint8_t *wbuf, uint16_t wlen,
+                                      uint8_t *rbuf, uint16_t rlen);
 
 extern I2C_RETURN_CODE_t i2cResetDevice(I2C_TypeDef *i2c);
 extern uint8_t           i2cFindSlaveAddr(I2C_TypeDef *i2c, uint8_t i2cAddr);
+extern I2C_RETURN_CODE_t i2cScanBus(I2C_TypeDef *i2c, const uint8_t *addrList, uint8_t numAddr, uint8_t *presence);
+
+// Asynchronous (interrupt driven) functions
+extern I2C_RETURN_CODE_t i2cSubmitTransfer(I2C_TypeDef *i2c, I2C_TRANSFER_t *xfer);
+extern I2C_RETURN_CODE_t i2cTransfer(I2C_TypeDef *i2c, const I2C_SEGMENT_t *segments, uint8_t numSegments, bool useDma);
+extern bool              i2cIsTransferDone(I2C_TRANSFER_t *xfer);
+extern bool              i2cIsBusBusy(I2C_TypeDef *i2c);
+extern I2C_RETURN_CODE_t i2cCheckTimeout(I2C_TypeDef *i2c);
+extern I2C_RETURN_CODE_t i2cAbortTransfer(I2C_TypeDef *i2c);
+
+// Bus arbitration (priority queues)
+extern I2C_RETURN_CODE_t i2cQueueTransfer(I2C_TypeDef *i2c, I2C_TRANSFER_t *xfer, I2C_PRIO_t prio);
+extern I2C_RETURN_CODE_t i2cCancelTransfer(I2C_TypeDef *i2c, I2C_TRANSFER_t *xfer);
+extern uint8_t           i2cQueuedTransfers(I2C_TypeDef *i2c, I2C_PRIO_t prio);
+
+// Bus recovery
+extern I2C_RETURN_CODE_t i2cSetBusPins(I2C_TypeDef *i2c, GPIO_TypeDef *sclPort, PIN_NUM_t sclPin, ALT_FUNC_t sclAf,
+                                       GPIO_TypeDef *sdaPort, PIN_NUM_t sdaPin, ALT_FUNC_t sdaAf);
+extern I2C_RETURN_CODE_t i2cRecoverBus(I2C_TypeDef *i2c);
+
+// DMA functions (DMA1 streams, see mcalI2C.c)
+extern I2C_RETURN_CODE_t i2cBurstWriteDMA(I2C_TypeDef *i2c, uint8_t saddr, uint8_t *data, uint8_t numBytes);
+extern I2C_RETURN_CODE_t i2cBurstRegReadDMA(I2C_TypeDef *i2c, uint8_t saddr, uint8_t regAddr, uint8_t *data, uint8_t num);
 
 
 #ifdef __cplusplus
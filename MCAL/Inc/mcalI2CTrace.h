@@ -0,0 +1,100 @@
+/**
+ * mcalI2CTrace.h
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: T Flaemig
+ *
+ *  Transaction trace of the I2C transfer engine: ring buffer with DWT timestamps,
+ *  latency histograms per slave and bus utilization.
+ */
+
+#ifndef MCALI2CTRACE_H_
+#define MCALI2CTRACE_H_
+
+#include <stm32f4xx.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <mcalI2C.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @ingroup iic4
+ * @{
+ */
+
+/**
+ * I2C_TRACE_ENABLE = 0 removes the trace hook from mcalI2C.c completely.
+ * With the hook compiled in, nothing is recorded until i2cTraceEnable(true).
+ */
+#ifndef I2C_TRACE_ENABLE
+#define I2C_TRACE_ENABLE                (1)
+#endif
+#ifndef I2C_TRACE_DEPTH
+#define I2C_TRACE_DEPTH                 (64)        // Entries of the ring buffer, power of 2
+#endif
+#ifndef I2C_TRACE_MAX_DEVICES
+#define I2C_TRACE_MAX_DEVICES           (8)         // Slaves with latency statistics
+#endif
+#define I2C_TRACE_HIST_BINS             (8)         // Bin n: latency < (I2C_TRACE_HIST_BASE_US << n), last bin: longer
+#define I2C_TRACE_HIST_BASE_US          (25)
+
+/**
+ * @brief One finished transaction
+ */
+typedef struct
+{
+    uint32_t                    seq;        // Sequence number
+    uint32_t                    tStart;     // DWT->CYCCNT at the start
+    uint32_t                    tEnd;       // DWT->CYCCNT at the completion
+    uint16_t                    len;        // Data bytes of all segments
+    int16_t                     reg;        // First byte of the first write segment, -1 if none
+    uint8_t                     bus;        // 1 ... 3
+    uint8_t                     saddr;      // Slave of the first segment
+    uint8_t                     numSegments;
+    int8_t                      result;     // I2C_RETURN_CODE_t
+} I2C_TRACE_ENTRY_t;
+
+/**
+ * @brief Latency statistics of one slave
+ */
+typedef struct
+{
+    uint8_t                     bus;        // 0: unused
+    uint8_t                     saddr;
+    uint32_t                    count;
+    uint32_t                    errors;
+    uint32_t                    minCycles;
+    uint32_t                    maxCycles;
+    uint64_t                    sumCycles;
+    uint32_t                    hist[I2C_TRACE_HIST_BINS];
+} I2C_TRACE_DEVICE_t;
+
+typedef void (*I2C_TRACE_OUT_t)(const char *line);
+
+/**
+ * @}
+ */
+
+
+extern void                      i2cTraceSetClock(void);
+extern void                      i2cTraceEnable(bool enable);
+extern void                      i2cTraceReset(void);
+extern void                      i2cTraceTransfer(I2C_TypeDef *i2c, const I2C_SEGMENT_t *seg, uint8_t numSegments,
+                                                  I2C_RETURN_CODE_t result, uint32_t tStart, uint32_t tEnd);
+
+extern bool                      i2cTraceRead(I2C_TRACE_ENTRY_t *entry);
+extern uint32_t                  i2cTraceLost(void);
+extern const I2C_TRACE_DEVICE_t *i2cTraceGetDevice(uint8_t idx);
+extern uint8_t                   i2cTraceBusUtilization(I2C_TypeDef *i2c, bool restart);
+extern uint32_t                  i2cTraceCyclesToUs(uint32_t cycles);
+extern void                      i2cTraceDump(I2C_TRACE_OUT_t out);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MCALI2CTRACE_H_ */
@@ -33,7 +33,8 @@ typedef enum
     SPI_INVALID_SSI_LEVEL       = -85,
     SPI_INVALID_OP_MODE         = -86,
     SPI_INVALID_PHASE           = -87,
-    SPI_INVALID_IDLE_POLARITY   = -88
+    SPI_INVALID_IDLE_POLARITY   = -88,
+    SPI_DMA_BUSY                = -89
 } SPI_RETURN_CODE_t;
 
 typedef enum
@@ -144,6 +145,20 @@ extern void spiClearInterruptType(SPI_TypeDef *spi, uint8_t interruptType);
 extern void spiEnableDmaType(SPI_TypeDef *spi, uint8_t dmaType);
 extern void spiDisableDmaType(SPI_TypeDef *spi, uint8_t dmaType);
 
+// Sessions: CS stays low from begin to end, frames are written back-to-back
+extern SPI_RETURN_CODE_t spiBeginSession(SPI_TypeDef *spi, GPIO_TypeDef *port, PIN_NUM_t pin, SPI_DATALEN_t len);
+extern void              spiSessionWrite8(SPI_TypeDef *spi, uint8_t data);
+extern void              spiSessionWrite16(SPI_TypeDef *spi, uint16_t data);
+extern void              spiSessionWrite(SPI_TypeDef *spi, const void *data, uint16_t num);
+extern void              spiSessionFlush(SPI_TypeDef *spi);
+extern SPI_RETURN_CODE_t spiEndSession(SPI_TypeDef *spi, GPIO_TypeDef *port, PIN_NUM_t pin);
+
+// DMA transmit (master, TX only): CS is handled by the caller
+extern SPI_RETURN_CODE_t spiSwitchDataLen(SPI_TypeDef *spi, SPI_DATALEN_t len);
+extern SPI_RETURN_CODE_t spiWriteDMA(SPI_TypeDef *spi, const void *data, uint16_t num, SPI_DATALEN_t len, bool memIncr);
+extern bool              spiIsDMABusy(SPI_TypeDef *spi);
+extern SPI_RETURN_CODE_t spiWaitDMA(SPI_TypeDef *spi);
+
 //extern uint8_t spiReadByte(SPI_TypeDef *spi, GPIO_TypeDef *port, PIN_NUM_t pin);
 //extern uint8_t spiReadRegByte(SPI_TypeDef *spi, GPIO_TypeDef *port, PIN_NUM_t pin, uint8_t reg);
 //extern SPI_RETURN_CODE_t spiReadRegWord(SPI_TypeDef *spi, GPIO_TypeDef *port, PIN_NUM_t pin, uint8_t reg, uint16_t *data);
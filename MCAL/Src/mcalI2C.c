@@ -30,33 +30,63 @@
  */
 
 #include <stm32f4xx.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <mcalRCC.h>
+#include <mcalDMAC.h>
 #include <mcalI2C.h>
+#include <mcalI2CTrace.h>
 
 
+/**
+ * Timeouts. All waits are bounded by the DWT cycle counter, which is enabled by i2cInitI2C().
+ *
+ * I2C_TIMEOUT_US          : Max. time of a single wait for a flag and base time of a transfer
+ * I2C_TIMEOUT_US_PER_BYTE : Additional time per byte of a transfer (9 SCL clocks at 50 kHz = 180 us)
+ * I2C_RECOVERY_HALF_US    : Half period of the SCL clock-out during bus recovery (100 kHz)
+ * I2C_ISR_STOP_WAIT_US    : Max. wait in interrupt context for the STOP of the previous transfer
+ *                           (STOP and bus free time, 2 SCL clocks at 50 kHz = 40 us)
+ */
+#ifndef I2C_TIMEOUT_US
+#define I2C_TIMEOUT_US                      (1000UL)
+#endif
+#ifndef I2C_TIMEOUT_US_PER_BYTE
+#define I2C_TIMEOUT_US_PER_BYTE             (200UL)
+#endif
+#define I2C_RECOVERY_HALF_US                (5UL)
+#ifndef I2C_ISR_STOP_WAIT_US
+#define I2C_ISR_STOP_WAIT_US                (50UL)
+#endif
+#define I2C_RECOVERY_PULSES                 (9)
+
+static uint32_t i2cCyclesPerUs = 16;                            // Updated by i2cInitI2C()
+
 /**
  * Some macros which are permanently used to check the status registers
  *
  * @param  i2c : Address of the I2C component
  *
  * @note
- * tout = internal timeout counter
+ * tout = internal timeout counter. The wait macros return true if the condition was
+ * reached and false if I2C_TIMEOUT_US expired.
  */
+#define I2C_WAIT_FOR(cond)                  ( { uint32_t tout = DWT->CYCCNT; bool ok;                           \
+                                                while (!(ok = (cond)) &&                                        \
+                                                       ((DWT->CYCCNT - tout) < (i2cCyclesPerUs * I2C_TIMEOUT_US))) ; \
+                                                ok; } )
 
+#define I2C_WAIT_BUSY(i2c)                  I2C_WAIT_FOR(!(i2c->SR2 & I2C_SR2_BUSY))
 
-#define I2C_WAIT_BUSY(i2c)                  ( { while (i2c->SR2 & I2C_SR2_BUSY) ; } )
-
-#define I2C_START_COMPLETED(i2c)            ( { while (!(i2c->SR1 & I2C_SR1_SB)) ; } )
-#define I2C_STOPP_COMPLETED(i2c)            ( { while (!(i2c->SR1 & I2C_SR1_STOPF)) ; } )
-#define I2C_ADDRESS_COMPLETED(i2c)          ( { while (!(i2c->SR1 & I2C_SR1_ADDR)) ; } )
+#define I2C_START_COMPLETED(i2c)            I2C_WAIT_FOR(i2c->SR1 & I2C_SR1_SB)
+#define I2C_STOPP_COMPLETED(i2c)            I2C_WAIT_FOR(!(i2c->CR1 & I2C_CR1_STOP))
+#define I2C_ADDRESS_COMPLETED(i2c)          I2C_WAIT_FOR(i2c->SR1 & I2C_SR1_ADDR)
 
 #define I2C_DUMMY_READ_SR1(i2c)             ( { i2c->SR1; } )
 #define I2C_DUMMY_READ_SR2(i2c)             ( { i2c->SR2; } )
-#define I2C_CHECK_RXBUF_NOT_EMPTY(i2c)      ( { while(!(i2c->SR1 & I2C_SR1_RXNE)) ; } )
+#define I2C_CHECK_RXBUF_NOT_EMPTY(i2c)      I2C_WAIT_FOR(i2c->SR1 & I2C_SR1_RXNE)
 
-#define I2C_BYTE_TRANSFER_FINISHED(i2c)     ( { while(!(i2c->SR1 & I2C_SR1_BTF)) ; })
+#define I2C_BYTE_TRANSFER_FINISHED(i2c)     I2C_WAIT_FOR(i2c->SR1 & I2C_SR1_BTF)
 #define I2C_RESET_ACK(i2c)                  ( { i2c->CR1 &= ~I2C_CR1_ACK_Msk; } )
 #define I2C_SET_ACK(i2c)                    ( { i2c->CR1 |= I2C_CR1_ACK; } )
 #define I2C_SET_POS(i2c)                    ( { i2c->CR1 |= I2C_CR1_POS; } )
@@ -64,37 +94,37 @@
 
 
 
-static inline void __i2c_start(I2C_TypeDef *i2c)
+static inline bool __i2c_start(I2C_TypeDef *i2c)
 {
 	i2c->CR1 |= I2C_CR1_START;
-	while (!(i2c->SR1 & I2C_SR1_SB));
+	return I2C_START_COMPLETED(i2c);
 }
 
-static inline void __i2c_stop(I2C_TypeDef *i2c)
+static inline bool __i2c_stop(I2C_TypeDef *i2c)
  {
  	i2c->CR1 |= I2C_CR1_STOP;
- 	while (!(i2c->SR2 & I2C_SR2_BUSY));
+ 	return I2C_STOPP_COMPLETED(i2c);        // STOP is cleared by hardware when the condition was sent
  }
 
-static inline void __i2c_dummy_read_SR1_SR2(I2C_TypeDef *i2c)
+static inline bool __i2c_dummy_read_SR1_SR2(I2C_TypeDef *i2c)
 {
-	while (!(i2c->SR1) | !(i2c->SR2))
-	{
-	;
-	}
+	return I2C_WAIT_FOR((i2c->SR1) && (i2c->SR2));
 }
 
 
-static inline void __i2c_Chk_TX_empty(I2C_TypeDef *i2c)
+static inline bool __i2c_Chk_TX_empty(I2C_TypeDef *i2c)
+{
+	return I2C_WAIT_FOR(i2c->SR1 & I2C_SR1_TXE);
+}
+
+static inline void __i2c_delay_us(uint32_t us)
 {
+	uint32_t start = DWT->CYCCNT;
 
-	uint32_t simpleDelay;
-	while(!(i2c->SR1 & I2C_SR1_TXE));
-	for (simpleDelay = 0UL; simpleDelay < 20UL; simpleDelay++)
+	while ((DWT->CYCCNT - start) < (i2cCyclesPerUs * us))
 	{
 		;
 	}
-
 }
 
 
@@ -119,6 +149,138 @@ static bool i2cVerifyDutyCycle(I2C_DUTY_CYCLE_t dc)
     return false;
 }
 
+/**
+ * Speed profile of a slave, see i2cSetSlaveSpeed(). CCR and TRISE are computed in advance,
+ * so switching between two transfers costs only a few register writes.
+ */
+typedef struct
+{
+    uint8_t                   saddr;
+    uint32_t                  hz;
+    uint16_t                  ccr;      // incl. FS and DUTY
+    uint16_t                  trise;
+} I2C_SPEED_PROFILE_t;
+
+/**
+ * Context of the asynchronous transfer engine, one per I2C component.
+ */
+typedef enum
+{
+    I2C_PHASE_TX = 0,
+    I2C_PHASE_RX
+} I2C_PHASE_t;
+
+typedef struct
+{
+    I2C_TRANSFER_t * volatile xfer;     // Active transfer, NULL if idle
+    const I2C_SEGMENT_t      *seg;      // Segment list of the active transfer
+    uint8_t                   segCount;
+    uint8_t                   segIdx;   // Current segment
+    I2C_SEGMENT_t             simpleSeg[2];     // Segments of a descriptor w/o segment list
+    I2C_PHASE_t               phase;
+    const uint8_t            *txPtr;
+    uint8_t                  *rxPtr;
+    uint16_t                  count;    // Bytes left in the current segment
+    bool                      dma;      // Current phase is transferred by DMA
+    bool                      dmaReady; // DMA1 clock and stream IRQ enabled
+    bool                      recover;  // Bus recovery required before the next transfer
+    volatile uint8_t          polling;  // Blocking calls which poll the handlers, see i2cRunBlocking()
+    uint32_t                  t0;       // DWT->CYCCNT at submission
+    uint32_t                  budget;   // Max. duration of the active transfer in CPU cycles
+    GPIO_TypeDef             *sclPort;  // Pins used by i2cRecoverBus(), see i2cSetBusPins()
+    PIN_NUM_t                 sclPin;
+    ALT_FUNC_t                sclAf;
+    GPIO_TypeDef             *sdaPort;
+    PIN_NUM_t                 sdaPin;
+    ALT_FUNC_t                sdaAf;
+    I2C_DUTY_CYCLE_t          duty;     // Preferred fast mode duty cycle
+    uint32_t                  defHz;    // Default timing, see i2cSetSclFreq()
+    uint16_t                  defCcr;
+    uint16_t                  defTrise;
+    I2C_SPEED_PROFILE_t       profile[I2C_MAX_SPEED_PROFILES];
+    uint8_t                   numProfiles;
+    I2C_TRANSFER_t           *qHead[I2C_NUM_PRIO];  // Priority queues, see i2cQueueTransfer()
+    I2C_TRANSFER_t           *qTail[I2C_NUM_PRIO];
+} I2C_CONTEXT_t;
+
+static I2C_CONTEXT_t i2cContext[3];
+
+/**
+ * DMA1 request mapping of the STM32F401 (RM0368, table 28). Alternatives: I2C1_RX Stream5,
+ * I2C1_TX Stream7, I2C2_RX Stream3. I2C1_TX uses Stream6 because Stream7 is needed by I2C2_TX.
+ * I2C3_TX has no alternative and shares Stream4 with SPI2_TX (channel 0, see spiDmaMap in
+ * mcalSPI.c): a segment whose stream is enabled for another channel is sent by the CPU.
+ */
+typedef struct
+{
+    DMA_Stream_TypeDef *rxStream;
+    DMAC_CHANNEL_t      rxChn;
+    IRQn_Type           rxIRQn;
+    DMA_Stream_TypeDef *txStream;
+    DMAC_CHANNEL_t      txChn;
+    uint32_t            rxTcFlag;       // Flags of the RX stream in DMA1->LISR
+    uint32_t            rxTeFlag;
+} I2C_DMA_MAP_t;
+
+static const I2C_DMA_MAP_t i2cDmaMap[3] =
+{
+    { DMA1_Stream0, DMA_CHN_1, DMA1_Stream0_IRQn, DMA1_Stream6, DMA_CHN_1, DMA_LISR_TCIF0, DMA_LISR_TEIF0 },   // I2C1
+    { DMA1_Stream2, DMA_CHN_7, DMA1_Stream2_IRQn, DMA1_Stream7, DMA_CHN_7, DMA_LISR_TCIF2, DMA_LISR_TEIF2 },   // I2C2
+    { DMA1_Stream1, DMA_CHN_1, DMA1_Stream1_IRQn, DMA1_Stream4, DMA_CHN_3, DMA_LISR_TCIF1, DMA_LISR_TEIF1 }    // I2C3, TX shared with SPI2
+};
+
+static I2C_CONTEXT_t *i2cGetContext(I2C_TypeDef *i2c)
+{
+    if (I2C1 == i2c)
+    {
+        return &i2cContext[0];
+    }
+    else if (I2C2 == i2c)
+    {
+        return &i2cContext[1];
+    }
+    else if (I2C3 == i2c)
+    {
+        return &i2cContext[2];
+    }
+    return NULL;
+}
+
+/*
+ * Handler mode: no busy waiting and no bus recovery in interrupt context
+ */
+static inline bool i2cInIsr(void)
+{
+    return (0 != __get_IPSR());
+}
+
+/*
+ * Interrupt context: waits at most I2C_ISR_STOP_WAIT_US for the STOP of the previous transfer,
+ * which the completion interrupt has just requested. false if a recovery is pending or the bus
+ * is still busy: the caller leaves the transfer queued for i2cCheckTimeout().
+ */
+static bool i2cIsrWaitIdle(I2C_TypeDef *i2c, I2C_CONTEXT_t *ctx)
+{
+    uint32_t t0 = DWT->CYCCNT;
+
+    while (!ctx->recover && ((i2c->CR1 & I2C_CR1_STOP) || (i2c->SR2 & I2C_SR2_BUSY)))
+    {
+        if ((DWT->CYCCNT - t0) >= (i2cCyclesPerUs * I2C_ISR_STOP_WAIT_US))
+        {
+            return false;
+        }
+    }
+    return !ctx->recover;
+}
+
+static void i2cEnableIRQ(I2C_TypeDef *i2c);
+static I2C_RETURN_CODE_t i2cStartTransfer(I2C_TypeDef *i2c, I2C_CONTEXT_t *ctx, I2C_TRANSFER_t *xfer);
+static I2C_RETURN_CODE_t i2cResetBus(I2C_TypeDef *i2c, I2C_CONTEXT_t *ctx);
+static void i2cDispatch(I2C_TypeDef *i2c, I2C_CONTEXT_t *ctx);
+static void i2cDmaRxHandler(I2C_TypeDef *i2c, I2C_CONTEXT_t *ctx, uint32_t isr, uint32_t tcFlag, uint32_t teFlag);
+static I2C_RETURN_CODE_t i2cTransferBlocking(I2C_TypeDef *i2c, uint8_t saddr, const uint8_t *txBuf, uint16_t txLen,
+                                             uint8_t *rxBuf, uint16_t rxLen, bool useDma);
+
 
 /**
  * @ingroup iic2
@@ -176,58 +338,291 @@ I2C_RETURN_CODE_t i2cDeselectI2C(I2C_TypeDef *i2c)
 
 
 /**
- * Function to set the I2C clock frequency.
+ * Computes CCR (incl. FS and DUTY) and TRISE for the requested SCL rate from PCLK1.
+ *
+ * Standard mode (<= 100 kHz): Thigh = Tlow = CCR * Tpclk, max. rise time 1000 ns
+ * Fast mode                 : Thigh + Tlow = 3 * CCR * Tpclk (DUTY = 0) or 25 * CCR * Tpclk (DUTY = 1),
+ *                             max. rise time 300 ns (120 ns above 400 kHz)
+ * CCR is rounded up, so the resulting SCL rate never exceeds the requested one. In fast mode the
+ * duty cycle which comes closer to the requested rate is used, on equal rates the preferred one.
+ */
+static I2C_RETURN_CODE_t i2cCalcTiming(uint32_t hz, I2C_DUTY_CYCLE_t duty, uint16_t *ccr, uint16_t *trise)
+{
+    uint32_t pclk    = rccGetPclk1Freq();
+    uint32_t freqMHz = pclk / 1000000;
+    uint32_t ccr2, ccr169, val;
+
+    if ((hz < I2C_SCL_MIN_HZ) || (hz > I2C_SCL_MAX_HZ))
+    {
+        return I2C_INVALID_CLOCK_SPEED;
+    }
+    if ((freqMHz < 2) || (freqMHz > 50) || ((hz > 100000) && (freqMHz < 4)))
+    {
+        return I2C_INVALID_PERIPHERAL_CLOCK;
+    }
+
+    if (hz <= 100000)
+    {
+        val = (pclk + 2 * hz - 1) / (2 * hz);
+        if (val < 4)
+        {
+            val = 4;                        // Min. value in standard mode
+        }
+        *ccr   = (uint16_t) val;
+        *trise = (uint16_t) (freqMHz + 1);
+    }
+    else
+    {
+        ccr2   = (pclk +  3 * hz - 1) / ( 3 * hz);
+        ccr169 = (pclk + 25 * hz - 1) / (25 * hz);
+        if ((3 * ccr2 < 25 * ccr169) || ((3 * ccr2 == 25 * ccr169) && (I2C_DUTY_CYCLE_2 == duty)))
+        {
+            val  = ccr2;
+            *ccr = (uint16_t) (I2C_CCR_FS | val);
+        }
+        else
+        {
+            val  = ccr169;
+            *ccr = (uint16_t) (I2C_CCR_FS | I2C_CCR_DUTY | val);
+        }
+        *trise = (uint16_t) (((hz > 400000) ? (freqMHz * 120) : (freqMHz * 300)) / 1000 + 1);
+    }
+    if ((val > I2C_CCR_CCR_Msk) || (*trise > I2C_TRISE_TRISE_Msk))
+    {
+        return I2C_INVALID_CLOCK_SPEED;
+    }
+    return I2C_OK;
+}
+
+/**
+ * Writes CCR and TRISE. Both registers may only be changed while the component is disabled,
+ * so the bus must be idle. Nothing is done if the timing is already set.
+ */
+static void i2cApplyTiming(I2C_TypeDef *i2c, uint16_t ccr, uint16_t trise)
+{
+    if ((i2c->CCR == ccr) && (i2c->TRISE == trise) && (i2c->CR1 & I2C_CR1_PE))
+    {
+        return;
+    }
+    i2c->CR1  &= ~I2C_CR1_PE_Msk;
+    i2c->CCR   = ccr;
+    i2c->TRISE = trise;
+    i2c->CR1  |= I2C_CR1_PE;
+}
+
+/**
+ * @ingroup iic2
+ * Sets the default SCL rate of the I2C component. CCR, FS, DUTY and TRISE are derived from PCLK1.
+ *
+ * @param  *i2c : Pointer to the I2C component
+ * @param   hz  : SCL rate in Hz, I2C_SCL_MIN_HZ ... I2C_SCL_MAX_HZ
+ *
+ * @return I2C_OK, I2C_INVALID_CLOCK_SPEED or I2C_INVALID_PERIPHERAL_CLOCK
+ *
+ * @note
+ * The default rate is used for all slaves without speed profile, see i2cSetSlaveSpeed().
+ * Must not be called while an asynchronous transfer is active.
+ */
+I2C_RETURN_CODE_t i2cSetSclFreq(I2C_TypeDef *i2c, uint32_t hz)
+{
+    I2C_CONTEXT_t    *ctx = i2cGetContext(i2c);
+    I2C_RETURN_CODE_t rc;
+    uint16_t          ccr, trise;
+
+    if (NULL == ctx)
+    {
+        return I2C_INVALID_TYPE;
+    }
+    rc = i2cCalcTiming(hz, ctx->duty, &ccr, &trise);
+    if (I2C_OK != rc)
+    {
+        return rc;
+    }
+    ctx->defHz    = hz;
+    ctx->defCcr   = ccr;
+    ctx->defTrise = trise;
+
+    I2C_WAIT_BUSY(i2c);
+    i2c->CR2 = (i2c->CR2 & ~I2C_CR2_FREQ_Msk) | (rccGetPclk1Freq() / 1000000);
+    i2cApplyTiming(i2c, ccr, trise);
+
+    return I2C_OK;
+}
+
+/**
+ * @ingroup iic2
+ * Sets the default SCL rate of the I2C component, see i2cSetSclFreq().
+ *
+ * @param  *i2c : Pointer to the I2C component
+ * @param   spd : I2C_CLOCK_50 ... I2C_CLOCK_1Mz
  */
 I2C_RETURN_CODE_t i2cSetClkSpd(I2C_TypeDef *i2c, I2C_CLOCKSPEED_t spd)
 {
-    if ( (I2C_CLOCK_50 == spd) || (I2C_CLOCK_100 == spd) ||
-    	 (I2C_CLOCK_200 == spd)|| (I2C_CLOCK_400 == spd) || (I2C_CLOCK_1Mz == spd)		)
-    {
-    	I2C_WAIT_BUSY(i2c);
-    	i2c->CCR = 0x00;                    // Reset Clock Control Register
-    	i2c->CCR &= ~I2C_CCR_CCR_Msk;    	// deactive bus clock bits
-    	i2c->CCR &= ~I2C_CCR_FS_Msk;    	// deactive fastMode I2C bus clock
-    	switch (spd)
-    	{
-    		case I2C_CLOCK_50:
-			{
-
-				i2c->CCR |= 0x00A0;				// Select 50 kHz bus clock
-				break;
-			}
-    		case I2C_CLOCK_100:
-    		{
-    			i2c->CCR |= 0x0050;				// Select 100 kHz bus clock
-    			break;
-    		}
-    		case I2C_CLOCK_200:
-    			{
-       				i2c->CCR |= 0x0028;			// Select 200 kHz bus clock
-    				break;
-    			}
-    		case I2C_CLOCK_400:
-    		{
-    			//i2c->CCR |= I2C_CCR_FS; 	    // fast Mode
-    			i2c->CCR |= 0x0014;				// Select 400 kHz bus clock
-    			break;
-    		}
-    		case I2C_CLOCK_1Mz:
-			{
-				i2c->CCR |= I2C_CCR_FS; 	    // fast Mode
-				i2c->CCR |= 0x005;				// Select 800 kHz bus clock
-				break;
-			}
-    		default:
-    		{
-    			i2c->CCR &= ~I2C_CCR_FS_Msk;    // Select 100 kHz bus clock
-    			i2c->CCR |= 0x0050;
-    			break;
-    		}
-    	}
-    	 i2c->CR1 |= I2C_CR1_PE;            // Re-renable I2C component
-    	return I2C_OK;
-    }
-    return I2C_INVALID_CLOCK_SPEED;
+    static const uint32_t sclHz[] = { 50000, 100000, 200000, 400000, 1000000 };
+
+    if ((uint32_t) spd >= sizeof(sclHz) / sizeof(sclHz[0]))
+    {
+        return I2C_INVALID_CLOCK_SPEED;
+    }
+    return i2cSetSclFreq(i2c, sclHz[spd]);
+}
+
+/**
+ * @ingroup iic2
+ * Sets the speed profile of a slave. The asynchronous engine switches to this SCL rate before
+ * each transfer addressing the slave and back to the default rate for slaves w/o profile.
+ *
+ * @param  *i2c   : Pointer to the I2C component
+ * @param   saddr : 7Bit slave address
+ * @param   hz    : SCL rate of the slave in Hz, 0 removes the profile
+ *
+ * @return I2C_OK, I2C_PROFILE_FULL if I2C_MAX_SPEED_PROFILES profiles are in use, or the error of i2cSetSclFreq()
+ *
+ * @note
+ * A transfer with segments to several slaves runs with the lowest rate of these slaves,
+ * because the clock can not be changed during a repeated START.
+ */
+I2C_RETURN_CODE_t i2cSetSlaveSpeed(I2C_TypeDef *i2c, uint8_t saddr, uint32_t hz)
+{
+    I2C_CONTEXT_t    *ctx = i2cGetContext(i2c);
+    I2C_RETURN_CODE_t rc;
+    uint16_t          ccr = 0, trise = 0;
+    uint8_t           i;
+
+    if (NULL == ctx)
+    {
+        return I2C_INVALID_TYPE;
+    }
+    if (hz > 0)
+    {
+        rc = i2cCalcTiming(hz, ctx->duty, &ccr, &trise);
+        if (I2C_OK != rc)
+        {
+            return rc;
+        }
+    }
+
+    for (i = 0; (i < ctx->numProfiles) && (ctx->profile[i].saddr != saddr); i++)
+    {
+        ;
+    }
+    if (0 == hz)
+    {
+        if (i < ctx->numProfiles)
+        {
+            ctx->profile[i] = ctx->profile[--ctx->numProfiles];
+        }
+        return I2C_OK;
+    }
+    if (i >= I2C_MAX_SPEED_PROFILES)
+    {
+        return I2C_PROFILE_FULL;
+    }
+    ctx->profile[i].saddr = saddr;
+    ctx->profile[i].hz    = hz;
+    ctx->profile[i].ccr   = ccr;
+    ctx->profile[i].trise = trise;
+    if (i == ctx->numProfiles)
+    {
+        ctx->numProfiles++;
+    }
+    return I2C_OK;
+}
+
+/**
+ * Selects the timing of the active transfer: the lowest rate of all addressed slaves.
+ */
+static void i2cSelectTiming(I2C_TypeDef *i2c, I2C_CONTEXT_t *ctx)
+{
+    uint32_t hz    = 0xFFFFFFFFUL;
+    uint16_t ccr   = ctx->defCcr;
+    uint16_t trise = ctx->defTrise;
+    uint8_t  s, p;
+
+    if ((0 == ctx->numProfiles) || (0 == ctx->defCcr))
+    {
+        return;                             // No profiles or clock set by the deprecated functions
+    }
+    for (s = 0; s < ctx->segCount; s++)
+    {
+        for (p = 0; (p < ctx->numProfiles) && (ctx->profile[p].saddr != ctx->seg[s].saddr); p++)
+        {
+            ;
+        }
+        if ((p < ctx->numProfiles) && (ctx->profile[p].hz < hz))
+        {
+            hz    = ctx->profile[p].hz;
+            ccr   = ctx->profile[p].ccr;
+            trise = ctx->profile[p].trise;
+        }
+        else if ((p >= ctx->numProfiles) && (ctx->defHz < hz))
+        {
+            hz    = ctx->defHz;
+            ccr   = ctx->defCcr;
+            trise = ctx->defTrise;
+        }
+    }
+    i2cApplyTiming(i2c, ccr, trise);
+}
+
+/**
+ * @ingroup iic2
+ * Returns the SCL frequency in Hz resulting from the current CCR setting and PCLK1.
+ *
+ * @param  *i2c : Pointer to the I2C component
+ */
+uint32_t i2cGetSclFreq(I2C_TypeDef *i2c)
+{
+    uint32_t pclk = rccGetPclk1Freq();
+    uint32_t ccr  = i2c->CCR & I2C_CCR_CCR_Msk;
+
+    if (0 == ccr)
+    {
+        return 0;
+    }
+    if (!(i2c->CCR & I2C_CCR_FS))
+    {
+        return pclk / (2 * ccr);            // Standard mode: Thigh = Tlow = CCR * Tpclk
+    }
+    if (i2c->CCR & I2C_CCR_DUTY)
+    {
+        return pclk / (25 * ccr);           // Fast mode, Tlow/Thigh = 16/9
+    }
+    return pclk / (3 * ccr);                // Fast mode, Tlow/Thigh = 2
+}
+
+/**
+ * @ingroup iic2
+ * Returns the SCL rate in Hz which the asynchronous engine uses for the slave: the rate of its
+ * speed profile, otherwise the default rate of i2cSetSclFreq().
+ *
+ * @param  *i2c   : Pointer to the I2C component
+ * @param   saddr : 7Bit slave address
+ *
+ * @note
+ * Without i2cSetSclFreq() (clock set by the deprecated functions) the rate of the current CCR is returned.
+ */
+uint32_t i2cGetSlaveSpeed(I2C_TypeDef *i2c, uint8_t saddr)
+{
+    I2C_CONTEXT_t *ctx = i2cGetContext(i2c);
+    uint8_t        p;
+
+    if (NULL == ctx)
+    {
+        return 0;
+    }
+    if (0 == ctx->defCcr)
+    {
+        return i2cGetSclFreq(i2c);
+    }
+    for (p = 0; p < ctx->numProfiles; p++)
+    {
+        if (ctx->profile[p].saddr == saddr)
+        {
+            return ctx->profile[p].hz;
+        }
+    }
+    return ctx->defHz;
 }
 
 I2C_RETURN_CODE_t i2cInitI2C(I2C_TypeDef *i2c, I2C_DUTY_CYCLE_t duty, uint8_t trise, I2C_CLOCKSPEED_t clock)
@@ -242,18 +637,31 @@ I2C_RETURN_CODE_t i2cInitI2C(I2C_TypeDef *i2c, I2C_DUTY_CYCLE_t duty, uint8_t tr
     i2c->CR1 = 0x0000;                  // Reset old CR1 settings
     i2c->CR1 &= ~I2C_CR1_PE_Msk;        // Disable I2C component
 
+    i2cCyclesPerUs = rccGetHclkFreq() / 1000000;
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;     // DWT cycle counter is used for all timeouts
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#if I2C_TRACE_ENABLE
+    i2cTraceSetClock();                 // Cycles per us of the trace timestamps, recording stays as it is
+#endif
+
     pclock = rccGetPclk1Freq();
     i2c->CR2 = pclock / 1000000;		//
 
-    i2c->TRISE = trise;                // Set max. rise time
+    i2c->TRISE = trise;                // Overwritten by i2cSetClkSpd(), which derives TRISE from PCLK1
 
     i2c->OAR1 |= (0x00 << 1);			 // set own address to 00 - not really used in master mode
     i2c->OAR1 |= (1 << 14); 			// bit 14 should be kept at 1 according to the datasheet
 
+    if (NULL != i2cGetContext(i2c))
+    {
+        i2cGetContext(i2c)->duty = duty;    // Preferred duty cycle for fast mode
+    }
     i2cSetClkSpd(i2c, clock);			// set I2C Clockrate
 
     //i2c->CR1 |= I2C_CR1_PE;            // Re-renable I2C component
 
+    i2cEnableIRQ(i2c);                  // Event and error IRQs are used by i2cSubmitTransfer()
+
     i2cFindSlaveAddr(i2c, 1);			// first run find routine for Adr 0, work arround for result failure at first search run
 
 
@@ -271,7 +679,7 @@ I2C_RETURN_CODE_t i2cInitI2C(I2C_TypeDef *i2c, I2C_DUTY_CYCLE_t duty, uint8_t tr
  * @return I2C_RETURN_CODE_t
  *
  * @note
- * Failure handling is not yet implemented. This function shall be used
+ * Blocking wrapper of i2cSubmitTransfer(). This function shall be used
  * in the case when the desired I2C component provides only one internal
  * register.
  *
@@ -281,27 +689,7 @@ I2C_RETURN_CODE_t i2cInitI2C(I2C_TypeDef *i2c, I2C_DUTY_CYCLE_t duty, uint8_t tr
  */
 I2C_RETURN_CODE_t i2cSendByte(I2C_TypeDef *i2c, uint8_t saddr, uint8_t data)
 {
-
-
-	I2C_WAIT_BUSY(i2c);                 // Checks whether the I2C bus is busy
-
-	 __i2c_start(i2c);		         // Send I2C START signal
-    I2C_START_COMPLETED(i2c);           // Wait until START signal has been sent
-
-
-    i2c->DR = saddr<<1;                 // Send 7Bit slave address
-    I2C_ADDRESS_COMPLETED(i2c);         // Wait for ADDR ACK
-
-    __i2c_dummy_read_SR1_SR2(i2c);		// Reset SR1 & SR2
-    __i2c_Chk_TX_empty(i2c);         // Wait until the transmit buffer is empty
-
-    i2c->DR = data;                     // Send data
-
-    I2C_BYTE_TRANSFER_FINISHED(i2c);    // Wait until BTF Flag is set
-    __i2c_dummy_read_SR1_SR2(i2c);		// Reset SR1 & SR2
-
-    __i2c_stop(i2c);			       // Send STOP signal
-    return I2C_OK;
+    return i2cTransferBlocking(i2c, saddr, &data, 1, NULL, 0, false);
 }
 
 /**
@@ -316,7 +704,7 @@ I2C_RETURN_CODE_t i2cSendByte(I2C_TypeDef *i2c, uint8_t saddr, uint8_t data)
  * @return I2C_RETURN_CODE_t
  *
  * @note
- * Failure handling is not yet implemented
+ * Blocking wrapper of i2cSubmitTransfer()
  *
  * <br>
  * <b>Affected register and bit(s)</b><br>
@@ -324,29 +712,9 @@ I2C_RETURN_CODE_t i2cSendByte(I2C_TypeDef *i2c, uint8_t saddr, uint8_t data)
  */
 I2C_RETURN_CODE_t i2cSendByteToSlaveReg(I2C_TypeDef *i2c, uint8_t saddr, uint8_t regAddr, uint8_t data)
 {
-    I2C_WAIT_BUSY(i2c);                 // Checks whether the I2C bus is busy
-
-    __i2c_start(i2c);					 // send start condition
-    I2C_START_COMPLETED(i2c);           // Wait until START signal has been sent
+    uint8_t txBuf[2] = { regAddr, data };
 
-    i2c->DR = saddr<<1;                    // Send slave 7Bit address
-    I2C_ADDRESS_COMPLETED(i2c);         // Wait for ADDR ACK
-
-    __i2c_dummy_read_SR1_SR2(i2c);		// Reset SR1 & SR2
-    __i2c_Chk_TX_empty(i2c);         // Wait until the transmit buffer is empty
-
-    i2c->DR = regAddr;                  // Set the address of the slave register
-    __i2c_Chk_TX_empty(i2c);         // Wait until the transmit buffer is empty
-
-    __i2c_dummy_read_SR1_SR2(i2c);		// Reset SR1 & SR2
-    i2c->DR = data;                     // Send data
-    I2C_BYTE_TRANSFER_FINISHED(i2c);    // Wait until BTF Flag is set
-
-    __i2c_dummy_read_SR1_SR2(i2c);		// Reset SR1 & SR2
-      __i2c_stop(i2c);					  // send stop condition
-
-
-    return I2C_OK;
+    return i2cTransferBlocking(i2c, saddr, txBuf, 2, NULL, 0, false);
 }
 
 /**
@@ -355,44 +723,18 @@ I2C_RETURN_CODE_t i2cSendByteToSlaveReg(I2C_TypeDef *i2c, uint8_t saddr, uint8_t
  *
  * @param  *i2c     : Pointer to the component
  * @param   saddr   : Address of the I2C slave 7Bit
- * @param   regAddr : Address of the slave register
- * @param   data    : Byte that shall be sent
+ * @param   data    : Bytes that shall be sent (usually starting with the register address)
  * @param   len     : Number of data elements to be sent
  *
  * @return I2C_RETURN_CODE_t
  *
  * @note
- * Failure handling is not yet implemented
+ * Blocking wrapper of i2cSubmitTransfer()
  *
 */
 I2C_RETURN_CODE_t i2cBurstWrite(I2C_TypeDef *i2c, uint8_t saddr, uint8_t *data, uint8_t len)
 {
-    uint8_t numBytes = 0;
-
-    I2C_WAIT_BUSY(i2c);                 // Check whether the I2C bus is busy
-    I2C_RESET_POS(i2c);                 // May only be active in 16-bit mode
-    __i2c_start(i2c);					 // send start condition
-
-    I2C_START_COMPLETED(i2c);           // Wait until START signal has been sent
-
-    i2c->DR = saddr<<1;                 // Send 7Bit slave address
-    I2C_ADDRESS_COMPLETED(i2c);         // Wait for ADDR ACK
-
-    while (numBytes < len)
-    {
-        __i2c_Chk_TX_empty(i2c);
-        __i2c_dummy_read_SR1_SR2(i2c);		// Reset SR1 & SR2
-        i2c->DR = *data++;
-        I2C_BYTE_TRANSFER_FINISHED(i2c);   // Wait until BTF Flag is set
-
-        numBytes++;
-    }
-
-    I2C_BYTE_TRANSFER_FINISHED(i2c);   // Wait until BTF Flag is set
-    __i2c_dummy_read_SR1_SR2(i2c);		// Reset SR1 & SR2
-    __i2c_stop(i2c);					  // send stop condition
-
-    return I2C_OK;
+    return i2cTransferBlocking(i2c, saddr, data, len, NULL, 0, false);
 }
 
 
@@ -407,7 +749,7 @@ I2C_RETURN_CODE_t i2cBurstWrite(I2C_TypeDef *i2c, uint8_t saddr, uint8_t *data,
  * @return I2C_RETURN_CODE_t
  *
  * @note
- * Failure handling is not yet implemented.
+ * Blocking wrapper of i2cSubmitTransfer()
  *
  * <br>
  * <b>Affected register and bit(s)</b><br>
@@ -415,24 +757,7 @@ I2C_RETURN_CODE_t i2cBurstWrite(I2C_TypeDef *i2c, uint8_t saddr, uint8_t *data,
  */
 I2C_RETURN_CODE_t i2cReadByte(I2C_TypeDef *i2c, uint8_t saddr, uint8_t *data)
 {
-    I2C_WAIT_BUSY(i2c);                 // Checks whether the I2C bus is busy
-
-    __i2c_start(i2c);					 // send start condition
-    I2C_START_COMPLETED(i2c);           // Wait until START signal has been sent
-
-    __i2c_dummy_read_SR1_SR2(i2c);		// Reset SR1 & SR2
-    i2c->DR = (saddr<<1) | 1;           // Resend 7 Bit slave addr with bit 0 = '1'
-    I2C_ADDRESS_COMPLETED(i2c);         // Wait for ADDR ACK
-
-    I2C_RESET_ACK(i2c);                 // Disable Acknowledge
-    __i2c_dummy_read_SR1_SR2(i2c);		// Reset SR1 & SR2
-    I2C_CHECK_RXBUF_NOT_EMPTY(i2c);     // Wait until receive buffer is no longer empty
-
-    *data = (uint8_t) (i2c->DR);                    // Write data in variable
-
-
-    __i2c_stop(i2c);
-    return I2C_OK;
+    return i2cTransferBlocking(i2c, saddr, NULL, 0, data, 1, false);
 }
 
 /**
@@ -447,9 +772,8 @@ I2C_RETURN_CODE_t i2cReadByte(I2C_TypeDef *i2c, uint8_t saddr, uint8_t *data)
  * @return I2C_RETURN_CODE_t
  *
  * @note
- * Failure handling is not yet implemented. This function shall be used
- * in the case when the addresses I2C component provides only one internal
- * register.
+ * Blocking wrapper of i2cSubmitTransfer(). The register address is sent
+ * first, the data byte is read after a repeated START.
  *
  * <br>
  * <b>Affected register and bit(s)</b><br>
@@ -457,35 +781,7 @@ I2C_RETURN_CODE_t i2cReadByte(I2C_TypeDef *i2c, uint8_t saddr, uint8_t *data)
  */
 I2C_RETURN_CODE_t i2cReadByteFromSlaveReg(I2C_TypeDef *i2c, uint8_t saddr, uint8_t regAddr, uint8_t *data)
 {
-    I2C_WAIT_BUSY(i2c);                 // Checks whether the I2C bus is busy
-
-    __i2c_start(i2c);					 // send start condition
-    I2C_START_COMPLETED(i2c);           // Wait until START signal has been sent
-
-    i2c->DR = saddr<<1;                    // Send with bit 0 = '0'
-    I2C_ADDRESS_COMPLETED(i2c);         // Wait for ADDR ACK
-
-    __i2c_dummy_read_SR1_SR2(i2c);		// Reset SR1 & SR2
-
-    i2c->DR = regAddr;                  // Send address of the functional register
-    __i2c_Chk_TX_empty(i2c);         	// Wait until transmit buffer is empty
-
-    __i2c_dummy_read_SR1_SR2(i2c);		// Reset SR1 & SR2
-    i2c->CR1 |= I2C_CR1_START;          // Generate I2C RESTART
-    I2C_START_COMPLETED(i2c);           // Checks whether the START signal has been sent
-
-    i2c->DR = (saddr<<1) | 1;           // Resend slave addr with bit 0 = '1'
-    I2C_ADDRESS_COMPLETED(i2c);         // Wait for ADDR ACK
-
-    I2C_RESET_ACK(i2c);                 // Disable Acknowledge
-
-    __i2c_dummy_read_SR1_SR2(i2c);		// Reset SR1 & SR2
-    __i2c_stop(i2c);
-
-    I2C_CHECK_RXBUF_NOT_EMPTY(i2c);     // Wait until receive buffer is no longer empty
-    *data++ = i2c->DR;                  // Write data in variable
-
-    return I2C_OK;
+    return i2cTransferBlocking(i2c, saddr, &regAddr, 1, data, 1, false);
 }
 
 /**
@@ -501,7 +797,7 @@ I2C_RETURN_CODE_t i2cReadByteFromSlaveReg(I2C_TypeDef *i2c, uint8_t saddr, uint8
  * @return I2C_RETURN_CODE_t
  *
  * @note
- * Failure handling is not yet implemented
+ * Blocking wrapper of i2cSubmitTransfer()
  *
  * <br>
  * <b>Affected register and bit(s)</b><br>
@@ -509,89 +805,46 @@ I2C_RETURN_CODE_t i2cReadByteFromSlaveReg(I2C_TypeDef *i2c, uint8_t saddr, uint8
  */
 I2C_RETURN_CODE_t i2cBurstRegRead(I2C_TypeDef *i2c, uint8_t saddr, uint8_t regAddr, uint8_t *data, uint8_t num)
 {
-	I2C_WAIT_BUSY(i2c);
-    //I2C_RESET_POS(i2c);                     // Must be used only in 16-bit transfer
-
-    __i2c_start(i2c);					 // send start condition
-    I2C_START_COMPLETED(i2c);           // Wait until START signal has been sent
+    return i2cTransferBlocking(i2c, saddr, &regAddr, 1, data, num, false);
+}
 
-    i2c->DR = saddr<<1;                        // Send with bit 0 = '0'
-    I2C_ADDRESS_COMPLETED(i2c);             // Wait for ADDR ACK
+/**
+ * @ingroup iic3
+ * Burst read from I2C slave w/o sending a register address first.
+ *
+ * @note
+ * Blocking wrapper of i2cSubmitTransfer()
+ */
+I2C_RETURN_CODE_t i2cBurstRead(I2C_TypeDef *i2c, uint8_t saddr, uint8_t *data, uint8_t num)
+{
+    return i2cTransferBlocking(i2c, saddr, NULL, 0, data, num, false);
+}
 
-    __i2c_dummy_read_SR1_SR2(i2c);		// Reset SR1 & SR2
-
-    i2c->DR = regAddr;                      // Send address of the functional register
-
-    __i2c_Chk_TX_empty(i2c);             // Wait until transmit buffer is empty
-    I2C_BYTE_TRANSFER_FINISHED(i2c);
-    __i2c_dummy_read_SR1_SR2(i2c);
-    i2c->CR1 |= I2C_CR1_START;          // Generate I2C RESTART
-    I2C_START_COMPLETED(i2c);           // Checks whether the START signal has been sent
-    i2c->DR = (saddr<<1) | 1;               // Resend 7Bit slave addr with bit 0 = '1'
-    I2C_ADDRESS_COMPLETED(i2c);             // Wait for ADDR ACK
-
-    I2C_SET_ACK(i2c);                       // Enable Acknowledge
-
-    while (num > 0)                          // Start reading multiple values
-    {
-        if (num == 1U)                      // If there is only one byte left...
-        {
-            I2C_RESET_ACK(i2c);             // Disable acknowledge
-            __i2c_dummy_read_SR1_SR2(i2c);		// Reset SR1 & SR2
-            I2C_CHECK_RXBUF_NOT_EMPTY(i2c); // Wait until receive buffer is no longer empty
-
-            *data++ = i2c->DR;              // Read data from data register
-            break;
-        }
-        else                                // More than one byte left
-        {
-        	__i2c_dummy_read_SR1_SR2(i2c);
-        	I2C_CHECK_RXBUF_NOT_EMPTY(i2c); // Wait until receive buffer is no longer empty
-            (*data++) = i2c->DR;            // Read data from data register
-            num--;
-        }
-    }
-    __i2c_dummy_read_SR1_SR2(i2c);
-    //I2C_BYTE_TRANSFER_FINISHED(i2c);
-    __i2c_stop(i2c);
-
-    return I2C_OK;
-}
-
-I2C_RETURN_CODE_t i2cBurstRead(I2C_TypeDef *i2c, uint8_t saddr, uint8_t *data, uint8_t num)
+/**
+ * @ingroup iic3
+ * Sends a command buffer and reads the response after a repeated START, the bus is not
+ * released in between (no STOP, no bus free time).
+ *
+ * @param  *i2c   : Pointer to the I2C component
+ * @param   saddr : Address of the I2C slave
+ * @param  *wbuf  : Command bytes, e.g. command code followed by parameters
+ * @param   wlen  : Number of command bytes (>= 1)
+ * @param  *rbuf  : Address where the response shall be stored
+ * @param   rlen  : Number of response bytes (>= 1)
+ *
+ * @return I2C_RETURN_CODE_t
+ *
+ * @note
+ * Blocking wrapper of i2cSubmitTransfer(). i2cBurstRegRead() is the special case wlen = 1.
+ */
+I2C_RETURN_CODE_t i2cWriteRead(I2C_TypeDef *i2c, uint8_t saddr, const uint8_t *wbuf, uint16_t wlen,
+                               uint8_t *rbuf, uint16_t rlen)
 {
-	I2C_WAIT_BUSY(i2c);
-    I2C_RESET_POS(i2c);                     // Must be used only in 16-bit transfer
-
-    __i2c_start(i2c);					 // send start condition
-
-    i2c->DR = (saddr<<1) | 1;               // Resend 7Bit slave addr with bit 0 = '1'
-    I2C_ADDRESS_COMPLETED(i2c);             // Wait for ADDR ACK
-
-    __i2c_dummy_read_SR1_SR2(i2c);		// Reset SR1 & SR2
-
-    I2C_SET_ACK(i2c);                       // Enable Acknowledge
-
-    while (num > 0)                          // Start reading multiple values
+    if ((0 == wlen) || (0 == rlen))
     {
-        if (num == 1U)                      // If there is only one byte left...
-        {
-            I2C_RESET_ACK(i2c);             // Disable acknowledge
-            __i2c_dummy_read_SR1_SR2(i2c);		// Reset SR1 & SR2
-            __i2c_stop(i2c);
-            I2C_CHECK_RXBUF_NOT_EMPTY(i2c); // Wait until receive buffer is no longer empty
-            *data++ = i2c->DR;              // Read data from data register
-            break;
-        }
-        else                                // More than one byte left
-        {
-            I2C_CHECK_RXBUF_NOT_EMPTY(i2c); // Wait until receive buffer is no longer empty
-            (*data++) = i2c->DR;            // Read data from data register
-            num--;
-        }
+        return I2C_INVALID_TRANSFER;
     }
-
-    return I2C_OK;
+    return i2cTransferBlocking(i2c, saddr, wbuf, wlen, rbuf, rlen, false);
 }
 
 /**
@@ -705,6 +958,10 @@ I2C_RETURN_CODE_t i2cSetPeripheralClockFreq(I2C_TypeDef *i2c, uint8_t pclk)
  */
 I2C_RETURN_CODE_t i2cSetDutyCycle(I2C_TypeDef *i2c, I2C_DUTY_CYCLE_t duty)
 {
+    if (NULL != i2cGetContext(i2c))
+    {
+        i2cGetContext(i2c)->duty = duty;    // Preferred duty cycle of i2cSetSclFreq()
+    }
     i2c->CCR &= ~I2C_CCR_DUTY_Msk;
     i2c->CCR |= duty << I2C_CCR_DUTY_Pos;
 
@@ -748,9 +1005,51 @@ I2C_RETURN_CODE_t i2cSetRiseTime(I2C_TypeDef *i2c, uint8_t riseTime)
     return I2C_OK;
 }
 
+/**
+ * Addresses the slave for writing and stops immediately. The slave is present if the address
+ * was acknowledged (ADDR), a missing slave is detected by the acknowledge failure flag (AF).
+ */
+static bool i2cProbe(I2C_TypeDef *i2c, uint8_t saddr)
+{
+    bool ack = false;
+#if I2C_TRACE_ENABLE
+    uint32_t t0 = DWT->CYCCNT;
+#endif
+
+    if (!__i2c_start(i2c))
+    {
+        i2c->CR1 |= I2C_CR1_STOP;
+        return false;
+    }
+    i2c->DR = saddr << 1;
+    if (I2C_WAIT_FOR(i2c->SR1 & (I2C_SR1_ADDR | I2C_SR1_AF)))
+    {
+        if (i2c->SR1 & I2C_SR1_ADDR)
+        {
+            I2C_DUMMY_READ_SR2(i2c);        // Clears ADDR
+            ack = true;
+        }
+        else
+        {
+            i2c->SR1 = ~I2C_SR1_AF & 0xFFFF;
+        }
+    }
+    i2c->CR1 |= I2C_CR1_STOP;
+    I2C_STOPP_COMPLETED(i2c);
+
+#if I2C_TRACE_ENABLE
+    // A probe is a zero length write: it occupies the bus like any other transaction
+    I2C_SEGMENT_t seg = { saddr, I2C_SEG_WRITE, I2C_SEG_DEFAULT, 0, NULL };
+    i2cTraceTransfer(i2c, &seg, 1, ack ? I2C_OK : I2C_NACK, t0, DWT->CYCCNT);
+#endif
+
+    return ack;
+}
+
 /**
  * @ingroup iic2
  * Searches I2C peripheral components and returns their I2C address. It returns 0 if the desired address is free.
+ * The probe claims the bus like i2cScanBus(): it returns 0 as well if an asynchronous transfer is active.
  *
  * @param  *i2c     : Pointer to the I2C component
  * @param   i2cAddr : The I2C address which shall be tested
@@ -772,39 +1071,87 @@ I2C_RETURN_CODE_t i2cSetRiseTime(I2C_TypeDef *i2c, uint8_t riseTime)
  */
 uint8_t i2cFindSlaveAddr(I2C_TypeDef *i2c, uint8_t i2cAddr)
 {
-    uint32_t simpleDelay;
+    uint8_t presence[I2C_SCAN_MAP_SIZE];
 
-    __i2c_start(i2c);
-    /*
-    i2c->CR1 |= I2C_CR1_START;
-    while (!(i2c->SR1 & I2C_SR1_SB))
+    i2cAddr &= 0x7F;
+    if (I2C_OK != i2cScanBus(i2c, &i2cAddr, 1, presence))
     {
-        ;
+        return 0;
     }
-*/
-    i2c->DR = i2cAddr<<1;
-    __i2c_dummy_read_SR1_SR2(i2c);
-    /*
-    while (!(i2c->SR1) | !(i2c->SR2))
+    return I2C_SCAN_PRESENT(presence, i2cAddr) ? i2cAddr : 0;
+}
+
+/**
+ * @ingroup iic3
+ * Probes a set of slave addresses in a single pass and returns a presence bitmap.
+ *
+ * @param  *i2c      : Pointer to the I2C component
+ * @param  *addrList : Addresses to be probed, NULL: all addresses I2C_SCAN_FIRST_ADDR ... I2C_SCAN_LAST_ADDR
+ * @param   numAddr  : Number of entries of addrList
+ * @param  *presence : Bitmap of I2C_SCAN_MAP_SIZE bytes, see I2C_SCAN_PRESENT()
+ *
+ * @return I2C_OK, I2C_BUSY if an asynchronous transfer is active, I2C_BUS_ERROR if the bus hangs
+ *
+ * @note
+ * Each address costs START, address byte and STOP, about 12 SCL clocks. A full scan of the 112
+ * addresses takes about 3.5 ms at 400 kHz. The default SCL rate (i2cSetSclFreq()) is used.
+ */
+I2C_RETURN_CODE_t i2cScanBus(I2C_TypeDef *i2c, const uint8_t *addrList, uint8_t numAddr, uint8_t *presence)
+{
+    I2C_CONTEXT_t    *ctx = i2cGetContext(i2c);
+    I2C_TRANSFER_t    scan = { 0 };     // Only marks the bus as occupied
+    I2C_RETURN_CODE_t rc = I2C_OK;
+    uint32_t          primask;
+    uint8_t           i, addr;
+
+    if ((NULL == ctx) || (NULL == presence))
     {
-        ;
+        return (NULL == ctx) ? I2C_INVALID_TYPE : I2C_INVALID_TRANSFER;
+    }
+    if (NULL == addrList)
+    {
+        numAddr = I2C_SCAN_LAST_ADDR - I2C_SCAN_FIRST_ADDR + 1;
+    }
+    for (i = 0; i < I2C_SCAN_MAP_SIZE; i++)
+    {
+        presence[i] = 0;
     }
-*/
 
-    i2c->CR1 |= I2C_CR1_STOP;
-    for (simpleDelay = 0UL; simpleDelay < 1000UL; simpleDelay++)
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if (NULL != ctx->xfer)
     {
-        ;
+        __set_PRIMASK(primask);
+        return I2C_BUSY;
     }
+    ctx->xfer   = &scan;
+    ctx->t0     = DWT->CYCCNT;
+    ctx->budget = i2cCyclesPerUs * I2C_TIMEOUT_US * (numAddr + 1);
+    __set_PRIMASK(primask);
 
-    if (i2c->SR1 & I2C_SR1_ADDR)
+    if (ctx->recover || !I2C_STOPP_COMPLETED(i2c) || !I2C_WAIT_BUSY(i2c))
     {
-        return i2cAddr;
+        rc = i2cResetBus(i2c, ctx);
     }
-    else
+    if (I2C_OK == rc)
     {
-        return 0;
+        if (0 != ctx->defCcr)
+        {
+            i2cApplyTiming(i2c, ctx->defCcr, ctx->defTrise);
+        }
+        for (i = 0; i < numAddr; i++)
+        {
+            addr = (NULL == addrList) ? (I2C_SCAN_FIRST_ADDR + i) : (addrList[i] & 0x7F);
+            if (i2cProbe(i2c, addr))
+            {
+                presence[addr >> 3] |= 1 << (addr & 0x07);
+            }
+        }
     }
+    ctx->xfer = NULL;
+    i2cDispatch(i2c, ctx);
+
+    return rc;
 }
 
 I2C_RETURN_CODE_t i2cResetDevice(I2C_TypeDef *i2c)
@@ -814,3 +1161,1275 @@ I2C_RETURN_CODE_t i2cResetDevice(I2C_TypeDef *i2c)
 
     return I2C_OK;
 }
+
+
+
+/**
+ * Asynchronous transfer engine
+ *
+ * A transfer is started by i2cSubmitTransfer() and completely processed by the
+ * I2Cx_EV_IRQHandler()/I2Cx_ER_IRQHandler(). The receive part follows the sequences
+ * for N = 1, N = 2 and N > 2 bytes described in the reference manual RM0368.
+ */
+
+static void i2cEnableIRQ(I2C_TypeDef *i2c)
+{
+    if (I2C1 == i2c)
+    {
+        NVIC_EnableIRQ(I2C1_EV_IRQn);
+        NVIC_EnableIRQ(I2C1_ER_IRQn);
+    }
+    else if (I2C2 == i2c)
+    {
+        NVIC_EnableIRQ(I2C2_EV_IRQn);
+        NVIC_EnableIRQ(I2C2_ER_IRQn);
+    }
+    else if (I2C3 == i2c)
+    {
+        NVIC_EnableIRQ(I2C3_EV_IRQn);
+        NVIC_EnableIRQ(I2C3_ER_IRQn);
+    }
+}
+
+static const I2C_DMA_MAP_t *i2cGetDmaMap(I2C_CONTEXT_t *ctx)
+{
+    return &i2cDmaMap[ctx - i2cContext];
+}
+
+/**
+ * false if the stream is enabled for another channel, i.e. used by another peripheral.
+ * Check and programming of the stream must be one critical section (see spiWriteDMA()).
+ */
+static bool i2cDmaStreamFree(DMA_Stream_TypeDef *stream, DMAC_CHANNEL_t chn)
+{
+    return !(stream->CR & DMA_SxCR_EN) || ((stream->CR & DMA_SxCR_CHSEL_Msk) == (chn << DMA_SxCR_CHSEL_Pos));
+}
+
+static void i2cDmaStart(I2C_TypeDef *i2c, DMA_Stream_TypeDef *stream, DMAC_CHANNEL_t chn,
+                        uint32_t mem, uint16_t num, DMAC_DIRECTION_t dir)
+{
+    dmacDisableStream(stream);
+    dmacAssignStreamAndChannel(stream, chn);           // Must be the first setting, it overwrites CR
+    dmacClearAllStreamIrqFlags(DMA1, stream);
+    dmacSetMemoryAddress(stream, MEM_0, mem);
+    dmacSetPeripheralAddress(stream, (uint32_t) &i2c->DR);
+    dmacSetNumData(stream, num);
+    dmacSetDataFlowDirection(stream, dir);
+    dmacSetMemoryIncrementMode(stream, INCR_ENABLE);
+    dmacSetPeripheralIncrementMode(stream, INCR_DISABLE);
+    dmacSetMemoryDataFormat(stream, BYTE);
+    dmacSetPeripheralDataFormat(stream, BYTE);
+    dmacSetPriorityLevel(stream, PRIO_HIGH);
+    if (PER_2_MEM == dir)
+    {
+        dmacEnableInterrupt(stream, TX_COMPLETE);       // End of reception is signalled by the DMA
+        dmacEnableInterrupt(stream, TX_ERR);
+    }
+    dmacEnableStream(stream);
+}
+
+static void i2cDmaStop(I2C_TypeDef *i2c, I2C_CONTEXT_t *ctx)
+{
+    const I2C_DMA_MAP_t *map = i2cGetDmaMap(ctx);
+    uint32_t             primask;
+
+    i2c->CR2 &= ~(I2C_CR2_DMAEN_Msk | I2C_CR2_LAST_Msk);
+    if (ctx->dma)
+    {
+        dmacDisableStream(map->rxStream);
+        dmacClearAllStreamIrqFlags(DMA1, map->rxStream);
+        primask = __get_PRIMASK();
+        __disable_irq();
+        if ((map->txStream->CR & DMA_SxCR_CHSEL_Msk) == (map->txChn << DMA_SxCR_CHSEL_Pos))
+        {
+            dmacDisableStream(map->txStream);       // Not when it is lent to SPI2 (I2C3)
+            dmacClearAllStreamIrqFlags(DMA1, map->txStream);
+        }
+        __set_PRIMASK(primask);
+        ctx->dma = false;
+    }
+}
+
+/**
+ * Stops the engine and marks the active transfer as done, w/o callback and dispatch.
+ * Returns the transfer, NULL if none was active.
+ */
+static I2C_TRANSFER_t *i2cReleaseTransfer(I2C_TypeDef *i2c, I2C_CONTEXT_t *ctx, I2C_RETURN_CODE_t result)
+{
+    I2C_TRANSFER_t *xfer = ctx->xfer;
+
+    i2c->CR2 &= ~(I2C_CR2_ITEVTEN_Msk | I2C_CR2_ITBUFEN_Msk | I2C_CR2_ITERREN_Msk);
+    i2cDmaStop(i2c, ctx);
+    I2C_RESET_POS(i2c);
+    ctx->xfer = NULL;
+
+    if (NULL == xfer)
+    {
+        return NULL;
+    }
+#if I2C_TRACE_ENABLE
+    i2cTraceTransfer(i2c, ctx->seg, ctx->segCount, result, ctx->t0, DWT->CYCCNT);
+#endif
+    xfer->result = result;
+    xfer->state  = I2C_XFER_DONE;
+    return xfer;
+}
+
+static void i2cCompleteTransfer(I2C_TypeDef *i2c, I2C_CONTEXT_t *ctx, I2C_RETURN_CODE_t result)
+{
+    I2C_TRANSFER_t *xfer = i2cReleaseTransfer(i2c, ctx, result);
+
+    if (NULL == xfer)
+    {
+        return;
+    }
+    if (NULL != xfer->callback)
+    {
+        xfer->callback(xfer);           // The callback may already submit the next transfer
+    }
+    i2cDispatch(i2c, ctx);              // Transaction boundary: hand the bus to the highest priority
+}
+
+static bool i2cIsLastSegment(I2C_CONTEXT_t *ctx)
+{
+    return ((ctx->segIdx + 1) >= ctx->segCount);
+}
+
+static void i2cLoadSegment(I2C_CONTEXT_t *ctx, uint8_t idx)
+{
+    const I2C_SEGMENT_t *seg = &ctx->seg[idx];
+
+    ctx->segIdx = idx;
+    ctx->phase  = (I2C_SEG_READ == seg->dir) ? I2C_PHASE_RX : I2C_PHASE_TX;
+    ctx->txPtr  = seg->buf;
+    ctx->rxPtr  = seg->buf;
+    ctx->count  = seg->len;
+    ctx->dma    = ctx->xfer->useDma && (seg->len >= 2);     // N = 1 is always handled by the CPU
+}
+
+/**
+ * Enables the receive data path of the current segment. Called before its (repeated) START.
+ */
+static void i2cArmRxPath(I2C_TypeDef *i2c, I2C_CONTEXT_t *ctx)
+{
+    const I2C_DMA_MAP_t *map = i2cGetDmaMap(ctx);
+
+    i2c->CR2 &= ~(I2C_CR2_DMAEN_Msk | I2C_CR2_LAST_Msk);
+    if (ctx->dma)
+    {
+        // LAST lets the I2C send the NACK after the final byte, STOP is set in the DMA TC interrupt
+        i2cDmaStart(i2c, map->rxStream, map->rxChn, (uint32_t) ctx->rxPtr, ctx->count, PER_2_MEM);
+        i2c->CR2 &= ~I2C_CR2_ITBUFEN_Msk;
+        i2c->CR2 |= I2C_CR2_DMAEN | I2C_CR2_LAST;
+    }
+    else
+    {
+        i2c->CR2 |= I2C_CR2_ITBUFEN;
+    }
+}
+
+/**
+ * Enables the transmit data path of the current segment. It must not be enabled before ADDR,
+ * otherwise a TXE left over from the previous segment would send data before the address.
+ */
+static void i2cArmTxPath(I2C_TypeDef *i2c, I2C_CONTEXT_t *ctx)
+{
+    const I2C_DMA_MAP_t *map = i2cGetDmaMap(ctx);
+    uint32_t             primask;
+
+    if (ctx->dma)
+    {
+        // The stream may be taken by SPI2 (I2C3): claimed in one step, otherwise the CPU sends
+        primask = __get_PRIMASK();
+        __disable_irq();
+        ctx->dma = i2cDmaStreamFree(map->txStream, map->txChn);
+        if (ctx->dma)
+        {
+            i2cDmaStart(i2c, map->txStream, map->txChn, (uint32_t) ctx->txPtr, ctx->count, MEM_2_PER);
+        }
+        __set_PRIMASK(primask);
+    }
+    if (ctx->dma)
+    {
+        // TXE requests are served by the DMA, the end is detected by BTF with NDTR = 0
+        i2c->CR2 |= I2C_CR2_DMAEN;
+    }
+    else
+    {
+        i2c->CR2 |= I2C_CR2_ITBUFEN;
+    }
+}
+
+static void i2cStartSegment(I2C_TypeDef *i2c, I2C_CONTEXT_t *ctx, uint8_t idx)
+{
+    i2cLoadSegment(ctx, idx);
+    i2c->CR2 &= ~I2C_CR2_ITBUFEN_Msk;
+    if (I2C_PHASE_RX == ctx->phase)
+    {
+        i2cArmRxPath(i2c, ctx);
+    }
+    i2c->CR1 |= I2C_CR1_START;          // (Repeated) START, address is sent when SB is set
+}
+
+/**
+ * Requests the condition that follows a read segment: STOP after the last segment,
+ * repeated START otherwise.
+ */
+static void i2cRxEndCondition(I2C_TypeDef *i2c, I2C_CONTEXT_t *ctx)
+{
+    if (i2cIsLastSegment(ctx))
+    {
+        i2c->CR1 |= I2C_CR1_STOP;
+    }
+    else
+    {
+        i2c->CR1 |= I2C_CR1_START;
+    }
+}
+
+static void i2cRxSegmentFinished(I2C_TypeDef *i2c, I2C_CONTEXT_t *ctx)
+{
+    i2cDmaStop(i2c, ctx);
+    I2C_RESET_POS(i2c);
+    if (i2cIsLastSegment(ctx))
+    {
+        i2cCompleteTransfer(i2c, ctx, I2C_OK);
+        return;
+    }
+    // START has already been requested by i2cRxEndCondition()
+    i2cLoadSegment(ctx, ctx->segIdx + 1);
+    i2c->CR2 &= ~I2C_CR2_ITBUFEN_Msk;
+    if (I2C_PHASE_RX == ctx->phase)
+    {
+        i2cArmRxPath(i2c, ctx);
+    }
+}
+
+static void i2cTxSegmentFinished(I2C_TypeDef *i2c, I2C_CONTEXT_t *ctx)
+{
+    const I2C_SEGMENT_t *next;
+
+    i2cDmaStop(i2c, ctx);
+    while (!i2cIsLastSegment(ctx))
+    {
+        next = &ctx->seg[ctx->segIdx + 1];
+        if ((I2C_SEG_WRITE != next->dir) || !(next->flags & I2C_SEG_NOSTART))
+        {
+            i2cStartSegment(i2c, ctx, ctx->segIdx + 1);
+            return;
+        }
+        i2cLoadSegment(ctx, ctx->segIdx + 1);               // Gather: continue writing w/o START
+        if (ctx->count > 0)
+        {
+            i2cArmTxPath(i2c, ctx);
+            return;
+        }
+    }
+    i2c->CR1 |= I2C_CR1_STOP;
+    i2cCompleteTransfer(i2c, ctx, I2C_OK);
+}
+
+static void i2cEventHandler(I2C_TypeDef *i2c, I2C_CONTEXT_t *ctx)
+{
+    uint32_t sr1 = i2c->SR1;
+
+    if (NULL == ctx->xfer)
+    {
+        i2c->CR2 &= ~(I2C_CR2_ITEVTEN_Msk | I2C_CR2_ITBUFEN_Msk | I2C_CR2_ITERREN_Msk);
+        return;
+    }
+
+    if (sr1 & I2C_SR1_SB)
+    {
+        if ((I2C_PHASE_RX == ctx->phase) && !ctx->dma && (1 == ctx->count) && (sr1 & I2C_SR1_RXNE))
+        {
+            // Last byte of a read segment and the following repeated START in one go
+            *ctx->rxPtr++ = i2c->DR;
+            ctx->count = 0;
+            i2cRxSegmentFinished(i2c, ctx);
+        }
+        if (I2C_PHASE_TX == ctx->phase)
+        {
+            i2c->DR = ctx->seg[ctx->segIdx].saddr << 1;
+        }
+        else
+        {
+            i2c->DR = (ctx->seg[ctx->segIdx].saddr << 1) | 1;
+        }
+        return;
+    }
+
+    if (sr1 & I2C_SR1_ADDR)
+    {
+        if ((I2C_PHASE_RX == ctx->phase) && ctx->dma)
+        {
+            I2C_SET_ACK(i2c);
+            I2C_DUMMY_READ_SR2(i2c);
+        }
+        else if (I2C_PHASE_RX == ctx->phase)
+        {
+            if (1 == ctx->count)
+            {
+                I2C_RESET_ACK(i2c);
+                I2C_DUMMY_READ_SR2(i2c);        // Clears ADDR
+                i2cRxEndCondition(i2c, ctx);
+            }
+            else if (2 == ctx->count)
+            {
+                I2C_RESET_ACK(i2c);
+                I2C_SET_POS(i2c);
+                I2C_DUMMY_READ_SR2(i2c);
+                i2c->CR2 &= ~I2C_CR2_ITBUFEN_Msk;   // Wait for BTF
+            }
+            else
+            {
+                I2C_SET_ACK(i2c);
+                I2C_DUMMY_READ_SR2(i2c);
+                if (3 == ctx->count)
+                {
+                    i2c->CR2 &= ~I2C_CR2_ITBUFEN_Msk;
+                }
+            }
+        }
+        else
+        {
+            if (ctx->count > 0)
+            {
+                i2cArmTxPath(i2c, ctx);
+            }
+            I2C_DUMMY_READ_SR2(i2c);
+            if (0 == ctx->count)
+            {
+                i2cTxSegmentFinished(i2c, ctx);     // Nothing to send, e.g. address probe
+            }
+        }
+        return;
+    }
+
+    if (ctx->dma)
+    {
+        if ((I2C_PHASE_TX == ctx->phase) && (sr1 & I2C_SR1_BTF) && (0 == i2cGetDmaMap(ctx)->txStream->NDTR))
+        {
+            ctx->count = 0;
+            i2cTxSegmentFinished(i2c, ctx);
+        }
+        return;                         // Data bytes are moved by the DMA
+    }
+
+    if (I2C_PHASE_TX == ctx->phase)
+    {
+        if ((sr1 & I2C_SR1_TXE) && (ctx->count > 0))
+        {
+            i2c->DR = *ctx->txPtr++;
+            if (0 == --ctx->count)
+            {
+                i2c->CR2 &= ~I2C_CR2_ITBUFEN_Msk;   // Last byte written, wait for BTF
+            }
+        }
+        else if ((sr1 & I2C_SR1_BTF) && (0 == ctx->count))
+        {
+            i2cTxSegmentFinished(i2c, ctx);
+        }
+        return;
+    }
+
+    // Receive phase
+    if ((sr1 & I2C_SR1_BTF) && (3 == ctx->count))
+    {
+        I2C_RESET_ACK(i2c);                         // Data N-2 in DR, N-1 in shift register
+        *ctx->rxPtr++ = i2c->DR;
+        ctx->count--;
+    }
+    else if ((sr1 & I2C_SR1_BTF) && (2 == ctx->count))
+    {
+        i2cRxEndCondition(i2c, ctx);
+        *ctx->rxPtr++ = i2c->DR;
+        *ctx->rxPtr++ = i2c->DR;
+        ctx->count = 0;
+        i2cRxSegmentFinished(i2c, ctx);
+    }
+    else if ((sr1 & I2C_SR1_RXNE) && (ctx->count > 3))
+    {
+        *ctx->rxPtr++ = i2c->DR;
+        if (3 == --ctx->count)
+        {
+            i2c->CR2 &= ~I2C_CR2_ITBUFEN_Msk;
+        }
+    }
+    else if ((sr1 & I2C_SR1_RXNE) && (1 == ctx->count))
+    {
+        *ctx->rxPtr++ = i2c->DR;
+        ctx->count = 0;
+        i2cRxSegmentFinished(i2c, ctx);
+    }
+}
+
+static void i2cErrorHandler(I2C_TypeDef *i2c, I2C_CONTEXT_t *ctx)
+{
+    uint32_t sr1 = i2c->SR1 & (I2C_SR1_AF | I2C_SR1_BERR | I2C_SR1_ARLO | I2C_SR1_OVR);
+
+    I2C_RETURN_CODE_t result = I2C_TRANSFER_ERROR;
+
+    i2c->SR1 = ~sr1 & 0xFFFF;           // Error flags are cleared by writing 0
+    if (sr1 & I2C_SR1_BERR)
+    {
+        result = I2C_BUS_ERROR;
+        ctx->recover = true;
+    }
+    else if (sr1 & I2C_SR1_ARLO)
+    {
+        result = I2C_ARBITRATION_LOST;  // Interface is already in slave mode, no STOP
+        ctx->recover = true;
+    }
+    else if (sr1 & I2C_SR1_AF)
+    {
+        result = I2C_NACK;
+        i2c->CR1 |= I2C_CR1_STOP;       // Release the bus after NACK
+    }
+    i2cCompleteTransfer(i2c, ctx, result);
+}
+
+/**
+ * Checks the buffers and the segment list of a transfer descriptor.
+ */
+static bool i2cVerifyTransfer(I2C_TRANSFER_t *xfer)
+{
+    uint8_t i;
+
+    if (0 == xfer->numSegments)
+    {
+        return !(((xfer->txLen > 0) && (NULL == xfer->txBuf)) || ((xfer->rxLen > 0) && (NULL == xfer->rxBuf)));
+    }
+    if ((NULL == xfer->segments) || (xfer->segments[0].flags & I2C_SEG_NOSTART))
+    {
+        return false;
+    }
+    for (i = 0; i < xfer->numSegments; i++)
+    {
+        const I2C_SEGMENT_t *seg = &xfer->segments[i];
+
+        if (((seg->len > 0) && (NULL == seg->buf)) || ((I2C_SEG_READ == seg->dir) && (0 == seg->len)))
+        {
+            return false;           // A read segment needs at least one byte
+        }
+        if ((seg->flags & I2C_SEG_NOSTART) &&
+            ((I2C_SEG_WRITE != seg->dir) || (I2C_SEG_WRITE != seg[-1].dir) || (seg->saddr != seg[-1].saddr)))
+        {
+            return false;           // Only a write to the same slave can be continued w/o START
+        }
+    }
+    return true;
+}
+
+/**
+ * Number of bus bytes of the active transfer incl. address bytes, used for the time budget.
+ */
+static uint32_t i2cTransferBytes(I2C_CONTEXT_t *ctx)
+{
+    uint32_t bytes = 1;
+    uint8_t  i;
+
+    for (i = 0; i < ctx->segCount; i++)
+    {
+        bytes += ctx->seg[i].len + 1;
+    }
+    return bytes;
+}
+
+/**
+ * @ingroup iic3
+ * Starts an I2C transfer and returns immediately.
+ *
+ * @param  *i2c  : Pointer to the I2C component
+ * @param  *xfer : Transfer descriptor. It must stay valid until xfer->state is I2C_XFER_DONE.
+ *
+ * @return I2C_OK if the transfer has been started, I2C_BUSY if another transfer is active on this bus
+ *
+ * @note
+ * xfer->txLen bytes are written, followed by a (repeated) START and reading of xfer->rxLen bytes.
+ * Completion is signalled by xfer->state / xfer->result and the optional callback, which is
+ * called from the interrupt handler. The priority queues are bypassed; a callback which submits
+ * its follow-up transfer keeps the bus (chained sequences), otherwise use i2cQueueTransfer().
+ * In interrupt context the STOP of the previous transfer is awaited for I2C_ISR_STOP_WAIT_US at most.
+ * If the bus is still busy or needs a recovery, the transfer is appended to the I2C_PRIO_CONTROL
+ * queue and started by i2cCheckTimeout() in thread context.
+ */
+I2C_RETURN_CODE_t i2cSubmitTransfer(I2C_TypeDef *i2c, I2C_TRANSFER_t *xfer)
+{
+    I2C_CONTEXT_t    *ctx = i2cGetContext(i2c);
+    I2C_RETURN_CODE_t rc;
+    uint32_t          primask;
+    bool              ready = true;
+
+    if (NULL == ctx)
+    {
+        return I2C_INVALID_TYPE;
+    }
+    if ((NULL == xfer) || (i2cVerifyTransfer(xfer) != true))
+    {
+        return I2C_INVALID_TRANSFER;
+    }
+    if (i2cInIsr() && (0 == ctx->polling) && (NULL == ctx->xfer))
+    {
+        ready = i2cIsrWaitIdle(i2c, ctx);       // No recovery in the ISR
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if (NULL != ctx->xfer)
+    {
+        __set_PRIMASK(primask);
+        return I2C_BUSY;
+    }
+    if (!ready)
+    {
+        // Behind the control transfers already waiting, started by i2cCheckTimeout()
+        xfer->prio   = I2C_PRIO_CONTROL;
+        xfer->next   = NULL;
+        xfer->result = I2C_OK;
+        xfer->state  = I2C_XFER_QUEUED;
+        if (NULL == ctx->qTail[I2C_PRIO_CONTROL])
+        {
+            ctx->qHead[I2C_PRIO_CONTROL] = xfer;
+        }
+        else
+        {
+            ctx->qTail[I2C_PRIO_CONTROL]->next = xfer;
+        }
+        ctx->qTail[I2C_PRIO_CONTROL] = xfer;
+        __set_PRIMASK(primask);
+        return I2C_OK;
+    }
+    ctx->xfer = xfer;
+    __set_PRIMASK(primask);
+
+    rc = i2cStartTransfer(i2c, ctx, xfer);
+    if (I2C_OK != rc)
+    {
+        i2cDispatch(i2c, ctx);              // Bus released again, serve the queues
+    }
+    return rc;
+}
+
+/**
+ * Starts the transfer which has already been assigned to ctx->xfer.
+ */
+static I2C_RETURN_CODE_t i2cStartTransfer(I2C_TypeDef *i2c, I2C_CONTEXT_t *ctx, I2C_TRANSFER_t *xfer)
+{
+    // STOP of the previous transfer pending or bus hanging: recover first
+    if (ctx->recover || !I2C_STOPP_COMPLETED(i2c) || !I2C_WAIT_BUSY(i2c))
+    {
+        if (i2cResetBus(i2c, ctx) != I2C_OK)
+        {
+            ctx->xfer = NULL;
+            return I2C_TIMEOUT;
+        }
+    }
+
+    if (xfer->numSegments > 0)
+    {
+        ctx->seg      = xfer->segments;
+        ctx->segCount = xfer->numSegments;
+    }
+    else
+    {
+        // Simple descriptor: write part and/or read part with repeated START
+        ctx->segCount = 0;
+        if ((xfer->txLen > 0) || (0 == xfer->rxLen))
+        {
+            ctx->simpleSeg[ctx->segCount].saddr = xfer->saddr;
+            ctx->simpleSeg[ctx->segCount].dir   = I2C_SEG_WRITE;
+            ctx->simpleSeg[ctx->segCount].flags = I2C_SEG_DEFAULT;
+            ctx->simpleSeg[ctx->segCount].buf   = (uint8_t *) xfer->txBuf;
+            ctx->simpleSeg[ctx->segCount].len   = xfer->txLen;
+            ctx->segCount++;
+        }
+        if (xfer->rxLen > 0)
+        {
+            ctx->simpleSeg[ctx->segCount].saddr = xfer->saddr;
+            ctx->simpleSeg[ctx->segCount].dir   = I2C_SEG_READ;
+            ctx->simpleSeg[ctx->segCount].flags = I2C_SEG_DEFAULT;
+            ctx->simpleSeg[ctx->segCount].buf   = xfer->rxBuf;
+            ctx->simpleSeg[ctx->segCount].len   = xfer->rxLen;
+            ctx->segCount++;
+        }
+        ctx->seg = ctx->simpleSeg;
+    }
+
+    xfer->state  = I2C_XFER_BUSY;
+    xfer->result = I2C_OK;
+    ctx->t0      = DWT->CYCCNT;
+    ctx->budget  = i2cCyclesPerUs * (I2C_TIMEOUT_US + i2cTransferBytes(ctx) * I2C_TIMEOUT_US_PER_BYTE);
+
+    if (xfer->useDma && !ctx->dmaReady)
+    {
+        dmacSelectDMAC(DMA1);
+        NVIC_EnableIRQ(i2cGetDmaMap(ctx)->rxIRQn);
+        ctx->dmaReady = true;
+    }
+
+    i2cSelectTiming(i2c, ctx);              // Bus is idle: switch to the speed profile of the slave(s)
+    I2C_RESET_POS(i2c);
+    i2c->CR2 |= I2C_CR2_ITEVTEN | I2C_CR2_ITERREN;
+    i2cStartSegment(i2c, ctx, 0);
+    return I2C_OK;
+}
+
+/**
+ * @ingroup iic3
+ * Returns true if the transfer is finished (successful or not).
+ */
+bool i2cIsTransferDone(I2C_TRANSFER_t *xfer)
+{
+    return (I2C_XFER_DONE == xfer->state);
+}
+
+/**
+ * @ingroup iic3
+ * Returns true while an asynchronous transfer is active on the I2C component.
+ */
+bool i2cIsBusBusy(I2C_TypeDef *i2c)
+{
+    I2C_CONTEXT_t *ctx = i2cGetContext(i2c);
+
+    return ((NULL != ctx) && (NULL != ctx->xfer));
+}
+
+/**
+ * Releases the active transfer with I2C_TIMEOUT, with expiredOnly only if its time budget is
+ * exceeded. Checked and released in one critical section: a transfer which the completion
+ * interrupt has started in the meantime is not aborted. Returns the released transfer or NULL.
+ */
+static I2C_TRANSFER_t *i2cReleaseForAbort(I2C_TypeDef *i2c, I2C_CONTEXT_t *ctx, bool expiredOnly)
+{
+    I2C_TRANSFER_t *xfer = NULL;
+    uint32_t        primask;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if ((NULL != ctx->xfer) && (!expiredOnly || ((DWT->CYCCNT - ctx->t0) >= ctx->budget)))
+    {
+        ctx->recover = true;
+        xfer = i2cReleaseTransfer(i2c, ctx, I2C_TIMEOUT);
+    }
+    __set_PRIMASK(primask);
+
+    return xfer;
+}
+
+/**
+ * Completes an aborted transfer outside the critical section and recovers the bus.
+ */
+static I2C_RETURN_CODE_t i2cFinishAbort(I2C_TypeDef *i2c, I2C_CONTEXT_t *ctx, I2C_TRANSFER_t *xfer)
+{
+    I2C_RETURN_CODE_t rc;
+
+    // Callback with the caller's interrupt state; a transfer submitted by it recovers the bus itself
+    if ((NULL != xfer) && (NULL != xfer->callback))
+    {
+        xfer->callback(xfer);
+    }
+    rc = i2cRecoverBus(i2c);
+    i2cDispatch(i2c, ctx);
+
+    return rc;
+}
+
+/**
+ * @ingroup iic3
+ * Aborts the active transfer. It is completed with I2C_TIMEOUT and the bus is recovered.
+ *
+ * @param  *i2c : Pointer to the I2C component
+ */
+I2C_RETURN_CODE_t i2cAbortTransfer(I2C_TypeDef *i2c)
+{
+    I2C_CONTEXT_t *ctx = i2cGetContext(i2c);
+
+    if (NULL == ctx)
+    {
+        return I2C_INVALID_TYPE;
+    }
+    return i2cFinishAbort(i2c, ctx, i2cReleaseForAbort(i2c, ctx, false));
+}
+
+/**
+ * @ingroup iic3
+ * Checks the time budget of the active transfer and aborts it if it is exceeded. If the bus is
+ * free, queued transfers are started, incl. bus recovery (interrupt handlers leave them queued
+ * while STOP is pending or a recovery is required).
+ * Users of i2cSubmitTransfer() and i2cQueueTransfer() should call this function periodically,
+ * e.g. in the main loop.
+ *
+ * @param  *i2c : Pointer to the I2C component
+ *
+ * @return I2C_TIMEOUT if the active transfer has been aborted, I2C_OK otherwise
+ */
+I2C_RETURN_CODE_t i2cCheckTimeout(I2C_TypeDef *i2c)
+{
+    I2C_CONTEXT_t  *ctx = i2cGetContext(i2c);
+    I2C_TRANSFER_t *xfer;
+
+    if (NULL == ctx)
+    {
+        return I2C_OK;
+    }
+    if (NULL == ctx->xfer)
+    {
+        i2cDispatch(i2c, ctx);
+        return I2C_OK;
+    }
+    // The transfer may complete and the next one start between both checks: decided under PRIMASK
+    xfer = i2cReleaseForAbort(i2c, ctx, true);
+    if (NULL == xfer)
+    {
+        return I2C_OK;
+    }
+    i2cFinishAbort(i2c, ctx, xfer);
+    return I2C_TIMEOUT;
+}
+
+/**
+ * Starts the oldest transfer of the highest priority queue if the bus is free. Called at every
+ * transaction boundary (completion interrupt) and after queueing, i.e. from thread and
+ * interrupt context. Taking the transfer out of the queue and occupying the bus are done
+ * in one critical section, so a concurrent caller either finds the bus occupied or the
+ * queue unchanged.
+ * In interrupt context the STOP of the previous transfer is awaited for I2C_ISR_STOP_WAIT_US at
+ * most; if the bus is still busy or needs a recovery, the transfer stays queued for
+ * i2cCheckTimeout() in thread context.
+ */
+static void i2cDispatch(I2C_TypeDef *i2c, I2C_CONTEXT_t *ctx)
+{
+    I2C_TRANSFER_t   *xfer;
+    I2C_RETURN_CODE_t rc;
+    uint32_t          primask;
+    uint8_t           prio;
+    bool              ready;
+
+    do
+    {
+        xfer  = NULL;
+        ready = true;
+        if (i2cInIsr() && (0 == ctx->polling) && (NULL == ctx->xfer))
+        {
+            for (prio = 0; (prio < I2C_NUM_PRIO) && (NULL == ctx->qHead[prio]); prio++)
+            {
+                ;
+            }
+            ready = (prio < I2C_NUM_PRIO) && i2cIsrWaitIdle(i2c, ctx);     // Only wait if work is queued
+        }
+        primask = __get_PRIMASK();
+        __disable_irq();
+        if ((NULL == ctx->xfer) && ready)
+        {
+            for (prio = 0; (prio < I2C_NUM_PRIO) && (NULL == xfer); prio++)
+            {
+                xfer = ctx->qHead[prio];
+                if (NULL != xfer)
+                {
+                    ctx->qHead[prio] = xfer->next;
+                    if (NULL == ctx->qHead[prio])
+                    {
+                        ctx->qTail[prio] = NULL;
+                    }
+                    xfer->next = NULL;
+                    ctx->xfer  = xfer;
+                }
+            }
+        }
+        __set_PRIMASK(primask);
+
+        if (NULL == xfer)
+        {
+            return;
+        }
+        rc = i2cStartTransfer(i2c, ctx, xfer);
+        if (I2C_OK != rc)
+        {
+            // Bus could not be recovered: complete this one and try the next
+            xfer->result = rc;
+            xfer->state  = I2C_XFER_DONE;
+            if (NULL != xfer->callback)
+            {
+                xfer->callback(xfer);
+            }
+        }
+    } while (I2C_OK != rc);
+}
+
+/**
+ * @ingroup iic3
+ * Queues an asynchronous transfer. It is started immediately if the bus is free, otherwise
+ * at the next transaction boundary in the order of priority (FIFO within one priority).
+ *
+ * @param  *i2c  : Pointer to the I2C component
+ * @param  *xfer : Transfer descriptor, see i2cSubmitTransfer(). It must stay valid until xfer->state
+ *                 is I2C_XFER_DONE.
+ * @param   prio : I2C_PRIO_CONTROL ... I2C_PRIO_UI
+ *
+ * @return I2C_OK if the transfer has been queued or started, I2C_BUSY if the descriptor is still in use
+ *
+ * @note
+ * May be called from the main loop and from interrupt handlers (incl. completion callbacks).
+ * An interrupt handler waits for the STOP of the previous transfer for I2C_ISR_STOP_WAIT_US at
+ * most; if the bus needs longer or a recovery, i2cCheckTimeout() starts it.
+ * A running transfer is never interrupted: a control loop transfer waits at most for the
+ * completion of one background transaction. The blocking functions (i2cBurstRead() etc.)
+ * are queued with I2C_PRIO_CONTROL.
+ */
+I2C_RETURN_CODE_t i2cQueueTransfer(I2C_TypeDef *i2c, I2C_TRANSFER_t *xfer, I2C_PRIO_t prio)
+{
+    I2C_CONTEXT_t *ctx = i2cGetContext(i2c);
+    uint32_t       primask;
+
+    if (NULL == ctx)
+    {
+        return I2C_INVALID_TYPE;
+    }
+    if ((NULL == xfer) || (prio >= I2C_NUM_PRIO) || (i2cVerifyTransfer(xfer) != true))
+    {
+        return I2C_INVALID_TRANSFER;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if ((I2C_XFER_BUSY == xfer->state) || (I2C_XFER_QUEUED == xfer->state))
+    {
+        __set_PRIMASK(primask);
+        return I2C_BUSY;
+    }
+    xfer->prio   = prio;
+    xfer->next   = NULL;
+    xfer->result = I2C_OK;
+    xfer->state  = I2C_XFER_QUEUED;
+    if (NULL == ctx->qTail[prio])
+    {
+        ctx->qHead[prio] = xfer;
+    }
+    else
+    {
+        ctx->qTail[prio]->next = xfer;
+    }
+    ctx->qTail[prio] = xfer;
+    __set_PRIMASK(primask);
+
+    i2cDispatch(i2c, ctx);
+    return I2C_OK;
+}
+
+/**
+ * @ingroup iic3
+ * Removes a transfer from its queue. Its state is reset to I2C_XFER_IDLE, the callback is not called.
+ *
+ * @return I2C_OK if removed, I2C_BUSY if it is already running, I2C_INVALID_TRANSFER if not queued
+ */
+I2C_RETURN_CODE_t i2cCancelTransfer(I2C_TypeDef *i2c, I2C_TRANSFER_t *xfer)
+{
+    I2C_CONTEXT_t    *ctx = i2cGetContext(i2c);
+    I2C_TRANSFER_t   *prev = NULL;
+    I2C_TRANSFER_t   *cur;
+    I2C_RETURN_CODE_t rc = I2C_INVALID_TRANSFER;
+    uint32_t          primask;
+
+    if ((NULL == ctx) || (NULL == xfer))
+    {
+        return (NULL == ctx) ? I2C_INVALID_TYPE : I2C_INVALID_TRANSFER;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if (ctx->xfer == xfer)
+    {
+        rc = I2C_BUSY;
+    }
+    else if ((I2C_XFER_QUEUED == xfer->state) && (xfer->prio < I2C_NUM_PRIO))
+    {
+        for (cur = ctx->qHead[xfer->prio]; (NULL != cur) && (cur != xfer); cur = cur->next)
+        {
+            prev = cur;
+        }
+        if (NULL != cur)
+        {
+            if (NULL == prev)
+            {
+                ctx->qHead[xfer->prio] = xfer->next;
+            }
+            else
+            {
+                prev->next = xfer->next;
+            }
+            if (ctx->qTail[xfer->prio] == xfer)
+            {
+                ctx->qTail[xfer->prio] = prev;
+            }
+            xfer->next  = NULL;
+            xfer->state = I2C_XFER_IDLE;
+            rc = I2C_OK;
+        }
+    }
+    __set_PRIMASK(primask);
+
+    return rc;
+}
+
+/**
+ * @ingroup iic3
+ * Returns the number of transfers waiting with the given priority.
+ */
+uint8_t i2cQueuedTransfers(I2C_TypeDef *i2c, I2C_PRIO_t prio)
+{
+    I2C_CONTEXT_t  *ctx = i2cGetContext(i2c);
+    I2C_TRANSFER_t *cur;
+    uint32_t        primask;
+    uint8_t         num = 0;
+
+    if ((NULL == ctx) || (prio >= I2C_NUM_PRIO))
+    {
+        return 0;
+    }
+    primask = __get_PRIMASK();
+    __disable_irq();
+    for (cur = ctx->qHead[prio]; NULL != cur; cur = cur->next)
+    {
+        num++;
+    }
+    __set_PRIMASK(primask);
+
+    return num;
+}
+
+/**
+ * @ingroup iic3
+ * Registers the SCL and SDA pins of the I2C component. They are needed by i2cRecoverBus()
+ * to clock out a slave which is holding SDA low.
+ */
+I2C_RETURN_CODE_t i2cSetBusPins(I2C_TypeDef *i2c, GPIO_TypeDef *sclPort, PIN_NUM_t sclPin, ALT_FUNC_t sclAf,
+                                GPIO_TypeDef *sdaPort, PIN_NUM_t sdaPin, ALT_FUNC_t sdaAf)
+{
+    I2C_CONTEXT_t *ctx = i2cGetContext(i2c);
+
+    if (NULL == ctx)
+    {
+        return I2C_INVALID_TYPE;
+    }
+    ctx->sclPort = sclPort;
+    ctx->sclPin  = sclPin;
+    ctx->sclAf   = sclAf;
+    ctx->sdaPort = sdaPort;
+    ctx->sdaPin  = sdaPin;
+    ctx->sdaAf   = sdaAf;
+    return I2C_OK;
+}
+
+/**
+ * Clocks out a hanging slave, generates a STOP condition and re-initializes the I2C component.
+ * Duration: max. (2 * I2C_RECOVERY_PULSES + 4) * I2C_RECOVERY_HALF_US = 110 us.
+ */
+static I2C_RETURN_CODE_t i2cResetBus(I2C_TypeDef *i2c, I2C_CONTEXT_t *ctx)
+{
+    uint32_t ccr   = i2c->CCR;          // Current settings, restored after SWRST
+    uint32_t trise = i2c->TRISE;
+    uint32_t freq  = i2c->CR2 & I2C_CR2_FREQ_Msk;
+    uint8_t  pulse;
+
+    i2c->CR1 &= ~I2C_CR1_PE_Msk;
+    if ((NULL != ctx->sclPort) && (NULL != ctx->sdaPort))
+    {
+        gpioSetPin(ctx->sclPort, ctx->sclPin);              // Open drain: '1' releases the line
+        gpioSetPin(ctx->sdaPort, ctx->sdaPin);
+        gpioSelectPinMode(ctx->sclPort, ctx->sclPin, OUTPUT);
+        gpioSelectPinMode(ctx->sdaPort, ctx->sdaPin, OUTPUT);
+        __i2c_delay_us(I2C_RECOVERY_HALF_US);
+
+        for (pulse = 0; (pulse < I2C_RECOVERY_PULSES) && !gpioGetPinState(ctx->sdaPort, ctx->sdaPin); pulse++)
+        {
+            gpioResetPin(ctx->sclPort, ctx->sclPin);
+            __i2c_delay_us(I2C_RECOVERY_HALF_US);
+            gpioSetPin(ctx->sclPort, ctx->sclPin);
+            __i2c_delay_us(I2C_RECOVERY_HALF_US);
+        }
+
+        // STOP condition: SDA low -> high while SCL is high
+        gpioResetPin(ctx->sclPort, ctx->sclPin);
+        gpioResetPin(ctx->sdaPort, ctx->sdaPin);
+        __i2c_delay_us(I2C_RECOVERY_HALF_US);
+        gpioSetPin(ctx->sclPort, ctx->sclPin);
+        __i2c_delay_us(I2C_RECOVERY_HALF_US);
+        gpioSetPin(ctx->sdaPort, ctx->sdaPin);
+        __i2c_delay_us(I2C_RECOVERY_HALF_US);
+
+        gpioSelectPinMode(ctx->sclPort, ctx->sclPin, ALTFUNC);
+        gpioSelectAltFunc(ctx->sclPort, ctx->sclPin, ctx->sclAf);
+        gpioSelectPinMode(ctx->sdaPort, ctx->sdaPin, ALTFUNC);
+        gpioSelectAltFunc(ctx->sdaPort, ctx->sdaPin, ctx->sdaAf);
+    }
+
+    i2c->CR1   = I2C_CR1_SWRST;
+    i2c->CR1   = 0x0000;
+    i2c->CR2   = freq;
+    i2c->TRISE = trise;
+    i2c->OAR1  = (1 << 14);
+    i2c->CCR   = ccr;
+    i2c->CR1  |= I2C_CR1_PE;
+    ctx->recover = false;
+
+    return (i2c->SR2 & I2C_SR2_BUSY) ? I2C_BUS_ERROR : I2C_OK;
+}
+
+/**
+ * @ingroup iic3
+ * Restores a hanging I2C bus: SCL clock-out of 9 pulses (only if the pins have been registered
+ * with i2cSetBusPins()), STOP condition, SWRST and re-initialization of CR2/CCR/TRISE.
+ *
+ * @param  *i2c : Pointer to the I2C component
+ *
+ * @return I2C_OK if the bus is free afterwards, I2C_BUS_ERROR otherwise
+ *
+ * @note
+ * Must not be called while a transfer is active, use i2cAbortTransfer() instead.
+ */
+I2C_RETURN_CODE_t i2cRecoverBus(I2C_TypeDef *i2c)
+{
+    I2C_CONTEXT_t *ctx = i2cGetContext(i2c);
+
+    if ((NULL == ctx) || (NULL != ctx->xfer))
+    {
+        return (NULL == ctx) ? I2C_INVALID_TYPE : I2C_BUSY;
+    }
+    return i2cResetBus(i2c, ctx);
+}
+
+/**
+ * Calls the handler whose interrupt request is active (RM0368, I2C interrupt requests), used by
+ * blocking calls while the I2C interrupts can't be taken.
+ */
+static void i2cPollHandlers(I2C_TypeDef *i2c, I2C_CONTEXT_t *ctx)
+{
+    const I2C_DMA_MAP_t *map = i2cGetDmaMap(ctx);
+    uint32_t             cr2 = i2c->CR2;
+    uint32_t             sr1 = i2c->SR1;
+    uint32_t             lisr;
+
+    if ((cr2 & I2C_CR2_ITERREN) && (sr1 & (I2C_SR1_AF | I2C_SR1_BERR | I2C_SR1_ARLO | I2C_SR1_OVR)))
+    {
+        i2cErrorHandler(i2c, ctx);
+    }
+    else if ((cr2 & I2C_CR2_ITEVTEN) &&
+             ((sr1 & (I2C_SR1_SB | I2C_SR1_ADDR | I2C_SR1_BTF | I2C_SR1_STOPF)) ||
+              ((cr2 & I2C_CR2_ITBUFEN) && (sr1 & (I2C_SR1_TXE | I2C_SR1_RXNE)))))
+    {
+        i2cEventHandler(i2c, ctx);
+    }
+    else if (ctx->dma)
+    {
+        lisr = dmacGetLowInterruptStatus(DMA1);
+        if (lisr & (map->rxTcFlag | map->rxTeFlag))
+        {
+            i2cDmaRxHandler(i2c, ctx, lisr, map->rxTcFlag, map->rxTeFlag);
+        }
+    }
+}
+
+/**
+ * Queues the transfer with control priority and waits for its completion (bounded by the time budget).
+ * Called from an interrupt handler or with PRIMASK set, the I2C interrupts can't be taken: the
+ * transfer is done w/o DMA and the handlers are polled, incl. those of a transfer running before
+ * (its callback is called here). The bus may be recovered in this case even in an interrupt handler.
+ */
+static I2C_RETURN_CODE_t i2cRunBlocking(I2C_TypeDef *i2c, I2C_TRANSFER_t *xfer)
+{
+    I2C_CONTEXT_t    *ctx = i2cGetContext(i2c);
+    I2C_RETURN_CODE_t rc;
+    bool              polled = i2cInIsr() || (0 != __get_PRIMASK());
+
+    if (NULL == ctx)
+    {
+        return I2C_INVALID_TYPE;
+    }
+    if (polled)
+    {
+        xfer->useDma = false;
+        ctx->polling++;
+    }
+    // Control priority: queued background transfers are passed, a running one is waited for
+    rc = i2cQueueTransfer(i2c, xfer, I2C_PRIO_CONTROL);
+    while ((I2C_OK == rc) && (I2C_XFER_DONE != xfer->state))
+    {
+        if (polled)
+        {
+            i2cPollHandlers(i2c, ctx);
+        }
+        i2cCheckTimeout(i2c);
+    }
+    if (polled)
+    {
+        ctx->polling--;
+    }
+    if (I2C_OK != rc)
+    {
+        return rc;
+    }
+    if (!i2cIsBusBusy(i2c) && !I2C_STOPP_COMPLETED(i2c))    // Bus may already be handed to a queued transfer
+    {
+        i2cRecoverBus(i2c);
+        return I2C_TIMEOUT;
+    }
+    if ((I2C_BUS_ERROR == xfer->result) || (I2C_ARBITRATION_LOST == xfer->result))
+    {
+        i2cRecoverBus(i2c);
+    }
+    return xfer->result;
+}
+
+static I2C_RETURN_CODE_t i2cTransferBlocking(I2C_TypeDef *i2c, uint8_t saddr, const uint8_t *txBuf, uint16_t txLen,
+                                             uint8_t *rxBuf, uint16_t rxLen, bool useDma)
+{
+    I2C_TRANSFER_t xfer = { 0 };
+
+    xfer.saddr = saddr;
+    xfer.txBuf = txBuf;
+    xfer.txLen = txLen;
+    xfer.rxBuf = rxBuf;
+    xfer.rxLen = rxLen;
+    xfer.useDma = useDma;
+
+    return i2cRunBlocking(i2c, &xfer);
+}
+
+
+/**
+ * @ingroup iic3
+ * Executes a chain of segments back to back in one submission (scatter-gather transfer).
+ *
+ * @param  *i2c         : Pointer to the I2C component
+ * @param  *segments    : Segment list. Every segment starts with a (repeated) START and the address of
+ *                        its slave; the chain is terminated by a single STOP.
+ * @param   numSegments : Number of segments
+ * @param   useDma      : Segments with >= 2 bytes are transferred by DMA1
+ *
+ * @return I2C_RETURN_CODE_t
+ *
+ * @note
+ * A write segment flagged with I2C_SEG_NOSTART continues the preceding write to the same slave
+ * w/o START (gather, e.g. command byte and data from different buffers). Use i2cSubmitTransfer()
+ * with xfer->segments for the non-blocking variant.
+ */
+I2C_RETURN_CODE_t i2cTransfer(I2C_TypeDef *i2c, const I2C_SEGMENT_t *segments, uint8_t numSegments, bool useDma)
+{
+    I2C_TRANSFER_t xfer = { 0 };
+
+    xfer.segments    = segments;
+    xfer.numSegments = numSegments;
+    xfer.useDma      = useDma;
+
+    return i2cRunBlocking(i2c, &xfer);
+}
+
+/**
+ * @ingroup iic3
+ * Burst write data to I2C slave using DMA1.
+ *
+ * @param  *i2c      : Pointer to the component
+ * @param   saddr    : Address of the I2C slave 7Bit
+ * @param  *data     : Bytes that shall be sent (usually starting with the register address)
+ * @param   numBytes : Number of data elements to be sent
+ *
+ * @return I2C_RETURN_CODE_t
+ *
+ * @note
+ * Same as i2cBurstWrite(), but the data bytes are moved by the DMA. The CPU only handles
+ * START, address and STOP.
+ */
+I2C_RETURN_CODE_t i2cBurstWriteDMA(I2C_TypeDef *i2c, uint8_t saddr, uint8_t *data, uint8_t numBytes)
+{
+    return i2cTransferBlocking(i2c, saddr, data, numBytes, NULL, 0, true);
+}
+
+/**
+ * @ingroup iic3
+ * Burst read from I2C slave using DMA1.
+ *
+ * @param  *i2c     : Pointer to the component
+ * @param   saddr   : Address of the I2C slave
+ * @param   regAddr : Address of the first slave register
+ * @param  *data    : Address where the data shall be stored
+ * @param   num     : Number of data elements to be read
+ *
+ * @return I2C_RETURN_CODE_t
+ *
+ * @note
+ * Same as i2cBurstRegRead(). For num >= 2 the bytes are received by the DMA, the NACK of the
+ * last byte is generated by the I2C (LAST bit) and STOP is set in the DMA transfer complete interrupt.
+ */
+I2C_RETURN_CODE_t i2cBurstRegReadDMA(I2C_TypeDef *i2c, uint8_t saddr, uint8_t regAddr, uint8_t *data, uint8_t num)
+{
+    return i2cTransferBlocking(i2c, saddr, &regAddr, 1, data, num, true);
+}
+
+static void i2cDmaRxHandler(I2C_TypeDef *i2c, I2C_CONTEXT_t *ctx, uint32_t isr, uint32_t tcFlag, uint32_t teFlag)
+{
+    dmacClearAllStreamIrqFlags(DMA1, i2cGetDmaMap(ctx)->rxStream);
+    if (NULL == ctx->xfer)
+    {
+        return;
+    }
+    if (isr & teFlag)
+    {
+        i2c->CR1 |= I2C_CR1_STOP;
+        i2cCompleteTransfer(i2c, ctx, I2C_DMA_ERROR);
+    }
+    else if (isr & tcFlag)
+    {
+        i2cRxEndCondition(i2c, ctx);    // Last byte has already been NACKed
+        ctx->count = 0;
+        i2cRxSegmentFinished(i2c, ctx);
+    }
+}
+
+/**
+ * Interrupt handlers of the asynchronous transfer engine
+ */
+void I2C1_EV_IRQHandler(void)
+{
+    i2cEventHandler(I2C1, &i2cContext[0]);
+}
+
+void I2C1_ER_IRQHandler(void)
+{
+    i2cErrorHandler(I2C1, &i2cContext[0]);
+}
+
+void I2C2_EV_IRQHandler(void)
+{
+    i2cEventHandler(I2C2, &i2cContext[1]);
+}
+
+void I2C2_ER_IRQHandler(void)
+{
+    i2cErrorHandler(I2C2, &i2cContext[1]);
+}
+
+void I2C3_EV_IRQHandler(void)
+{
+    i2cEventHandler(I2C3, &i2cContext[2]);
+}
+
+void I2C3_ER_IRQHandler(void)
+{
+    i2cErrorHandler(I2C3, &i2cContext[2]);
+}
+
+void DMA1_Stream0_IRQHandler(void)
+{
+    i2cDmaRxHandler(I2C1, &i2cContext[0], dmacGetLowInterruptStatus(DMA1), DMA_LISR_TCIF0, DMA_LISR_TEIF0);
+}
+
+void DMA1_Stream2_IRQHandler(void)
+{
+    i2cDmaRxHandler(I2C2, &i2cContext[1], dmacGetLowInterruptStatus(DMA1), DMA_LISR_TCIF2, DMA_LISR_TEIF2);
+}
+
+void DMA1_Stream1_IRQHandler(void)
+{
+    i2cDmaRxHandler(I2C3, &i2cContext[2], dmacGetLowInterruptStatus(DMA1), DMA_LISR_TCIF1, DMA_LISR_TEIF1);
+}
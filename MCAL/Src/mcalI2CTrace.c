@@ -0,0 +1,400 @@
+/**
+ * @file        mcalI2CTrace.c
+ * @brief       Transaction trace of the I2C transfer engine (mcalI2C.c).
+ * @author      T Flaemig
+ * @date        Oct. 16, 2026
+ *
+ * Every transfer which is finished by the engine (successful, NACK, timeout, ...) is
+ * recorded by i2cTraceTransfer() with the DWT cycle counter at start and completion:
+ *
+ * - Ring buffer of the last I2C_TRACE_DEPTH transactions. Producers are the I2C/DMA interrupt
+ *   handlers, a slot is reserved with LDREX/STREX, so no interrupt lock is needed. The oldest
+ *   entries are overwritten, i2cTraceRead() (single consumer in the main loop) counts them as lost.
+ * - Latency histogram, min/max/mean and error count per slave (bus + address)
+ * - Busy time per bus for the utilization in percent
+ *
+ * The DWT cycle counter wraps after 2^32 cycles (51 s at 84 MHz), so the utilization
+ * window should be restarted regularly.
+ *
+ * @copyright   GNU Public License Version 3 (GPLv3)
+ */
+
+#include <stm32f4xx.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <mcalRCC.h>
+#include <mcalI2C.h>
+#include <mcalI2CTrace.h>
+
+
+static volatile bool         traceOn = false;        // Off until the application enables it
+static I2C_TRACE_ENTRY_t     traceBuf[I2C_TRACE_DEPTH];
+static volatile uint32_t     traceHead = 0;         // Next sequence number to be written
+static uint32_t              traceTail = 0;         // Next sequence number to be read
+static uint32_t              traceLost = 0;
+static I2C_TRACE_DEVICE_t    traceDev[I2C_TRACE_MAX_DEVICES];
+static volatile uint32_t     traceBusy[3];          // Busy cycles per bus since traceWinStart
+static uint32_t              traceWinStart[3];
+static uint32_t              traceCyclesPerUs = 16;
+
+
+static uint8_t i2cTraceBusNum(I2C_TypeDef *i2c)
+{
+    if (I2C1 == i2c)
+    {
+        return 1;
+    }
+    else if (I2C2 == i2c)
+    {
+        return 2;
+    }
+    else if (I2C3 == i2c)
+    {
+        return 3;
+    }
+    return 0;
+}
+
+/**
+ * Reserves the next slot of the ring buffer, safe against nested producers.
+ */
+static uint32_t i2cTraceReserve(void)
+{
+    uint32_t seq;
+
+    do
+    {
+        seq = __LDREXW((volatile uint32_t *) &traceHead);
+    } while (__STREXW(seq + 1, (volatile uint32_t *) &traceHead) != 0);
+
+    return seq;
+}
+
+static I2C_TRACE_DEVICE_t *i2cTraceFindDevice(uint8_t bus, uint8_t saddr)
+{
+    uint8_t i;
+
+    for (i = 0; i < I2C_TRACE_MAX_DEVICES; i++)
+    {
+        if ((traceDev[i].bus == bus) && (traceDev[i].saddr == saddr))
+        {
+            return &traceDev[i];
+        }
+        if (0 == traceDev[i].bus)
+        {
+            traceDev[i].bus       = bus;
+            traceDev[i].saddr     = saddr;
+            traceDev[i].minCycles = 0xFFFFFFFFUL;
+            return &traceDev[i];
+        }
+    }
+    return NULL;                        // Table full: only the ring buffer records the slave
+}
+
+
+/**
+ * @ingroup iic3
+ * Takes the cycles per microsecond of the timestamps from HCLK. Called by i2cInitI2C(),
+ * it does not change the recording state.
+ */
+void i2cTraceSetClock(void)
+{
+    traceCyclesPerUs = rccGetHclkFreq() / 1000000;
+    if (0 == traceCyclesPerUs)
+    {
+        traceCyclesPerUs = 1;
+    }
+}
+
+/**
+ * @ingroup iic3
+ * Switches the recording on or off. It is off after reset, so the completion interrupt
+ * only pays for the trace if the application asks for it.
+ */
+void i2cTraceEnable(bool enable)
+{
+    i2cTraceSetClock();
+    traceOn = enable;
+}
+
+/**
+ * @ingroup iic3
+ * Clears the ring buffer, the statistics and restarts the utilization windows.
+ */
+void i2cTraceReset(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint8_t  i, b;
+
+    __disable_irq();
+    traceTail = traceHead;
+    traceLost = 0;
+    for (i = 0; i < I2C_TRACE_MAX_DEVICES; i++)
+    {
+        traceDev[i].bus       = 0;
+        traceDev[i].count     = 0;
+        traceDev[i].errors    = 0;
+        traceDev[i].maxCycles = 0;
+        traceDev[i].sumCycles = 0;
+        for (b = 0; b < I2C_TRACE_HIST_BINS; b++)
+        {
+            traceDev[i].hist[b] = 0;
+        }
+    }
+    for (i = 0; i < 3; i++)
+    {
+        traceBusy[i]     = 0;
+        traceWinStart[i] = DWT->CYCCNT;
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @ingroup iic3
+ * Hook of the transfer engine, called on completion of every transfer (interrupt context).
+ *
+ * @param  *i2c        : Pointer to the I2C component
+ * @param  *seg        : Segments of the transfer
+ * @param   numSegments: Number of segments
+ * @param   result     : Result of the transfer
+ * @param   tStart     : DWT->CYCCNT at the start
+ * @param   tEnd       : DWT->CYCCNT at the completion
+ */
+void i2cTraceTransfer(I2C_TypeDef *i2c, const I2C_SEGMENT_t *seg, uint8_t numSegments,
+                      I2C_RETURN_CODE_t result, uint32_t tStart, uint32_t tEnd)
+{
+    I2C_TRACE_ENTRY_t  *e;
+    I2C_TRACE_DEVICE_t *dev;
+    uint32_t            seq, cycles, limit, primask;
+    uint16_t            len = 0;
+    int16_t             reg = -1;
+    uint8_t             bus = i2cTraceBusNum(i2c);
+    uint8_t             i, bin;
+
+    if (!traceOn || (0 == bus) || (NULL == seg) || (0 == numSegments))
+    {
+        return;
+    }
+    for (i = 0; i < numSegments; i++)
+    {
+        len += seg[i].len;
+        if ((-1 == reg) && (I2C_SEG_WRITE == seg[i].dir) && (seg[i].len > 0))
+        {
+            reg = seg[i].buf[0];
+        }
+    }
+    cycles = tEnd - tStart;
+
+    // Ring buffer: the sequence number is written last and marks the entry as valid
+    seq = i2cTraceReserve();
+    e   = &traceBuf[seq & (I2C_TRACE_DEPTH - 1)];
+    e->seq         = ~seq;
+    e->tStart      = tStart;
+    e->tEnd        = tEnd;
+    e->len         = len;
+    e->reg         = reg;
+    e->bus         = bus;
+    e->saddr       = seg[0].saddr;
+    e->numSegments = numSegments;
+    e->result      = (int8_t) result;
+    __DMB();
+    e->seq         = seq;
+
+    // Statistics are updated by the interrupt handlers of all buses
+    primask = __get_PRIMASK();
+    __disable_irq();
+    traceBusy[bus - 1] += cycles;
+    dev = i2cTraceFindDevice(bus, seg[0].saddr);
+    if (NULL != dev)
+    {
+        dev->count++;
+        if (I2C_OK != result)
+        {
+            dev->errors++;
+        }
+        if (cycles < dev->minCycles)
+        {
+            dev->minCycles = cycles;
+        }
+        if (cycles > dev->maxCycles)
+        {
+            dev->maxCycles = cycles;
+        }
+        dev->sumCycles += cycles;
+
+        limit = I2C_TRACE_HIST_BASE_US * traceCyclesPerUs;
+        for (bin = 0; (bin < I2C_TRACE_HIST_BINS - 1) && (cycles >= limit); bin++)
+        {
+            limit <<= 1;
+        }
+        dev->hist[bin]++;
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @ingroup iic3
+ * Reads the oldest unread transaction.
+ *
+ * @return false if no entry is available
+ *
+ * @note
+ * Only one consumer is allowed (main loop). Overwritten entries are skipped and counted,
+ * see i2cTraceLost().
+ */
+bool i2cTraceRead(I2C_TRACE_ENTRY_t *entry)
+{
+    I2C_TRACE_ENTRY_t *e;
+    uint32_t           head;
+
+    while (1)
+    {
+        head = traceHead;
+        if (traceTail == head)
+        {
+            return false;
+        }
+        if ((head - traceTail) > I2C_TRACE_DEPTH)
+        {
+            traceLost += head - traceTail - I2C_TRACE_DEPTH;
+            traceTail  = head - I2C_TRACE_DEPTH;
+        }
+        e = &traceBuf[traceTail & (I2C_TRACE_DEPTH - 1)];
+        if (e->seq != traceTail)
+        {
+            if (e->seq == ~traceTail)
+            {
+                return false;           // Producer still writing this entry
+            }
+            traceLost++;                // Already overwritten
+            traceTail++;
+            continue;
+        }
+        *entry = *e;
+        __DMB();
+        if (e->seq != traceTail)
+        {
+            traceLost++;                // Overwritten while copying
+            traceTail++;
+            continue;
+        }
+        traceTail++;
+        return true;
+    }
+}
+
+/**
+ * @ingroup iic3
+ * Returns the number of transactions which have been overwritten before they were read.
+ */
+uint32_t i2cTraceLost(void)
+{
+    return traceLost;
+}
+
+/**
+ * @ingroup iic3
+ * Returns the statistics of the slave with index idx, NULL if idx is not used.
+ */
+const I2C_TRACE_DEVICE_t *i2cTraceGetDevice(uint8_t idx)
+{
+    if ((idx >= I2C_TRACE_MAX_DEVICES) || (0 == traceDev[idx].bus))
+    {
+        return NULL;
+    }
+    return &traceDev[idx];
+}
+
+/**
+ * @ingroup iic3
+ * Returns the share of the time in percent in which the bus was occupied by transfers.
+ *
+ * @param  *i2c    : Pointer to the I2C component
+ * @param   restart: Start a new measurement window
+ */
+uint8_t i2cTraceBusUtilization(I2C_TypeDef *i2c, bool restart)
+{
+    uint8_t  bus = i2cTraceBusNum(i2c);
+    uint32_t now = DWT->CYCCNT;
+    uint32_t window, busy;
+
+    if (0 == bus)
+    {
+        return 0;
+    }
+    window = now - traceWinStart[bus - 1];
+    busy   = traceBusy[bus - 1];
+    if (restart)
+    {
+        traceBusy[bus - 1]     = 0;
+        traceWinStart[bus - 1] = now;
+    }
+    if ((0 == window) || (busy >= window))
+    {
+        return (0 == window) ? 0 : 100;
+    }
+    return (uint8_t) (((uint64_t) busy * 100) / window);
+}
+
+/**
+ * @ingroup iic3
+ * Converts DWT cycles into microseconds.
+ */
+uint32_t i2cTraceCyclesToUs(uint32_t cycles)
+{
+    return cycles / traceCyclesPerUs;
+}
+
+/**
+ * @ingroup iic3
+ * Writes all unread transactions, the statistics per slave and the bus utilization
+ * line by line to out, e.g. a function sending the line via USART.
+ */
+void i2cTraceDump(I2C_TRACE_OUT_t out)
+{
+    I2C_TRACE_ENTRY_t         e;
+    const I2C_TRACE_DEVICE_t *dev;
+    char                      line[96];
+    uint8_t                   i, b;
+    int                       n;
+
+    if (NULL == out)
+    {
+        return;
+    }
+
+    out("seq bus addr reg len seg result us");
+    while (i2cTraceRead(&e))
+    {
+        snprintf(line, sizeof(line), "%lu I2C%u 0x%02X %d %u %u %d %lu",
+                 (unsigned long) e.seq, e.bus, e.saddr, e.reg, e.len, e.numSegments, e.result,
+                 (unsigned long) i2cTraceCyclesToUs(e.tEnd - e.tStart));
+        out(line);
+    }
+    snprintf(line, sizeof(line), "lost %lu", (unsigned long) traceLost);
+    out(line);
+
+    for (i = 0; (dev = i2cTraceGetDevice(i)) != NULL; i++)
+    {
+        snprintf(line, sizeof(line), "I2C%u 0x%02X n %lu err %lu min %lu max %lu mean %lu us",
+                 dev->bus, dev->saddr, (unsigned long) dev->count, (unsigned long) dev->errors,
+                 (unsigned long) i2cTraceCyclesToUs((dev->count > 0) ? dev->minCycles : 0),
+                 (unsigned long) i2cTraceCyclesToUs(dev->maxCycles),
+                 (unsigned long) ((dev->count > 0) ? i2cTraceCyclesToUs((uint32_t) (dev->sumCycles / dev->count)) : 0));
+        out(line);
+
+        n = snprintf(line, sizeof(line), "  hist");
+        for (b = 0; (b < I2C_TRACE_HIST_BINS) && (n > 0) && (n < (int) sizeof(line)); b++)
+        {
+            n += snprintf(&line[n], sizeof(line) - n, (b < I2C_TRACE_HIST_BINS - 1) ? " <%u:%lu" : " >=%u:%lu",
+                          I2C_TRACE_HIST_BASE_US << ((b < I2C_TRACE_HIST_BINS - 1) ? b : (b - 1)),
+                          (unsigned long) dev->hist[b]);
+        }
+        out(line);
+    }
+
+    snprintf(line, sizeof(line), "busy I2C1 %u%% I2C2 %u%% I2C3 %u%%",
+             i2cTraceBusUtilization(I2C1, false), i2cTraceBusUtilization(I2C2, false),
+             i2cTraceBusUtilization(I2C3, false));
+    out(line);
+}
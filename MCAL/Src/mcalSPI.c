@@ -31,7 +31,9 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stddef.h>
 #include <mcalGPIO.h>
+#include <mcalDMAC.h>
 #include <mcalSPI.h>
 
 
@@ -66,6 +68,27 @@ static inline void __spi_ClearRX(SPI_TypeDef *spi)
 	while (spi -> SR & SPI_SR_RXNE)	{b = spi->DR;}
 }
 */
+/**
+ * DMA streams of the SPI transmit requests (RM0368, table 28)
+ *
+ * SPI2 TX shares DMA1_Stream4 with I2C3 TX (channel 3, see i2cDmaMap in mcalI2C.c).
+ * spiWriteDMA() sends polled while the stream is enabled for another channel.
+ */
+typedef struct
+{
+    DMA_TypeDef        *dmac;
+    DMA_Stream_TypeDef *txStream;
+    DMAC_CHANNEL_t      txChn;
+} SPI_DMA_MAP_t;
+
+static const SPI_DMA_MAP_t spiDmaMap[4] =
+{
+    { DMA2, DMA2_Stream3, DMA_CHN_3 },  // SPI1
+    { DMA1, DMA1_Stream4, DMA_CHN_0 },  // SPI2, shared with I2C3 TX
+    { DMA1, DMA1_Stream5, DMA_CHN_0 },  // SPI3
+    { DMA2, DMA2_Stream1, DMA_CHN_4 }   // SPI4
+};
+
 /**
  * Verifies the integrity of the SPI port.
  */
@@ -670,14 +693,344 @@ void spiClearInterruptType(SPI_TypeDef *spi, uint8_t interruptType)
 
 }
 
+
+/**
+ * @ingroup spi2
+ * Enables the DMA requests of the SPI
+ *
+ * @param  *spi     : Pointer to the SPI
+ * @param   dmaType : RX_DMA_EN and/or TX_DMA_EN
+ */
 void spiEnableDmaType(SPI_TypeDef *spi, uint8_t dmaType)
 {
-
+    spi->CR2 |= (dmaType & (RX_DMA_EN | TX_DMA_EN));
 }
 
+/**
+ * @ingroup spi2
+ * Disables the DMA requests of the SPI
+ *
+ * @param  *spi     : Pointer to the SPI
+ * @param   dmaType : RX_DMA_EN and/or TX_DMA_EN
+ */
 void spiDisableDmaType(SPI_TypeDef *spi, uint8_t dmaType)
 {
+    spi->CR2 &= ~(dmaType & (RX_DMA_EN | TX_DMA_EN));
+}
+
 
+static const SPI_DMA_MAP_t *spiGetDmaMap(SPI_TypeDef *spi)
+{
+    if (SPI1 == spi)
+    {
+        return &spiDmaMap[0];
+    }
+    if (SPI2 == spi)
+    {
+        return &spiDmaMap[1];
+    }
+    if (SPI3 == spi)
+    {
+        return &spiDmaMap[2];
+    }
+    if (SPI4 == spi)
+    {
+        return &spiDmaMap[3];
+    }
+    return NULL;
+}
+
+/**
+ * @ingroup spi2
+ * Changes the frame format (DFF) between two transfers. DFF may only be written with SPE = 0,
+ * therefore the function waits until the last frame has left the shift register.
+ *
+ * @param  *spi : Pointer to the SPI
+ * @param   len : SPI_DATA_8_BIT or SPI_DATA_16_BIT
+ * @return SPI_RETURN_CODE_t
+ */
+SPI_RETURN_CODE_t spiSwitchDataLen(SPI_TypeDef *spi, SPI_DATALEN_t len)
+{
+    uint32_t spe;
+
+    if ((SPI_DATA_8_BIT != len) && (SPI_DATA_16_BIT != len))
+    {
+        return SPI_INVALID_DATA_LENGTH;
+    }
+    if ((SPI_DATA_16_BIT == len) == ((spi->CR1 & SPI_CR1_DFF) != 0))
+    {
+        return SPI_OK;                              // Nothing to do
+    }
+
+    while (!(spi->SR & SPI_SR_TXE))
+    {
+        ;
+    }
+    __spi_Chk_notBSY(spi);
+
+    spe = spi->CR1 & SPI_CR1_SPE;
+    spi->CR1 &= ~SPI_CR1_SPE_Msk;
+    spiSetDataLen(spi, len);
+    spi->CR1 |= spe;
+
+    return SPI_OK;
+}
+
+/**
+ * @ingroup spi2
+ * Starts a session: selects the frame format and asserts CS. Up to spiEndSession() the
+ * frames are written back-to-back without CS toggling and without waiting for BSY.
+ *
+ * @param  *spi  : Pointer to the SPI
+ * @param  *port : Port of the CS pin
+ * @param   pin  : CS pin
+ * @param   len  : SPI_DATA_8_BIT or SPI_DATA_16_BIT, can be changed with spiSwitchDataLen()
+ * @return SPI_RETURN_CODE_t
+ */
+SPI_RETURN_CODE_t spiBeginSession(SPI_TypeDef *spi, GPIO_TypeDef *port, PIN_NUM_t pin, SPI_DATALEN_t len)
+{
+    SPI_RETURN_CODE_t rc;
+
+    if (spiVerifySPI(spi) != true)
+    {
+        return SPI_INVALID_SPI;
+    }
+    if (gpioVerifyPin(pin) != true)
+    {
+        return GPIO_INVALID_PIN;
+    }
+    rc = spiSwitchDataLen(spi, len);
+    if (SPI_OK != rc)
+    {
+        return rc;
+    }
+
+    gpioResetPin(port, pin);                            // Set CS input to low level
+    return SPI_OK;
+}
+
+/**
+ * @ingroup spi2
+ * Writes one 8-bit frame of a session as soon as the TX buffer is empty
+ */
+void spiSessionWrite8(SPI_TypeDef *spi, uint8_t data)
+{
+    while (!(spi->SR & SPI_SR_TXE))
+    {
+        ;
+    }
+    spi->DR = data;
+}
+
+/**
+ * @ingroup spi2
+ * Writes one 16-bit frame of a session (DFF = 1) as soon as the TX buffer is empty
+ */
+void spiSessionWrite16(SPI_TypeDef *spi, uint16_t data)
+{
+    while (!(spi->SR & SPI_SR_TXE))
+    {
+        ;
+    }
+    spi->DR = data;
+}
+
+/**
+ * @ingroup spi2
+ * Writes num frames of a session in the current frame format: bytes for 8 bit, half-words
+ * for 16 bit
+ */
+void spiSessionWrite(SPI_TypeDef *spi, const void *data, uint16_t num)
+{
+    if (spi->CR1 & SPI_CR1_DFF)
+    {
+        const uint16_t *frame = data;
+
+        while (num--)
+        {
+            spiSessionWrite16(spi, *frame++);
+        }
+    }
+    else
+    {
+        const uint8_t *frame = data;
+
+        while (num--)
+        {
+            spiSessionWrite8(spi, *frame++);
+        }
+    }
+}
+
+/**
+ * @ingroup spi2
+ * Waits until all frames written so far have left the shift register (TXE = 1, BSY = 0), e.g.
+ * before a DATA/COMMAND pin of the slave is changed within the session.
+ */
+void spiSessionFlush(SPI_TypeDef *spi)
+{
+    while (!(spi->SR & SPI_SR_TXE))
+    {
+        ;
+    }
+    __spi_Chk_notBSY(spi);
+}
+
+/**
+ * @ingroup spi2
+ * Ends a session: waits for the last frame, releases CS and clears RXNE/OVR of the
+ * unread receive path.
+ *
+ * @param  *spi  : Pointer to the SPI
+ * @param  *port : Port of the CS pin
+ * @param   pin  : CS pin
+ * @return SPI_RETURN_CODE_t
+ */
+SPI_RETURN_CODE_t spiEndSession(SPI_TypeDef *spi, GPIO_TypeDef *port, PIN_NUM_t pin)
+{
+    if (gpioVerifyPin(pin) != true)
+    {
+        return GPIO_INVALID_PIN;
+    }
+
+    spiSessionFlush(spi);
+    gpioSetPin(port, pin);
+    (void) spi->DR;                                     // Reading DR, then SR clears OVR
+    (void) spi->SR;
+
+    return SPI_OK;
+}
+
+/**
+ * @ingroup spi2
+ * Starts a DMA transmission of num frames and returns immediately. The frame format is
+ * switched to len, the DMA moves bytes (8 bit) or half-words (16 bit) to DR. With
+ * memIncr = false the same frame is sent num times (e.g. a fill colour).
+ * The received data is discarded. The caller asserts CS before and releases it after
+ * spiWaitDMA(); the buffer must stay valid until then.
+ * If the stream is occupied by another peripheral (SPI2 and I2C3 share DMA1_Stream4),
+ * the frames are sent polled and the function returns after the last frame.
+ *
+ * @param  *spi     : Pointer to the SPI
+ * @param  *data    : Source buffer (num frames) or the single frame for memIncr = false
+ * @param   num     : Number of frames, 1 ... 65535
+ * @param   len     : SPI_DATA_8_BIT or SPI_DATA_16_BIT
+ * @param   memIncr : true: buffer, false: fixed memory address
+ * @return SPI_RETURN_CODE_t
+ */
+SPI_RETURN_CODE_t spiWriteDMA(SPI_TypeDef *spi, const void *data, uint16_t num, SPI_DATALEN_t len, bool memIncr)
+{
+    const SPI_DMA_MAP_t *map = spiGetDmaMap(spi);
+    DMA_Stream_TypeDef  *stream;
+    DMAC_DATA_FORMAT_t   format = (SPI_DATA_16_BIT == len) ? HALFWORD : BYTE;
+    SPI_RETURN_CODE_t    rc;
+    uint32_t             primask;
+
+    if (NULL == map)
+    {
+        return SPI_INVALID_SPI;
+    }
+    if (0 == num)
+    {
+        return SPI_INVALID_DATA_LENGTH;
+    }
+    if (spiIsDMABusy(spi))
+    {
+        return SPI_DMA_BUSY;
+    }
+    rc = spiSwitchDataLen(spi, len);
+    if (SPI_OK != rc)
+    {
+        return rc;
+    }
+
+    stream = map->txStream;
+    dmacSelectDMAC(map->dmac);
+
+    // SPI2 shares the stream with I2C3, whose interrupt may claim it: check and program in one step
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if ((stream->CR & DMA_SxCR_EN) && ((stream->CR & DMA_SxCR_CHSEL_Msk) != (map->txChn << DMA_SxCR_CHSEL_Pos)))
+    {
+        __set_PRIMASK(primask);
+        if (memIncr)
+        {
+            spiSessionWrite(spi, data, num);
+        }
+        else
+        {
+            while (num--)
+            {
+                spiSessionWrite(spi, data, 1);
+            }
+        }
+        spiSessionFlush(spi);
+        return SPI_OK;
+    }
+    dmacDisableStream(stream);
+    dmacAssignStreamAndChannel(stream, map->txChn);    // Must be the first setting, it overwrites CR
+    dmacClearAllStreamIrqFlags(map->dmac, stream);
+    dmacSetMemoryAddress(stream, MEM_0, (uint32_t) data);
+    dmacSetPeripheralAddress(stream, (uint32_t) &spi->DR);
+    dmacSetNumData(stream, num);
+    dmacSetDataFlowDirection(stream, MEM_2_PER);
+    dmacSetMemoryIncrementMode(stream, memIncr ? INCR_ENABLE : INCR_DISABLE);
+    dmacSetPeripheralIncrementMode(stream, INCR_DISABLE);
+    dmacSetMemoryDataFormat(stream, format);
+    dmacSetPeripheralDataFormat(stream, format);
+    dmacSetPriorityLevel(stream, PRIO_MEDIUM);
+    dmacEnableStream(stream);
+    __set_PRIMASK(primask);
+
+    spi->CR2 |= SPI_CR2_TXDMAEN;                        // TXE = 1: the first request starts the transfer
+
+    return SPI_OK;
+}
+
+/**
+ * @ingroup spi2
+ * Returns true as long as a DMA transmission started by spiWriteDMA() is running, i.e. the
+ * stream is enabled or the last frame is still being shifted out.
+ *
+ * @param  *spi : Pointer to the SPI
+ */
+bool spiIsDMABusy(SPI_TypeDef *spi)
+{
+    const SPI_DMA_MAP_t *map = spiGetDmaMap(spi);
+
+    if ((NULL == map) || !(spi->CR2 & SPI_CR2_TXDMAEN))
+    {
+        return false;
+    }
+    return (map->txStream->CR & DMA_SxCR_EN) || !(spi->SR & SPI_SR_TXE) || (spi->SR & SPI_SR_BSY);
+}
+
+/**
+ * @ingroup spi2
+ * Waits for the end of the DMA transmission (stream done, TXE = 1, BSY = 0), disables the
+ * TX DMA request and clears RXNE/OVR of the unread receive path. CS may be released afterwards.
+ *
+ * @param  *spi : Pointer to the SPI
+ * @return SPI_RETURN_CODE_t
+ */
+SPI_RETURN_CODE_t spiWaitDMA(SPI_TypeDef *spi)
+{
+    const SPI_DMA_MAP_t *map = spiGetDmaMap(spi);
+
+    if (NULL == map)
+    {
+        return SPI_INVALID_SPI;
+    }
+
+    while (spiIsDMABusy(spi))
+    {
+        ;
+    }
+    spi->CR2 &= ~SPI_CR2_TXDMAEN_Msk;
+    (void) spi->DR;                                     // Reading DR, then SR clears OVR
+    (void) spi->SR;
+
+    return SPI_OK;
 }
 
 
@@ -408,40 +408,24 @@ void initSubMenu(SCREEN_PAGES_t page, TOFSensor_t* TOFSENS)
  */
 void i2cScanAndInit(TOFSensor_t *TOFSENS) //
 {
-	static uint8_t scanAddr = (uint8_t)I2C_MAXADRESS;			// scan I2C address
-	uint8_t scanResult;
+	uint8_t scanAddr;
+	uint8_t presence[I2C_SCAN_MAP_SIZE];
 	bool InitResult;
 	I2C_TypeDef *i2c ;
 	i2c = TOFSENS->i2c_tof;
-	scanResult =I2C_SCAN(i2c, scanAddr);
-	if (scanResult != 0)
-	{
-		// check if known sensor is found
-/*
-		if (I2C_SCAN(scanAddr, i2c) == i2cAddr_Sensor[SENSOR_BMA020])
-		{
-			currentSensor = SENSOR_BMA020;
-			visualisationSensorRecognized(VISUALISATION_BMA020);
 
-			enable3DGSensor = true;
-		}
-		else if (I2C_SCAN(scanAddr, i2c)== i2cAddr_Sensor[SENSOR_MPU6050])
-		{
-			currentSensor = SENSOR_MPU6050;
-			visualisationSensorRecognized(VISUALISATION_MPU6050);
+	// all i2c addresses in a single pass, missing slaves are detected by the ACK failure
+	i2cScanBus(i2c, NULL, 0, presence);
+	I2C_SCAN_SHOW(i2c, 0, 0);							// list of the found addresses from the top
 
-			enable3DGSensor = true;
-		}
-		else if (I2C_SCAN(scanAddr, i2c) == i2cAddr_Sensor[SENSOR_LIS3DH])
+	for (scanAddr = I2C_MAXADRESS; scanAddr > 0; scanAddr--)
+	{
+		if (!I2C_SCAN_PRESENT(presence, scanAddr))
 		{
-			currentSensor = SENSOR_LIS3DH;
-			visualisationSensorRecognized(VISUALISATION_LIS3DH);
-
-			enable3DGSensor = true;
+			continue;
 		}
-
-		else		*/
-		if(scanResult == TOF_ADDR_VL53LOX)
+		I2C_SCAN_SHOW(i2c, scanAddr, scanAddr);
+		if(scanAddr == TOF_ADDR_VL53LOX)
 		{
 			TOF_sensor_used = TOF_ADDR_VL53LOX;
 			visualisationSensorRecognized(VISUALISATION_VL53LOX);
@@ -453,27 +437,17 @@ void i2cScanAndInit(TOFSensor_t *TOFSENS) //
 			// show that an unknown sensor was found
 			visualisationSensorRecognized(VISUALISATION_UNKNOWN);
 		}
-
-
 	}
-	// check if all i2c addresses are searched
-	if (scanAddr <= 0)
-	{
-		visualisationI2CScanDone(i2cInitAttempts);
 
-		i2cInitAttempts -= 1;
-		scanAddr = I2C_MAXADRESS;
+	// all i2c addresses are searched
+	visualisationI2CScanDone(i2cInitAttempts);
 
-		if(i2cInitAttempts < 1)
-		{
-			exitMenu = EXIT_FROMSUB1;
-			i2cInitAttempts = I2C_MAXATTEMPTS;
-		}
-	}
-	// otherwise decrement scan address and search next i2c address
-	else
+	i2cInitAttempts -= 1;
+
+	if(i2cInitAttempts < 1)
 	{
-		scanAddr -= 1;
+		exitMenu = EXIT_FROMSUB1;
+		i2cInitAttempts = I2C_MAXATTEMPTS;
 	}
 
 	// initialize TOF sensor if one is found
@@ -507,7 +481,6 @@ void i2cScanAndInit(TOFSensor_t *TOFSENS) //
 		exitMenu = EXIT_FALSE;
 		visualisationI2C2();
 
-		scanAddr = I2C_MAXADRESS;
 		i2cInitPort = I2C_2;
 
 	}
@@ -399,33 +399,50 @@ void initSubMenu(SCREEN_PAGES_t page, TOFSensor_t* TOFSENS)
  */
 void i2cScanAndInit(TOFSensor_t* TOFSENS, I2C_TypeDef   *i2c)
 {
+	uint8_t presence[I2C_SCAN_MAP_SIZE];
+	uint8_t yAddr = 50;							// found addresses one per line from POS_SCREEN_LINE_4_R
+
 	i2c = TOFSENS->i2c_tof;
 
-	if (I2C_SCAN(scanAddr, i2c) != 0)
+	// all i2c addresses in a single pass, missing slaves are detected by the ACK failure
+	i2cScanBus(i2c, NULL, 0, presence);
+
+	for (scanAddr = I2C_MAXADRESS; scanAddr > 0; scanAddr--)
 	{
+		if (!I2C_SCAN_PRESENT(presence, scanAddr))
+		{
+			continue;
+		}
+		tftPrint((char*) convDecByteToHex(scanAddr), tftGetWidth()/2, yAddr, 0);
+		yAddr += 10;
+		if (yAddr > tftGetHeight() - 10)
+		{
+			yAddr = 50;
+		}
+
 		// check if known sensor is found
-		if (I2C_SCAN(scanAddr, i2c) == i2cAddr_Sensor[SENSOR_BMA020])
+		if (scanAddr == i2cAddr_Sensor[SENSOR_BMA020])
 		{
 			currentSensor = SENSOR_BMA020;
 			visualisationSensorRecognized(VISUALISATION_BMA020);
 
 			enable3DGSensor = true;
 		}
-		else if (I2C_SCAN(scanAddr, i2c)== i2cAddr_Sensor[SENSOR_MPU6050])
+		else if (scanAddr == i2cAddr_Sensor[SENSOR_MPU6050])
 		{
 			currentSensor = SENSOR_MPU6050;
 			visualisationSensorRecognized(VISUALISATION_MPU6050);
 
 			enable3DGSensor = true;
 		}
-		else if (I2C_SCAN(scanAddr, i2c) == i2cAddr_Sensor[SENSOR_LIS3DH])
+		else if (scanAddr == i2cAddr_Sensor[SENSOR_LIS3DH])
 		{
 			currentSensor = SENSOR_LIS3DH;
 			visualisationSensorRecognized(VISUALISATION_LIS3DH);
 
 			enable3DGSensor = true;
 		}
-		else if(I2C_SCAN(scanAddr, i2c) == TOF_ADDR_VL53LOX)
+		else if(scanAddr == TOF_ADDR_VL53LOX)
 		{
 			TOF_sensor_used = TOF_ADDR_VL53LOX;
 			visualisationSensorRecognized(VISUALISATION_VL53LOX);
@@ -437,27 +454,18 @@ void i2cScanAndInit(TOFSensor_t* TOFSENS, I2C_TypeDef   *i2c)
 			// show that an unknown sensor was found
 			visualisationSensorRecognized(VISUALISATION_UNKNOWN);
 		}
-
 	}
 
-	// check if all i2c addresses are searched
-	if (scanAddr <= 0)
-	{
-		visualisationI2CScanDone(i2cInitAttempts);
+	// all i2c addresses are searched
+	visualisationI2CScanDone(i2cInitAttempts);
 
-		i2cInitAttempts -= 1;
-		scanAddr = I2C_MAXADRESS;
+	i2cInitAttempts -= 1;
+	scanAddr = I2C_MAXADRESS;
 
-		if(i2cInitAttempts < 1)
-		{
-			exitMenu = EXIT_FROMSUB1;
-			i2cInitAttempts = I2C_MAXATTEMPTS;
-		}
-	}
-	// otherwise decrement scan address and search next i2c address
-	else
+	if(i2cInitAttempts < 1)
 	{
-		scanAddr -= 1;
+		exitMenu = EXIT_FROMSUB1;
+		i2cInitAttempts = I2C_MAXATTEMPTS;
 	}
 
 	// initialize TOF sensor if one is found